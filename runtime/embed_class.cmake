@@ -0,0 +1,10 @@
+# Writes the class file INPUT into OUTPUT as a C++ byte array named SYMBOL.
+# Usage: cmake -DINPUT=<file.class> -DOUTPUT=<header.h> -DSYMBOL=<name> -P embed_class.cmake
+
+file(READ "${INPUT}" class_hex HEX)
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," class_bytes "${class_hex}")
+get_filename_component(class_name "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+	"#pragma once\n\n"
+	"// Generated from ${class_name} by embed_class.cmake - do not edit.\n"
+	"inline constexpr unsigned char ${SYMBOL}[] = {${class_bytes}};\n")
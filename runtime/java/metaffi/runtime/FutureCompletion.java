@@ -0,0 +1,35 @@
+package metaffi.runtime;
+
+import java.util.concurrent.CompletionException;
+import java.util.function.BiConsumer;
+
+/**
+ * Bootstrap helper defined by the JVM runtime plugin at load (see jni_futures.h).
+ * Registered with CompletionStage.whenComplete by jvm_runtime_xcall_future; when the stage
+ * completes it hands the value or the failure to the plugin through a native method, so no
+ * thread waits on the future.
+ *
+ * token identifies the pending host call inside the plugin and is completed exactly once.
+ */
+final class FutureCompletion implements BiConsumer<Object, Throwable>
+{
+	private final long token;
+
+	FutureCompletion(long token)
+	{
+		this.token = token;
+	}
+
+	@Override
+	public void accept(Object value, Throwable error)
+	{
+		// dependent stages report the failure of their source wrapped in CompletionException
+		if(error instanceof CompletionException && error.getCause() != null)
+		{
+			error = error.getCause();
+		}
+		complete(token, value, error);
+	}
+
+	private static native void complete(long token, Object value, Throwable error);
+}
@@ -0,0 +1,61 @@
+package metaffi.runtime;
+
+/**
+ * Bootstrap helper defined by the JVM runtime plugin at load (see jni_strings.h).
+ * Moves a whole String[] across JNI as one packed char[] plus a table of end offsets,
+ * instead of one JNI call per element.
+ *
+ * ends[i] is the offset in chars where string i ends; a null element is encoded as ~end,
+ * with end equal to the end of the previous element.
+ */
+final class StringArrays
+{
+	private StringArrays()
+	{
+	}
+
+	static String[] split(char[] chars, int[] ends)
+	{
+		String[] result = new String[ends.length];
+		int start = 0;
+		for(int i = 0; i < ends.length; i++)
+		{
+			int end = ends[i];
+			if(end < 0)
+			{
+				continue;
+			}
+			result[i] = new String(chars, start, end - start);
+			start = end;
+		}
+		return result;
+	}
+
+	static char[] join(String[] strings, int[] ends)
+	{
+		int total = 0;
+		for(String s : strings)
+		{
+			if(s != null)
+			{
+				total = Math.addExact(total, s.length());
+			}
+		}
+
+		char[] chars = new char[total];
+		int pos = 0;
+		for(int i = 0; i < strings.length; i++)
+		{
+			String s = strings[i];
+			if(s == null)
+			{
+				ends[i] = ~pos;
+				continue;
+			}
+			s.getChars(0, s.length(), chars, pos);
+			pos += s.length();
+			ends[i] = pos;
+		}
+		return chars;
+	}
+}
@@ -0,0 +1,142 @@
+#include "jni_array_cache.h"
+#include "jni_symbols.h"
+
+#include <runtime_manager/jvm/jni_helpers.h>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct cache_entry
+    {
+        jclass cls = nullptr; // global ref
+        array_class_info info;
+    };
+
+    // array types returned without fixed_dimensions are few, so entries are told apart with
+    // IsSameObject; hashing the class would take an upcall to Object.hashCode per lookup
+    std::vector<cache_entry> g_entries;
+    std::shared_mutex g_entries_mutex;
+
+    // bounds the linear scan; past this new classes are resolved on every return
+    constexpr size_t max_entries = 64;
+
+    std::atomic<uint64_t> g_hits{0};
+    std::atomic<uint64_t> g_misses{0};
+
+    bool find_entry(JNIEnv* env, jclass cls, array_class_info& out)
+    {
+        for(const auto& entry : g_entries)
+        {
+            if(env->IsSameObject(entry.cls, cls) == JNI_TRUE)
+            {
+                out = entry.info;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // "[[I" -> {2}, "[Ljava.lang.String;" -> {1}
+    array_class_info parse_array_class_name(const char* name)
+    {
+        array_class_info info;
+        for(const char* c = name; *c == '['; c++)
+        {
+            info.dimensions++;
+        }
+        return info;
+    }
+
+    array_class_info resolve_array_class_info(JNIEnv* env, jclass cls)
+    {
+        jstring name = (jstring)env->CallObjectMethod(cls, get_jni_symbols().class_get_name);
+        if(env->ExceptionCheck() || !name)
+        {
+            std::string error = env->ExceptionCheck() ? get_exception_description(env) : std::string();
+            throw std::runtime_error(error.empty() ? std::string("Failed to get array class name") : error);
+        }
+
+        const char* name_str = env->GetStringUTFChars(name, nullptr);
+        array_class_info info = parse_array_class_name(name_str ? name_str : "");
+        env->ReleaseStringUTFChars(name, name_str);
+        env->DeleteLocalRef(name);
+        return info;
+    }
+}
+
+array_class_info get_array_class_info(JNIEnv* env, jarray arr)
+{
+    if(!arr)
+    {
+        return {};
+    }
+
+    jclass cls = env->GetObjectClass(arr);
+
+    array_class_info info;
+    {
+        std::shared_lock<std::shared_mutex> lock(g_entries_mutex);
+        if(find_entry(env, cls, info))
+        {
+            env->DeleteLocalRef(cls);
+            g_hits.fetch_add(1, std::memory_order_relaxed);
+            return info;
+        }
+    }
+
+    g_misses.fetch_add(1, std::memory_order_relaxed);
+    try
+    {
+        info = resolve_array_class_info(env, cls);
+    }
+    catch(...)
+    {
+        env->DeleteLocalRef(cls);
+        throw;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(g_entries_mutex);
+        array_class_info existing;
+        if(g_entries.size() < max_entries && !find_entry(env, cls, existing))
+        {
+            jclass global = (jclass)env->NewGlobalRef(cls);
+            if(global)
+            {
+                g_entries.push_back(cache_entry{global, info});
+            }
+        }
+    }
+
+    env->DeleteLocalRef(cls);
+    return info;
+}
+
+void release_array_class_cache(JNIEnv* env)
+{
+    std::unique_lock<std::shared_mutex> lock(g_entries_mutex);
+    if(env)
+    {
+        for(auto& entry : g_entries)
+        {
+            env->DeleteGlobalRef(entry.cls);
+        }
+    }
+    g_entries.clear();
+}
+
+uint64_t get_array_class_cache_hit_count()
+{
+    return g_hits.load(std::memory_order_relaxed);
+}
+
+uint64_t get_array_class_cache_miss_count()
+{
+    return g_misses.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+
+// Process-wide cache of array class shapes, keyed by the array's jclass.
+// Used when a returned array has no fixed_dimensions, so repeat returns of the same array
+// type skip the Class.getName() upcall. Lookups compare classes with IsSameObject and make no
+// call into Java. Entries hold global refs to the classes.
+
+struct array_class_info
+{
+    int dimensions = 0;
+};
+
+// Returns the shape of arr's class, resolving and caching it on first sight.
+// Throws std::runtime_error if the class name cannot be read.
+array_class_info get_array_class_info(JNIEnv* env, jarray arr);
+
+// Deletes the cached global references. Called by free_runtime().
+void release_array_class_cache(JNIEnv* env);
+
+uint64_t get_array_class_cache_hit_count();
+uint64_t get_array_class_cache_miss_count();
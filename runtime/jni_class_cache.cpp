@@ -0,0 +1,328 @@
+#include "jni_class_cache.h"
+#include "jni_symbols.h"
+
+#include <runtime_manager/jvm/jni_helpers.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    struct loader_cache
+    {
+        jobject loader = nullptr; // global ref
+        std::unordered_map<std::string, jclass> found; // global refs
+        std::unordered_set<std::string> missing;
+    };
+
+    // one entry per class loader seen; loaders are few, so they are told apart with IsSameObject
+    std::vector<std::unique_ptr<loader_cache>> g_loaders;
+    std::shared_mutex g_loaders_mutex;
+    std::unordered_set<std::string> g_class_paths; // module paths seen by note_class_path
+    uint64_t g_class_path_generation = 0; // bumped with each new path; guarded by g_loaders_mutex
+
+    // bounds what a scan of a large jar can pin; past it new names are not remembered
+    constexpr size_t max_entries_per_loader = 65536;
+
+    std::atomic<uint64_t> g_hits{0};
+    std::atomic<uint64_t> g_negative_hits{0};
+    std::atomic<uint64_t> g_misses{0};
+
+    loader_cache* find_loader(JNIEnv* env, jobject loader)
+    {
+        for(const auto& cache : g_loaders)
+        {
+            if(env->IsSameObject(cache->loader, loader) == JNI_TRUE)
+            {
+                return cache.get();
+            }
+        }
+        return nullptr;
+    }
+
+    loader_cache* get_loader(JNIEnv* env, jobject loader)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(g_loaders_mutex);
+            if(loader_cache* cache = find_loader(env, loader))
+            {
+                return cache;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(g_loaders_mutex);
+        if(loader_cache* cache = find_loader(env, loader))
+        {
+            return cache;
+        }
+        auto cache = std::make_unique<loader_cache>();
+        cache->loader = env->NewGlobalRef(loader);
+        if(!cache->loader)
+        {
+            return nullptr;
+        }
+        g_loaders.push_back(std::move(cache));
+        return g_loaders.back().get();
+    }
+
+    // "a.b.C$D" -> "a/b/C$D.class", "[[La.b.C;" -> "a/b/C.class"; empty for primitive arrays
+    std::string class_resource_name(const std::string& name)
+    {
+        size_t begin = name.find_first_not_of('[');
+        if(begin == std::string::npos)
+        {
+            return "";
+        }
+
+        size_t end = name.size();
+        if(begin > 0)
+        {
+            if(name[begin] != 'L' || name.back() != ';')
+            {
+                return "";
+            }
+            begin++;
+            end--;
+        }
+
+        std::string resource = name.substr(begin, end - begin);
+        for(char& c : resource)
+        {
+            if(c == '.')
+            {
+                c = '/';
+            }
+        }
+        return resource + ".class";
+    }
+
+    bool has_class_resource(JNIEnv* env, jobject loader, const std::string& name)
+    {
+        std::string resource = class_resource_name(name);
+        if(resource.empty())
+        {
+            return false;
+        }
+
+        jstring jresource = env->NewStringUTF(resource.c_str());
+        if(!jresource)
+        {
+            env->ExceptionClear();
+            return false;
+        }
+        jobject url = env->CallObjectMethod(loader, get_jni_symbols().class_loader_get_resource, jresource);
+        env->DeleteLocalRef(jresource);
+        if(env->ExceptionCheck())
+        {
+            env->ExceptionClear();
+            return false;
+        }
+        if(!url)
+        {
+            return false;
+        }
+        env->DeleteLocalRef(url);
+        return true;
+    }
+
+    // generation is the class path generation the lookup started in: a class found missing
+    // before a new path was noted may be on that path, so the miss is not remembered
+    void remember(JNIEnv* env, loader_cache& cache, const std::string& name, jclass found, uint64_t generation)
+    {
+        std::unique_lock<std::shared_mutex> lock(g_loaders_mutex);
+        if(cache.found.size() + cache.missing.size() >= max_entries_per_loader)
+        {
+            return;
+        }
+
+        if(!found)
+        {
+            if(generation == g_class_path_generation)
+            {
+                cache.missing.insert(name);
+            }
+            return;
+        }
+        if(cache.found.count(name) == 0)
+        {
+            jclass global = (jclass)env->NewGlobalRef(found);
+            if(global)
+            {
+                cache.found.emplace(name, global);
+            }
+        }
+    }
+
+    // Class.forName(name, false, loader). A ClassNotFoundException is remembered as missing;
+    // other failures (linkage errors) are reported but not cached, as they may not be final.
+    jclass load_candidate(JNIEnv* env, loader_cache& cache, const std::string& name, uint64_t generation, std::string& error)
+    {
+        g_misses.fetch_add(1, std::memory_order_relaxed);
+        const auto& sym = get_jni_symbols();
+
+        jstring jname = env->NewStringUTF(name.c_str());
+        if(!jname)
+        {
+            env->ExceptionClear();
+            error = "Failed to create class name string: " + name;
+            return nullptr;
+        }
+        jclass cls = (jclass)env->CallStaticObjectMethod(sym.class_cls, sym.class_for_name, jname, JNI_FALSE, cache.loader);
+        env->DeleteLocalRef(jname);
+
+        if(!env->ExceptionCheck())
+        {
+            if(cls)
+            {
+                remember(env, cache, name, cls, generation);
+            }
+            return cls;
+        }
+
+        jthrowable thrown = env->ExceptionOccurred();
+        env->ExceptionClear();
+        if(env->IsInstanceOf(thrown, sym.class_not_found_cls) == JNI_TRUE)
+        {
+            error = "Failed to load Java class: " + name;
+            remember(env, cache, name, nullptr, generation);
+        }
+        else
+        {
+            env->Throw(thrown);
+            error = get_exception_description(env);
+            env->ExceptionClear();
+            if(error.empty())
+            {
+                error = "Failed to load Java class: " + name;
+            }
+        }
+        env->DeleteLocalRef(thrown);
+        return nullptr;
+    }
+}
+
+jclass find_class_candidates(JNIEnv* env, jobject loader, const std::vector<std::string>& candidates, std::string& error)
+{
+    loader_cache* cache = loader ? get_loader(env, loader) : nullptr;
+    if(!cache)
+    {
+        error = "No class loader to resolve Java classes with";
+        return nullptr;
+    }
+
+    std::vector<const std::string*> unknown;
+    uint64_t generation = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(g_loaders_mutex);
+        generation = g_class_path_generation;
+        for(const auto& candidate : candidates)
+        {
+            auto it = cache->found.find(candidate);
+            if(it != cache->found.end())
+            {
+                g_hits.fetch_add(1, std::memory_order_relaxed);
+                return (jclass)env->NewLocalRef(it->second);
+            }
+            if(cache->missing.count(candidate) > 0)
+            {
+                g_negative_hits.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            unknown.push_back(&candidate);
+        }
+    }
+
+    if(unknown.empty())
+    {
+        error = "Failed to load Java class: " + (candidates.empty() ? std::string() : candidates.front());
+        return nullptr;
+    }
+
+    // the candidate with a class file is the one to load; the others are never tried
+    std::vector<bool> tried(unknown.size(), false);
+    for(size_t i = 0; i < unknown.size(); i++)
+    {
+        if(has_class_resource(env, cache->loader, *unknown[i]))
+        {
+            tried[i] = true;
+            if(jclass cls = load_candidate(env, *cache, *unknown[i], generation, error))
+            {
+                return cls;
+            }
+        }
+    }
+
+    // classes without a class file (generated, primitive arrays) are loaded in turn
+    for(size_t i = 0; i < unknown.size(); i++)
+    {
+        if(!tried[i])
+        {
+            if(jclass cls = load_candidate(env, *cache, *unknown[i], generation, error))
+            {
+                return cls;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void note_class_path(const std::string& module_path)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(g_loaders_mutex);
+        if(g_class_paths.count(module_path) > 0)
+        {
+            return;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(g_loaders_mutex);
+    if(!g_class_paths.insert(module_path).second)
+    {
+        return;
+    }
+    g_class_path_generation++;
+    for(auto& cache : g_loaders)
+    {
+        cache->missing.clear();
+    }
+}
+
+void release_class_cache(JNIEnv* env)
+{
+    std::unique_lock<std::shared_mutex> lock(g_loaders_mutex);
+    if(env)
+    {
+        for(auto& cache : g_loaders)
+        {
+            for(auto& [name, cls] : cache->found)
+            {
+                env->DeleteGlobalRef(cls);
+            }
+            env->DeleteGlobalRef(cache->loader);
+        }
+    }
+    g_loaders.clear();
+    g_class_paths.clear();
+}
+
+uint64_t get_class_cache_hit_count()
+{
+    return g_hits.load(std::memory_order_relaxed);
+}
+
+uint64_t get_class_cache_negative_hit_count()
+{
+    return g_negative_hits.load(std::memory_order_relaxed);
+}
+
+uint64_t get_class_cache_miss_count()
+{
+    return g_misses.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-class-loader cache of binary class names, positive and negative.
+// Entity paths name nested classes with dots, so a name is resolved by trying candidates
+// (a.b.C.D, a.b.C$D, a.b$C$D, ...). Candidates are first probed as .class resources, which
+// fails without raising anything, and only a candidate that has one is loaded; names that
+// definitely do not exist (ClassNotFoundException) are remembered so the next lookup skips
+// them. Positive entries hold global refs to the classes. Thread-safe.
+
+// Resolves the first loadable candidate through loader, without throwing.
+// Returns a local ref, or nullptr with a description of the last failure in error.
+// Candidates may be class names (a.b.C$D) or array names ([La.b.C$D;).
+jclass find_class_candidates(JNIEnv* env, jobject loader, const std::vector<std::string>& candidates, std::string& error);
+
+// Records that the loaders may now see the classes of module_path; call it once the loader
+// has been extended with the path. The first time a path is seen the negative entries are
+// forgotten, as a class missing before may be there now, and so are the misses of lookups
+// still in flight, which started before the path was there.
+void note_class_path(const std::string& module_path);
+
+// Deletes the cached global references. Called by free_runtime().
+void release_class_cache(JNIEnv* env);
+
+uint64_t get_class_cache_hit_count();          // candidates served by a cached class
+uint64_t get_class_cache_negative_hit_count(); // candidates skipped as known to be missing
+uint64_t get_class_cache_miss_count();         // candidates looked up in the JVM
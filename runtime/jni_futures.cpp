@@ -0,0 +1,190 @@
+#include "jni_futures.h"
+#include "future_completion_class.h"
+#include "jvm_runtime_epoch.h"
+
+#include <runtime_manager/jvm/jni_helpers.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    struct future_bridge
+    {
+        jclass cls = nullptr;              // metaffi.runtime.FutureCompletion
+        jclass stage_cls = nullptr;        // java.util.concurrent.CompletionStage
+        jmethodID ctor = nullptr;          // FutureCompletion(long)
+        jmethodID when_complete = nullptr; // CompletionStage whenComplete(BiConsumer)
+        future_completion_fn on_complete = nullptr;
+    };
+
+    std::atomic<future_bridge*> g_bridge{nullptr};
+    std::atomic<uint64_t> g_bridged_count{0};
+    std::atomic<uint64_t> g_completed_count{0};
+
+    // native method of FutureCompletion: static void complete(long token, Object value, Throwable error)
+    void JNICALL complete_native(JNIEnv* env, jclass, jlong token, jobject value, jthrowable error)
+    {
+        // free_runtime() withdraws the runtime before it releases the bridge, so the bridge
+        // stays valid while the scope is open
+        runtime_call_scope runtime_scope;
+        if(!runtime_scope || !token)
+        {
+            return; // the runtime was released while the stage was pending
+        }
+        future_bridge* b = g_bridge.load(std::memory_order_acquire);
+        if(!b)
+        {
+            return;
+        }
+
+        g_completed_count.fetch_add(1, std::memory_order_relaxed);
+        b->on_complete(env, reinterpret_cast<void*>(static_cast<intptr_t>(token)), value, error);
+    }
+
+    void delete_bridge(JNIEnv* env, future_bridge& b)
+    {
+        if(b.cls)
+        {
+            env->DeleteGlobalRef(b.cls);
+        }
+        if(b.stage_cls)
+        {
+            env->DeleteGlobalRef(b.stage_cls);
+        }
+    }
+
+    jclass global_class(JNIEnv* env, jclass local)
+    {
+        if(!local)
+        {
+            return nullptr;
+        }
+        jclass global = (jclass)env->NewGlobalRef(local);
+        env->DeleteLocalRef(local);
+        return global;
+    }
+
+    [[noreturn]] void throw_bridge_error(JNIEnv* env, const char* what)
+    {
+        std::string msg = what;
+        std::string error = env->ExceptionCheck() ? get_exception_description(env) : std::string();
+        env->ExceptionClear();
+        if(!error.empty())
+        {
+            msg += ": " + error;
+        }
+        throw std::runtime_error(msg);
+    }
+}
+
+bool load_future_bridge(JNIEnv* env, future_completion_fn on_complete)
+{
+    if(g_bridge.load(std::memory_order_acquire))
+    {
+        return true;
+    }
+
+    auto b = std::make_unique<future_bridge>();
+    b->on_complete = on_complete;
+
+    // the class outlives free_runtime() in the JVM, so a reload finds the earlier definition
+    jclass local = env->FindClass("metaffi/runtime/FutureCompletion");
+    if(!local)
+    {
+        env->ExceptionClear();
+        local = env->DefineClass("metaffi/runtime/FutureCompletion", nullptr,
+                                 reinterpret_cast<const jbyte*>(future_completion_class), static_cast<jsize>(sizeof(future_completion_class)));
+    }
+    b->cls = global_class(env, local);
+    b->stage_cls = global_class(env, env->FindClass("java/util/concurrent/CompletionStage"));
+    if(b->cls && b->stage_cls)
+    {
+        b->ctor = env->GetMethodID(b->cls, "<init>", "(J)V");
+        b->when_complete = env->GetMethodID(b->stage_cls, "whenComplete", "(Ljava/util/function/BiConsumer;)Ljava/util/concurrent/CompletionStage;");
+    }
+
+    bool registered = false;
+    if(b->ctor && b->when_complete)
+    {
+        JNINativeMethod native{const_cast<char*>("complete"), const_cast<char*>("(JLjava/lang/Object;Ljava/lang/Throwable;)V"), reinterpret_cast<void*>(complete_native)};
+        registered = env->RegisterNatives(b->cls, &native, 1) == JNI_OK;
+    }
+
+    if(!registered)
+    {
+        env->ExceptionClear();
+        delete_bridge(env, *b);
+        return false;
+    }
+
+    g_bridge.store(b.release(), std::memory_order_release);
+    return true;
+}
+
+void release_future_bridge(JNIEnv* env)
+{
+    future_bridge* b = g_bridge.exchange(nullptr, std::memory_order_acq_rel);
+    if(!b)
+    {
+        return;
+    }
+
+    if(env)
+    {
+        delete_bridge(env, *b);
+    }
+    delete b;
+}
+
+bool is_future_alias(const char* alias)
+{
+    return alias && (std::strcmp(alias, "java.util.concurrent.CompletableFuture") == 0 ||
+                     std::strcmp(alias, "java.util.concurrent.CompletionStage") == 0);
+}
+
+void bridge_completion_stage(JNIEnv* env, jobject stage, void* token)
+{
+    future_bridge* b = g_bridge.load(std::memory_order_acquire);
+    if(!b)
+    {
+        throw std::runtime_error("Future bridge is not loaded");
+    }
+    if(!stage || !env->IsInstanceOf(stage, b->stage_cls))
+    {
+        throw std::runtime_error("Java method did not return a CompletionStage");
+    }
+
+    jobject completion = env->NewObject(b->cls, b->ctor, static_cast<jlong>(reinterpret_cast<intptr_t>(token)));
+    if(!completion)
+    {
+        throw_bridge_error(env, "Failed to create future continuation");
+    }
+
+    // counted before whenComplete, which runs the continuation at once on a completed stage
+    g_bridged_count.fetch_add(1, std::memory_order_relaxed);
+    jobject dependent = env->CallObjectMethod(stage, b->when_complete, completion);
+    env->DeleteLocalRef(completion);
+    if(env->ExceptionCheck())
+    {
+        g_bridged_count.fetch_sub(1, std::memory_order_relaxed);
+        throw_bridge_error(env, "Failed to register future continuation");
+    }
+    if(dependent)
+    {
+        env->DeleteLocalRef(dependent);
+    }
+}
+
+uint64_t get_bridged_future_count()
+{
+    return g_bridged_count.load(std::memory_order_relaxed);
+}
+
+uint64_t get_completed_future_count()
+{
+    return g_completed_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+
+// Bridges Java CompletionStage results to host-side completion callbacks without parking a
+// thread on Future.get(). A metaffi.runtime.FutureCompletion continuation (a bootstrap class
+// defined from bytes embedded at build time) is registered with whenComplete; its native
+// method hands the value or the failure back to the plugin on whichever Java thread
+// completes the stage.
+
+// Called once per bridged stage, with the token passed to bridge_completion_stage(), inside a
+// runtime call (runtime_call_scope). error is null on success. A stage that completes after
+// the runtime was withdrawn does not call it; the owner of the token fails it instead.
+// Runs inside a native method, so it must not throw.
+using future_completion_fn = void (*)(JNIEnv* env, void* token, jobject value, jthrowable error);
+
+// Defines the continuation class and binds its native method to on_complete. Returns false
+// if the bridge is unavailable. Not thread-safe with respect to release_future_bridge().
+bool load_future_bridge(JNIEnv* env, future_completion_fn on_complete);
+void release_future_bridge(JNIEnv* env);
+
+// True for the type aliases that mark a future-returning entity:
+// java.util.concurrent.CompletableFuture and java.util.concurrent.CompletionStage.
+bool is_future_alias(const char* alias);
+
+// Registers the continuation for token on stage. Throws if the bridge is not loaded, stage
+// is not a CompletionStage, or whenComplete fails; on_complete is then never called for token.
+// If stage is already complete, on_complete runs before this returns.
+void bridge_completion_stage(JNIEnv* env, jobject stage, void* token);
+
+uint64_t get_bridged_future_count();
+uint64_t get_completed_future_count();
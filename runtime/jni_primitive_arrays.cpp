@@ -0,0 +1,298 @@
+#include "jni_primitive_arrays.h"
+#include "jni_symbols.h"
+#include "simd_convert.h"
+
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    std::atomic<size_t> g_threshold{0};
+    std::atomic<uint64_t> g_count{0};
+
+    // element width of the Java array the type maps to; 0 if the type has no bulk path
+    size_t element_width(metaffi_type type)
+    {
+        switch(type)
+        {
+            case metaffi_bool_type: return sizeof(jboolean);
+            case metaffi_int8_type: return sizeof(jbyte);
+            case metaffi_uint8_type: return sizeof(jshort);
+            case metaffi_int16_type: return sizeof(jshort);
+            case metaffi_uint16_type: return sizeof(jint);
+            case metaffi_uint32_type: return sizeof(jlong);
+            case metaffi_int32_type: return sizeof(jint);
+            case metaffi_int64_type: return sizeof(jlong);
+            case metaffi_float32_type: return sizeof(jfloat);
+            case metaffi_float64_type: return sizeof(jdouble);
+            default: return 0;
+        }
+    }
+
+    jclass java_array_class(metaffi_type type)
+    {
+        const auto& sym = get_jni_symbols();
+        switch(type)
+        {
+            case metaffi_bool_type: return sym.boolean_array_cls;
+            case metaffi_int8_type: return sym.byte_array_cls;
+            case metaffi_uint8_type:
+            case metaffi_int16_type: return sym.short_array_cls;
+            case metaffi_uint16_type:
+            case metaffi_int32_type: return sym.int_array_cls;
+            case metaffi_uint32_type:
+            case metaffi_int64_type: return sym.long_array_cls;
+            case metaffi_float32_type: return sym.float_array_cls;
+            case metaffi_float64_type: return sym.double_array_cls;
+            default: return nullptr;
+        }
+    }
+
+    // no JNI calls are allowed between Get/ReleasePrimitiveArrayCritical, so the loops below
+    // only touch the cdts and the pinned Java array
+    template<typename J, typename Read>
+    jarray fill_java_array(JNIEnv* env, jarray arr, const cdts& src, Read read)
+    {
+        if(!arr)
+        {
+            env->ExceptionClear();
+            throw std::runtime_error("Failed to allocate Java array");
+        }
+
+        void* pinned = env->GetPrimitiveArrayCritical(arr, nullptr);
+        if(!pinned)
+        {
+            env->ExceptionClear();
+            throw std::runtime_error("Failed to access Java array");
+        }
+
+        J* dst = static_cast<J*>(pinned);
+        for(metaffi_size i = 0; i < src.length; i++)
+        {
+            dst[i] = read(src[i]);
+        }
+
+        env->ReleasePrimitiveArrayCritical(arr, pinned, 0);
+        return arr;
+    }
+
+    template<typename J, typename Write>
+    void read_java_array(JNIEnv* env, jarray arr, cdts& dst, Write write)
+    {
+        void* pinned = env->GetPrimitiveArrayCritical(arr, nullptr);
+        if(!pinned)
+        {
+            env->ExceptionClear();
+            throw std::runtime_error("Failed to access Java array");
+        }
+
+        const J* src = static_cast<const J*>(pinned);
+        for(metaffi_size i = 0; i < dst.length; i++)
+        {
+            write(dst[i], src[i]);
+        }
+
+        // read-only access, nothing to copy back
+        env->ReleasePrimitiveArrayCritical(arr, pinned, JNI_ABORT);
+    }
+
+    // contiguous per-thread buffer for the converting paths; grows to the largest array seen
+    void* staging_buffer(size_t bytes)
+    {
+        thread_local std::vector<uint64_t> storage;
+        size_t words = (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        if(storage.size() < words)
+        {
+            storage.resize(words);
+        }
+        return storage.data();
+    }
+
+    // Converting variants: cdt values are gathered into a contiguous buffer first, so the
+    // critical section only runs the vectorized conversion.
+    template<typename H, typename W, typename Read>
+    jarray fill_java_array_converted(JNIEnv* env, jarray arr, const cdts& src, Read read, void (*kernel)(const H*, W*, size_t))
+    {
+        if(!arr)
+        {
+            env->ExceptionClear();
+            throw std::runtime_error("Failed to allocate Java array");
+        }
+
+        H* staging = static_cast<H*>(staging_buffer(static_cast<size_t>(src.length) * sizeof(H)));
+        for(metaffi_size i = 0; i < src.length; i++)
+        {
+            staging[i] = read(src[i]);
+        }
+
+        void* pinned = env->GetPrimitiveArrayCritical(arr, nullptr);
+        if(!pinned)
+        {
+            env->ExceptionClear();
+            throw std::runtime_error("Failed to access Java array");
+        }
+        kernel(staging, static_cast<W*>(pinned), static_cast<size_t>(src.length));
+        env->ReleasePrimitiveArrayCritical(arr, pinned, 0);
+        return arr;
+    }
+
+    template<typename W, typename H, typename Write>
+    void read_java_array_converted(JNIEnv* env, jarray arr, cdts& dst, void (*kernel)(const W*, H*, size_t), Write write)
+    {
+        H* staging = static_cast<H*>(staging_buffer(static_cast<size_t>(dst.length) * sizeof(H)));
+
+        void* pinned = env->GetPrimitiveArrayCritical(arr, nullptr);
+        if(!pinned)
+        {
+            env->ExceptionClear();
+            throw std::runtime_error("Failed to access Java array");
+        }
+        kernel(static_cast<const W*>(pinned), staging, static_cast<size_t>(dst.length));
+        env->ReleasePrimitiveArrayCritical(arr, pinned, JNI_ABORT);
+
+        for(metaffi_size i = 0; i < dst.length; i++)
+        {
+            write(dst[i], staging[i]);
+        }
+    }
+}
+
+void set_critical_array_threshold(size_t bytes)
+{
+    g_threshold.store(bytes, std::memory_order_relaxed);
+}
+
+size_t get_critical_array_threshold()
+{
+    return g_threshold.load(std::memory_order_relaxed);
+}
+
+jarray critical_array_from_cdt(JNIEnv* env, cdt& item, const metaffi_type_info& declared)
+{
+    size_t threshold = g_threshold.load(std::memory_order_relaxed);
+    if(threshold == 0 || (item.type & metaffi_array_type) != metaffi_array_type ||
+       item.type != declared.type || declared.fixed_dimensions != 1)
+    {
+        return nullptr;
+    }
+
+    metaffi_type elem_type = item.type & ~metaffi_array_type;
+    size_t width = element_width(elem_type);
+    const cdts& src = static_cast<cdts&>(item);
+    if(width == 0 || src.fixed_dimensions != 1 || src.length * width < threshold ||
+       src.length > static_cast<metaffi_size>(std::numeric_limits<jsize>::max()))
+    {
+        return nullptr;
+    }
+
+    jsize length = static_cast<jsize>(src.length);
+    const conversion_kernels& kernels = get_conversion_kernels();
+    jarray result = nullptr;
+    switch(elem_type)
+    {
+        case metaffi_bool_type:
+            result = fill_java_array_converted<uint8_t, uint8_t>(env, env->NewBooleanArray(length), src, [](const cdt& c) { return static_cast<uint8_t>(c.cdt_val.bool_val); }, kernels.normalize_bools);
+            break;
+        case metaffi_uint8_type:
+            result = fill_java_array_converted<uint8_t, int16_t>(env, env->NewShortArray(length), src, [](const cdt& c) { return c.cdt_val.uint8_val; }, kernels.widen_u8_to_i16);
+            break;
+        case metaffi_uint16_type:
+            result = fill_java_array_converted<uint16_t, int32_t>(env, env->NewIntArray(length), src, [](const cdt& c) { return c.cdt_val.uint16_val; }, kernels.widen_u16_to_i32);
+            break;
+        case metaffi_uint32_type:
+            result = fill_java_array_converted<uint32_t, int64_t>(env, env->NewLongArray(length), src, [](const cdt& c) { return c.cdt_val.uint32_val; }, kernels.widen_u32_to_i64);
+            break;
+        case metaffi_int8_type:
+            result = fill_java_array<jbyte>(env, env->NewByteArray(length), src, [](const cdt& c) { return static_cast<jbyte>(c.cdt_val.int8_val); });
+            break;
+        case metaffi_int16_type:
+            result = fill_java_array<jshort>(env, env->NewShortArray(length), src, [](const cdt& c) { return static_cast<jshort>(c.cdt_val.int16_val); });
+            break;
+        case metaffi_int32_type:
+            result = fill_java_array<jint>(env, env->NewIntArray(length), src, [](const cdt& c) { return static_cast<jint>(c.cdt_val.int32_val); });
+            break;
+        case metaffi_int64_type:
+            result = fill_java_array<jlong>(env, env->NewLongArray(length), src, [](const cdt& c) { return static_cast<jlong>(c.cdt_val.int64_val); });
+            break;
+        case metaffi_float32_type:
+            result = fill_java_array<jfloat>(env, env->NewFloatArray(length), src, [](const cdt& c) { return static_cast<jfloat>(c.cdt_val.float32_val); });
+            break;
+        case metaffi_float64_type:
+            result = fill_java_array<jdouble>(env, env->NewDoubleArray(length), src, [](const cdt& c) { return static_cast<jdouble>(c.cdt_val.float64_val); });
+            break;
+        default:
+            return nullptr;
+    }
+
+    g_count.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+bool critical_array_to_cdt(JNIEnv* env, jarray arr, metaffi_type elem_type, cdt& out)
+{
+    size_t threshold = g_threshold.load(std::memory_order_relaxed);
+    size_t width = element_width(elem_type);
+    // bool results are left to the serializer: jboolean is already 0/1, there is nothing to pack
+    if(threshold == 0 || width == 0 || !arr || elem_type == metaffi_bool_type)
+    {
+        return false;
+    }
+
+    // the declared element type must match the Java array exactly (e.g. not int[] for int64)
+    if(env->IsInstanceOf(arr, java_array_class(elem_type)) == JNI_FALSE)
+    {
+        return false;
+    }
+
+    jsize length = env->GetArrayLength(arr);
+    if(static_cast<size_t>(length) * width < threshold)
+    {
+        return false;
+    }
+
+    out.set_new_array(static_cast<metaffi_size>(length), 1, elem_type);
+    cdts& dst = static_cast<cdts&>(out);
+    const conversion_kernels& kernels = get_conversion_kernels();
+    switch(elem_type)
+    {
+        case metaffi_uint8_type:
+            read_java_array_converted<int16_t, uint8_t>(env, arr, dst, kernels.narrow_i16_to_u8, [](cdt& c, uint8_t v) { c = static_cast<metaffi_uint8>(v); });
+            break;
+        case metaffi_uint16_type:
+            read_java_array_converted<int32_t, uint16_t>(env, arr, dst, kernels.narrow_i32_to_u16, [](cdt& c, uint16_t v) { c = static_cast<metaffi_uint16>(v); });
+            break;
+        case metaffi_uint32_type:
+            read_java_array_converted<int64_t, uint32_t>(env, arr, dst, kernels.narrow_i64_to_u32, [](cdt& c, uint32_t v) { c = static_cast<metaffi_uint32>(v); });
+            break;
+        case metaffi_int8_type:
+            read_java_array<jbyte>(env, arr, dst, [](cdt& c, jbyte v) { c = static_cast<metaffi_int8>(v); });
+            break;
+        case metaffi_int16_type:
+            read_java_array<jshort>(env, arr, dst, [](cdt& c, jshort v) { c = static_cast<metaffi_int16>(v); });
+            break;
+        case metaffi_int32_type:
+            read_java_array<jint>(env, arr, dst, [](cdt& c, jint v) { c = static_cast<metaffi_int32>(v); });
+            break;
+        case metaffi_int64_type:
+            read_java_array<jlong>(env, arr, dst, [](cdt& c, jlong v) { c = static_cast<metaffi_int64>(v); });
+            break;
+        case metaffi_float32_type:
+            read_java_array<jfloat>(env, arr, dst, [](cdt& c, jfloat v) { c = static_cast<metaffi_float32>(v); });
+            break;
+        case metaffi_float64_type:
+            read_java_array<jdouble>(env, arr, dst, [](cdt& c, jdouble v) { c = static_cast<metaffi_float64>(v); });
+            break;
+        default:
+            return false;
+    }
+
+    g_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t get_critical_array_count()
+{
+    return g_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <jni.h>
+#include <runtime/cdt.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk marshalling of 1-D primitive arrays through GetPrimitiveArrayCritical.
+// Covers element types whose Java array has the same width (int8/16/32/64, float32/64) and
+// the unsigned types marshalled as the next wider Java primitive (uint8/16/32 as
+// short/int/long), which are converted with the SIMD kernels of simd_convert.h.
+// Bool arrays use the bulk path as parameters only.
+// One critical section replaces the serializer's per-element path.
+// Opt-in: disabled until a threshold is set (METAFFI_JVM_CRITICAL_ARRAY_THRESHOLD, bytes),
+// arrays smaller than the threshold keep the serializer path.
+
+// 0 disables the bulk path.
+void set_critical_array_threshold(size_t bytes);
+size_t get_critical_array_threshold();
+
+// If item is an eligible 1-D array of the declared type, creates the matching Java array and
+// fills it in one critical section. Returns nullptr to leave the item to the serializer,
+// which also reports an item whose element type or dimensions differ from the declaration.
+jarray critical_array_from_cdt(JNIEnv* env, cdt& item, const metaffi_type_info& declared);
+
+// If arr is an eligible array of elem_type, reads it in place (no write-back) into out as
+// a 1-D cdts array and returns true. Returns false to leave it to the serializer.
+bool critical_array_to_cdt(JNIEnv* env, jarray arr, metaffi_type elem_type, cdt& out);
+
+uint64_t get_critical_array_count();
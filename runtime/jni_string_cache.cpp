@@ -0,0 +1,205 @@
+#include "jni_string_cache.h"
+#include "jni_strings.h"
+#include "jni_symbols.h"
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    constexpr size_t max_cached_length = 256;
+
+    std::atomic<size_t> g_capacity{0};
+
+    // heterogeneous lookup: probe with the caller's view, no key copy on hits
+    struct content_hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::u8string_view s) const { return std::hash<std::u8string_view>{}(s); }
+    };
+
+    // content -> interned java.lang.String (global ref)
+    std::unordered_map<std::u8string, jstring, content_hash, std::equal_to<>> g_params;
+    std::shared_mutex g_params_mutex;
+
+    struct result_entry
+    {
+        jstring str = nullptr; // global ref; keeps the identity stable while cached
+        std::u8string utf8;
+    };
+
+    // identity hash -> entries; collisions are told apart with IsSameObject
+    std::unordered_multimap<jint, result_entry> g_results;
+    std::shared_mutex g_results_mutex;
+
+    std::atomic<uint64_t> g_param_hits{0};
+    std::atomic<uint64_t> g_param_misses{0};
+    std::atomic<uint64_t> g_result_hits{0};
+    std::atomic<uint64_t> g_result_misses{0};
+
+    void clear_params(JNIEnv* env)
+    {
+        if(env)
+        {
+            for(auto& [content, str] : g_params)
+            {
+                env->DeleteGlobalRef(str);
+            }
+        }
+        g_params.clear();
+    }
+
+    void clear_results(JNIEnv* env)
+    {
+        if(env)
+        {
+            for(auto& [hash, entry] : g_results)
+            {
+                env->DeleteGlobalRef(entry.str);
+            }
+        }
+        g_results.clear();
+    }
+
+    const result_entry* find_result(JNIEnv* env, jint hash, jstring str)
+    {
+        auto range = g_results.equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            if(env->IsSameObject(it->second.str, str) == JNI_TRUE)
+            {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+}
+
+void set_string_cache_capacity(size_t entries)
+{
+    g_capacity.store(entries, std::memory_order_relaxed);
+}
+
+size_t get_string_cache_capacity()
+{
+    return g_capacity.load(std::memory_order_relaxed);
+}
+
+jstring cached_jstring(JNIEnv* env, std::u8string_view utf8)
+{
+    size_t capacity = g_capacity.load(std::memory_order_relaxed);
+    if(capacity == 0 || utf8.size() > max_cached_length)
+    {
+        return nullptr;
+    }
+
+    {
+        // the local ref is taken under the lock, so a concurrent clear cannot free the entry first
+        std::shared_lock<std::shared_mutex> lock(g_params_mutex);
+        auto it = g_params.find(utf8);
+        if(it != g_params.end())
+        {
+            g_param_hits.fetch_add(1, std::memory_order_relaxed);
+            return (jstring)env->NewLocalRef(it->second);
+        }
+    }
+
+    g_param_misses.fetch_add(1, std::memory_order_relaxed);
+    jstring created = utf8_to_jstring(env, utf8.data(), utf8.size());
+    jstring interned = (jstring)env->CallObjectMethod(created, get_jni_symbols().string_intern);
+    if(env->ExceptionCheck() || !interned)
+    {
+        // interning is an optimization; fall back to the uncached string
+        env->ExceptionClear();
+        return created;
+    }
+    env->DeleteLocalRef(created);
+
+    std::unique_lock<std::shared_mutex> lock(g_params_mutex);
+    if(g_params.find(utf8) == g_params.end())
+    {
+        if(g_params.size() >= capacity)
+        {
+            clear_params(env);
+        }
+        if(jstring global = (jstring)env->NewGlobalRef(interned))
+        {
+            g_params.emplace(std::u8string(utf8), global);
+        }
+    }
+    return interned;
+}
+
+bool cached_string_to_cdt(JNIEnv* env, jstring str, cdt& out)
+{
+    size_t capacity = g_capacity.load(std::memory_order_relaxed);
+    if(capacity == 0 || static_cast<size_t>(env->GetStringLength(str)) > max_cached_length)
+    {
+        return false;
+    }
+
+    const auto& sym = get_jni_symbols();
+    jint hash = env->CallStaticIntMethod(sym.system_cls, sym.system_identity_hash_code, str);
+    {
+        std::shared_lock<std::shared_mutex> lock(g_results_mutex);
+        if(const result_entry* entry = find_result(env, hash, str))
+        {
+            g_result_hits.fetch_add(1, std::memory_order_relaxed);
+            set_cdt_string8(out, entry->utf8.data(), entry->utf8.size());
+            return true;
+        }
+    }
+
+    g_result_misses.fetch_add(1, std::memory_order_relaxed);
+    size_t size = jstring_to_cdt(env, str, out);
+
+    std::unique_lock<std::shared_mutex> lock(g_results_mutex);
+    if(!find_result(env, hash, str))
+    {
+        if(g_results.size() >= capacity)
+        {
+            clear_results(env);
+        }
+        if(jstring global = (jstring)env->NewGlobalRef(str))
+        {
+            g_results.emplace(hash, result_entry{global, std::u8string(out.cdt_val.string8_val, size)});
+        }
+    }
+    return true;
+}
+
+void release_string_cache(JNIEnv* env)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(g_params_mutex);
+        clear_params(env);
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(g_results_mutex);
+        clear_results(env);
+    }
+}
+
+uint64_t get_string_param_cache_hit_count()
+{
+    return g_param_hits.load(std::memory_order_relaxed);
+}
+
+uint64_t get_string_param_cache_miss_count()
+{
+    return g_param_misses.load(std::memory_order_relaxed);
+}
+
+uint64_t get_string_result_cache_hit_count()
+{
+    return g_result_hits.load(std::memory_order_relaxed);
+}
+
+uint64_t get_string_result_cache_miss_count()
+{
+    return g_result_misses.load(std::memory_order_relaxed);
+}
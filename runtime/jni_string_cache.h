@@ -0,0 +1,39 @@
+#pragma once
+
+#include <jni.h>
+#include <runtime/cdt.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Opt-in caches for short string8 values that repeat across calls (map keys, metric names,
+// enum-like constants). Disabled until a capacity is set (METAFFI_JVM_STRING_CACHE_CAPACITY).
+//
+// Parameters: keyed by content; a hit returns the cached interned java.lang.String instead
+// of transcoding and allocating a new one.
+// Results: keyed by object identity; a hit copies the cached UTF-8 instead of reading and
+// transcoding the Java string.
+//
+// Each direction holds at most `capacity` global refs; when full it is cleared and refills
+// from the current working set. Strings longer than 256 bytes/chars are never cached.
+
+// Entries per direction; 0 disables both caches.
+void set_string_cache_capacity(size_t entries);
+size_t get_string_cache_capacity();
+
+// Returns a local ref to the cached Java string for utf8, creating and caching it on a miss.
+// Returns nullptr when the cache is disabled or the string is not cacheable.
+jstring cached_jstring(JNIEnv* env, std::u8string_view utf8);
+
+// Writes str into out as a string8 through the result cache and returns true.
+// Returns false, leaving out untouched, when the cache is disabled or str is not cacheable.
+bool cached_string_to_cdt(JNIEnv* env, jstring str, cdt& out);
+
+// Deletes the cached global references. Called by free_runtime().
+void release_string_cache(JNIEnv* env);
+
+uint64_t get_string_param_cache_hit_count();
+uint64_t get_string_param_cache_miss_count();
+uint64_t get_string_result_cache_hit_count();
+uint64_t get_string_result_cache_miss_count();
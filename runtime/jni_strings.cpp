@@ -0,0 +1,506 @@
+#include "jni_strings.h"
+#include "simd_convert.h"
+#include "string_arrays_class.h"
+
+#include <runtime/xllr_capi_loader.h>
+#include <runtime_manager/jvm/jni_helpers.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr jchar replacement_char = 0xFFFD;
+
+    // below this many elements the helper's extra arrays cost more than per-element calls
+    constexpr jsize bulk_string_array_min_length = 8;
+
+    struct string_array_helper
+    {
+        jclass cls = nullptr;              // metaffi.runtime.StringArrays
+        jclass string_array_cls = nullptr; // String[]
+        jmethodID split = nullptr;         // String[] split(char[], int[])
+        jmethodID join = nullptr;          // char[] join(String[], int[])
+    };
+
+    std::atomic<string_array_helper*> g_helper{nullptr};
+    std::atomic<uint64_t> g_bulk_count{0};
+
+    // per-thread transcoding buffers; grow to the longest string seen
+    jchar* utf16_buffer(size_t units)
+    {
+        thread_local std::vector<jchar> storage;
+        if(storage.size() < units)
+        {
+            storage.resize(units);
+        }
+        return storage.data();
+    }
+
+    jint* ends_buffer(size_t count)
+    {
+        thread_local std::vector<jint> storage;
+        if(storage.size() < count)
+        {
+            storage.resize(count);
+        }
+        return storage.data();
+    }
+
+    bool is_continuation(uint8_t b)
+    {
+        return (b & 0xC0) == 0x80;
+    }
+
+    // Decodes src into dst, which must hold at least count units (UTF-16 never needs more
+    // units than UTF-8 bytes). Returns the number of units written.
+    size_t decode_utf8(const uint8_t* src, size_t count, jchar* dst)
+    {
+        size_t out = 0;
+        size_t i = 0;
+        while(i < count)
+        {
+            uint8_t b0 = src[i];
+            if(b0 < 0x80)
+            {
+                dst[out++] = b0;
+                i++;
+                continue;
+            }
+
+            // sequence length and the minimum code point it may encode (rejects overlongs)
+            size_t len;
+            uint32_t cp;
+            uint32_t min;
+            if((b0 & 0xE0) == 0xC0) { len = 2; cp = b0 & 0x1F; min = 0x80; }
+            else if((b0 & 0xF0) == 0xE0) { len = 3; cp = b0 & 0x0F; min = 0x800; }
+            else if((b0 & 0xF8) == 0xF0) { len = 4; cp = b0 & 0x07; min = 0x10000; }
+            else
+            {
+                dst[out++] = replacement_char;
+                i++;
+                continue;
+            }
+
+            size_t j = 1;
+            for(; j < len && i + j < count && is_continuation(src[i + j]); j++)
+            {
+                cp = (cp << 6) | (src[i + j] & 0x3F);
+            }
+
+            if(j < len || cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            {
+                // truncated or invalid sequence: replace it, resume after the bytes consumed
+                dst[out++] = replacement_char;
+                i += j;
+                continue;
+            }
+
+            if(cp >= 0x10000)
+            {
+                cp -= 0x10000;
+                dst[out++] = static_cast<jchar>(0xD800 + (cp >> 10));
+                dst[out++] = static_cast<jchar>(0xDC00 + (cp & 0x3FF));
+            }
+            else
+            {
+                dst[out++] = static_cast<jchar>(cp);
+            }
+            i += len;
+        }
+        return out;
+    }
+
+    // Encodes src into dst, which must hold at least 3 bytes per unit (a surrogate pair is
+    // 2 units and 4 bytes). Returns the number of bytes written.
+    size_t encode_utf8(const jchar* src, size_t count, char8_t* dst)
+    {
+        size_t out = 0;
+        for(size_t i = 0; i < count; i++)
+        {
+            uint32_t cp = src[i];
+            if(cp >= 0xD800 && cp <= 0xDFFF)
+            {
+                if(cp <= 0xDBFF && i + 1 < count && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+                    i++;
+                }
+                else
+                {
+                    cp = replacement_char;
+                }
+            }
+
+            if(cp < 0x80)
+            {
+                dst[out++] = static_cast<char8_t>(cp);
+            }
+            else if(cp < 0x800)
+            {
+                dst[out++] = static_cast<char8_t>(0xC0 | (cp >> 6));
+                dst[out++] = static_cast<char8_t>(0x80 | (cp & 0x3F));
+            }
+            else if(cp < 0x10000)
+            {
+                dst[out++] = static_cast<char8_t>(0xE0 | (cp >> 12));
+                dst[out++] = static_cast<char8_t>(0x80 | ((cp >> 6) & 0x3F));
+                dst[out++] = static_cast<char8_t>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                dst[out++] = static_cast<char8_t>(0xF0 | (cp >> 18));
+                dst[out++] = static_cast<char8_t>(0x80 | ((cp >> 12) & 0x3F));
+                dst[out++] = static_cast<char8_t>(0x80 | ((cp >> 6) & 0x3F));
+                dst[out++] = static_cast<char8_t>(0x80 | (cp & 0x3F));
+            }
+        }
+        return out;
+    }
+
+    // dst must hold count units. Returns the number of units written.
+    size_t utf8_to_utf16(const char8_t* src, size_t count, jchar* dst)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+        const conversion_kernels& kernels = get_conversion_kernels();
+
+        // jchar and int16_t share a representation; ASCII bytes widen to the same code unit
+        size_t ascii = kernels.ascii_prefix_u8(bytes, count);
+        kernels.widen_u8_to_i16(bytes, reinterpret_cast<int16_t*>(dst), ascii);
+        if(ascii == count)
+        {
+            return ascii;
+        }
+        return ascii + decode_utf8(bytes + ascii, count - ascii, dst + ascii);
+    }
+
+    // dst must hold utf8_length(src, count) bytes, at most 3 per unit. Returns the number of bytes written.
+    size_t utf16_to_utf8(const jchar* src, size_t count, char8_t* dst)
+    {
+        const conversion_kernels& kernels = get_conversion_kernels();
+
+        // code units below 0x80 narrow to the same byte
+        size_t ascii = kernels.ascii_prefix_u16(reinterpret_cast<const uint16_t*>(src), count);
+        kernels.narrow_i16_to_u8(reinterpret_cast<const int16_t*>(src), reinterpret_cast<uint8_t*>(dst), ascii);
+        if(ascii == count)
+        {
+            return ascii;
+        }
+        return ascii + encode_utf8(src + ascii, count - ascii, dst + ascii);
+    }
+
+    // The number of bytes utf16_to_utf8 writes for src.
+    size_t utf8_length(const jchar* src, size_t count)
+    {
+        size_t ascii = get_conversion_kernels().ascii_prefix_u16(reinterpret_cast<const uint16_t*>(src), count);
+        size_t size = ascii;
+        for(size_t i = ascii; i < count; i++)
+        {
+            jchar unit = src[i];
+            if(unit < 0x80)
+            {
+                size += 1;
+            }
+            else if(unit < 0x800)
+            {
+                size += 2;
+            }
+            else if(unit <= 0xDBFF && unit >= 0xD800 && i + 1 < count && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF)
+            {
+                size += 4;
+                i++;
+            }
+            else
+            {
+                size += 3; // BMP characters and U+FFFD in place of unpaired surrogates
+            }
+        }
+        return size;
+    }
+
+    // Transcodes src straight into the string the cdt takes ownership of.
+    size_t set_cdt_string8_from_utf16(cdt& out, const jchar* src, size_t count)
+    {
+        size_t size = utf8_length(src, count);
+
+        // xllr strings and memory share one allocator, so the cdt frees this like any string8
+        auto* owned = static_cast<char8_t*>(xllr_alloc_memory(size + 1));
+        if(!owned)
+        {
+            throw std::runtime_error("Failed to allocate string");
+        }
+        utf16_to_utf8(src, count, owned);
+        owned[size] = u8'\0';
+
+        out.type = metaffi_string8_type;
+        out.cdt_val.string8_val = owned;
+        out.free_required = true;
+        return size;
+    }
+
+    [[noreturn]] void throw_helper_error(JNIEnv* env, const char* what)
+    {
+        std::string msg = what;
+        std::string error = get_exception_description(env);
+        env->ExceptionClear();
+        if(!error.empty())
+        {
+            msg += ": " + error;
+        }
+        throw std::runtime_error(msg);
+    }
+
+    void delete_helper(JNIEnv* env, string_array_helper& h)
+    {
+        if(h.cls)
+        {
+            env->DeleteGlobalRef(h.cls);
+        }
+        if(h.string_array_cls)
+        {
+            env->DeleteGlobalRef(h.string_array_cls);
+        }
+    }
+
+    jclass global_class(JNIEnv* env, jclass local)
+    {
+        if(!local)
+        {
+            return nullptr;
+        }
+        jclass global = (jclass)env->NewGlobalRef(local);
+        env->DeleteLocalRef(local);
+        return global;
+    }
+}
+
+jstring utf8_to_jstring(JNIEnv* env, const char8_t* utf8, size_t length)
+{
+    if(length > static_cast<size_t>(std::numeric_limits<jsize>::max()))
+    {
+        throw std::runtime_error("String is too long for a Java string");
+    }
+
+    jchar* units = utf16_buffer(length);
+    size_t count = utf8_to_utf16(utf8, length, units);
+
+    jstring result = env->NewString(units, static_cast<jsize>(count));
+    if(!result)
+    {
+        env->ExceptionClear();
+        throw std::runtime_error("Failed to create Java string");
+    }
+    return result;
+}
+
+size_t jstring_to_cdt(JNIEnv* env, jstring str, cdt& out)
+{
+    jsize length = env->GetStringLength(str);
+    jchar* units = utf16_buffer(static_cast<size_t>(length));
+    env->GetStringRegion(str, 0, length, units);
+    if(env->ExceptionCheck())
+    {
+        env->ExceptionClear();
+        throw std::runtime_error("Failed to read Java string");
+    }
+
+    return set_cdt_string8_from_utf16(out, units, static_cast<size_t>(length));
+}
+
+void set_cdt_string8(cdt& out, const char8_t* utf8, size_t size)
+{
+    char8_t* owned = xllr_alloc_string8(utf8, size);
+    if(!owned)
+    {
+        throw std::runtime_error("Failed to allocate string");
+    }
+
+    out.type = metaffi_string8_type;
+    out.cdt_val.string8_val = owned;
+    out.free_required = true;
+}
+
+bool load_string_array_helper(JNIEnv* env)
+{
+    if(g_helper.load(std::memory_order_acquire))
+    {
+        return true;
+    }
+
+    auto h = std::make_unique<string_array_helper>();
+
+    // the class outlives free_runtime() in the JVM, so a reload finds the earlier definition
+    jclass local = env->FindClass("metaffi/runtime/StringArrays");
+    if(!local)
+    {
+        env->ExceptionClear();
+        local = env->DefineClass("metaffi/runtime/StringArrays", nullptr,
+                                 reinterpret_cast<const jbyte*>(string_arrays_class), static_cast<jsize>(sizeof(string_arrays_class)));
+    }
+    h->cls = global_class(env, local);
+    h->string_array_cls = global_class(env, env->FindClass("[Ljava/lang/String;"));
+    if(h->cls)
+    {
+        h->split = env->GetStaticMethodID(h->cls, "split", "([C[I)[Ljava/lang/String;");
+        h->join = env->GetStaticMethodID(h->cls, "join", "([Ljava/lang/String;[I)[C");
+    }
+
+    if(!h->cls || !h->string_array_cls || !h->split || !h->join)
+    {
+        env->ExceptionClear();
+        delete_helper(env, *h);
+        return false;
+    }
+
+    g_helper.store(h.release(), std::memory_order_release);
+    return true;
+}
+
+void release_string_array_helper(JNIEnv* env)
+{
+    string_array_helper* h = g_helper.exchange(nullptr, std::memory_order_acq_rel);
+    if(!h)
+    {
+        return;
+    }
+
+    if(env)
+    {
+        delete_helper(env, *h);
+    }
+    delete h;
+}
+
+jobjectArray string_array_from_cdt(JNIEnv* env, cdt& item)
+{
+    string_array_helper* h = g_helper.load(std::memory_order_acquire);
+    if(!h || item.type != (metaffi_string8_type | metaffi_array_type))
+    {
+        return nullptr;
+    }
+
+    const cdts& src = static_cast<cdts&>(item);
+    if(src.fixed_dimensions != 1 || src.length < static_cast<metaffi_size>(bulk_string_array_min_length) ||
+       src.length > static_cast<metaffi_size>(std::numeric_limits<jsize>::max()))
+    {
+        return nullptr;
+    }
+
+    // first pass: validate the elements and bound the packed size (UTF-16 units <= UTF-8 bytes)
+    size_t bound = 0;
+    for(metaffi_size i = 0; i < src.length; i++)
+    {
+        const cdt& elem = src[i];
+        if(elem.type == metaffi_string8_type && elem.cdt_val.string8_val)
+        {
+            bound += std::char_traits<char8_t>::length(elem.cdt_val.string8_val);
+        }
+        else if(elem.type != metaffi_null_type && elem.type != metaffi_string8_type)
+        {
+            return nullptr;
+        }
+    }
+    if(bound > static_cast<size_t>(std::numeric_limits<jsize>::max()))
+    {
+        return nullptr;
+    }
+
+    jsize length = static_cast<jsize>(src.length);
+    jchar* units = utf16_buffer(bound);
+    jint* ends = ends_buffer(src.length);
+    size_t pos = 0;
+    for(jsize i = 0; i < length; i++)
+    {
+        const cdt& elem = src[i];
+        if(elem.type != metaffi_string8_type || !elem.cdt_val.string8_val)
+        {
+            ends[i] = ~static_cast<jint>(pos);
+            continue;
+        }
+        const char8_t* utf8 = elem.cdt_val.string8_val;
+        pos += utf8_to_utf16(utf8, std::char_traits<char8_t>::length(utf8), units + pos);
+        ends[i] = static_cast<jint>(pos);
+    }
+
+    jcharArray chars = env->NewCharArray(static_cast<jsize>(pos));
+    jintArray ends_arr = env->NewIntArray(length);
+    if(!chars || !ends_arr)
+    {
+        throw_helper_error(env, "Failed to allocate String[] buffers");
+    }
+    env->SetCharArrayRegion(chars, 0, static_cast<jsize>(pos), units);
+    env->SetIntArrayRegion(ends_arr, 0, length, ends);
+
+    jobjectArray result = (jobjectArray)env->CallStaticObjectMethod(h->cls, h->split, chars, ends_arr);
+    env->DeleteLocalRef(chars);
+    env->DeleteLocalRef(ends_arr);
+    if(env->ExceptionCheck() || !result)
+    {
+        throw_helper_error(env, "Failed to build String[]");
+    }
+
+    g_bulk_count.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+bool string_array_to_cdt(JNIEnv* env, jobjectArray arr, cdt& out)
+{
+    string_array_helper* h = g_helper.load(std::memory_order_acquire);
+    if(!h || !env->IsInstanceOf(arr, h->string_array_cls))
+    {
+        return false;
+    }
+
+    jsize length = env->GetArrayLength(arr);
+    if(length < bulk_string_array_min_length)
+    {
+        return false;
+    }
+
+    jintArray ends_arr = env->NewIntArray(length);
+    if(!ends_arr)
+    {
+        throw_helper_error(env, "Failed to allocate String[] buffers");
+    }
+    jcharArray chars = (jcharArray)env->CallStaticObjectMethod(h->cls, h->join, arr, ends_arr);
+    if(env->ExceptionCheck() || !chars)
+    {
+        env->DeleteLocalRef(ends_arr);
+        throw_helper_error(env, "Failed to read String[]");
+    }
+
+    jint* ends = ends_buffer(static_cast<size_t>(length));
+    env->GetIntArrayRegion(ends_arr, 0, length, ends);
+    jsize total = env->GetArrayLength(chars);
+    jchar* units = utf16_buffer(static_cast<size_t>(total));
+    env->GetCharArrayRegion(chars, 0, total, units);
+    env->DeleteLocalRef(ends_arr);
+    env->DeleteLocalRef(chars);
+
+    out.set_new_array(static_cast<metaffi_size>(length), 1, metaffi_string8_type);
+    cdts& dst = static_cast<cdts&>(out);
+    jint start = 0;
+    for(jsize i = 0; i < length; i++)
+    {
+        if(ends[i] < 0)
+        {
+            dst[i].type = metaffi_null_type;
+            continue;
+        }
+
+        set_cdt_string8_from_utf16(dst[i], units + start, static_cast<size_t>(ends[i] - start));
+        start = ends[i];
+    }
+
+    g_bulk_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t get_bulk_string_array_count()
+{
+    return g_bulk_count.load(std::memory_order_relaxed);
+}
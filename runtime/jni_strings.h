@@ -0,0 +1,44 @@
+#pragma once
+
+#include <jni.h>
+#include <runtime/cdt.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// string8 marshalling that bypasses JNI's modified UTF-8 (NewStringUTF/GetStringUTFChars).
+// Host strings are standard UTF-8, which modified UTF-8 does not cover: supplementary
+// characters are 4-byte sequences in UTF-8 but surrogate pairs in modified UTF-8.
+// Strings are transcoded directly to and from UTF-16 with NewString/GetStringRegion; the
+// ASCII prefix, the common case, is found and widened/narrowed with the SIMD kernels of
+// simd_convert.h. Invalid UTF-8 and unpaired surrogates are replaced with U+FFFD.
+
+// Returns a new local reference to a Java string holding the UTF-8 text.
+jstring utf8_to_jstring(JNIEnv* env, const char8_t* utf8, size_t length);
+
+// Writes str into out as a string8 owned by the cdt, transcoded in place into its xllr
+// allocation. Returns the UTF-8 size in bytes.
+size_t jstring_to_cdt(JNIEnv* env, jstring str, cdt& out);
+
+// Writes a copy of utf8 into out as a string8 owned by the cdt.
+void set_cdt_string8(cdt& out, const char8_t* utf8, size_t size);
+
+// Bulk String[] marshalling: the whole array crosses JNI as one packed char[] plus an
+// end-offset table, split and joined on the Java side by the metaffi.runtime.StringArrays
+// bootstrap class, which the runtime defines from bytes embedded at build time.
+// Applies to 1-D string8 arrays of at least 8 elements.
+
+// Defines the helper class. Returns false, leaving String[] to the serializer, if it is
+// unavailable. Not thread-safe with respect to release_string_array_helper().
+bool load_string_array_helper(JNIEnv* env);
+void release_string_array_helper(JNIEnv* env);
+
+// If item is an eligible string8 array, builds the String[] with one helper call.
+// Returns nullptr to leave the item to the serializer.
+jobjectArray string_array_from_cdt(JNIEnv* env, cdt& item);
+
+// If arr is an eligible String[], reads it with one helper call into out as a 1-D string8
+// array and returns true. Returns false to leave it to the serializer.
+bool string_array_to_cdt(JNIEnv* env, jobjectArray arr, cdt& out);
+
+uint64_t get_bulk_string_array_count();
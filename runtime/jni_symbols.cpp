@@ -0,0 +1,270 @@
+#include "jni_symbols.h"
+
+#include <runtime_manager/jvm/jni_helpers.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    std::atomic<jni_symbols*> g_symbols{nullptr};
+
+    void throw_lookup_error(JNIEnv* env, const std::string& what)
+    {
+        std::string msg = "Failed to resolve " + what;
+        if(env->ExceptionCheck())
+        {
+            std::string error = get_exception_description(env);
+            if(!error.empty())
+            {
+                msg += ": " + error;
+            }
+        }
+        throw std::runtime_error(msg);
+    }
+
+    jclass global_class(JNIEnv* env, const char* name)
+    {
+        jclass local = env->FindClass(name);
+        if(!local)
+        {
+            throw_lookup_error(env, name);
+        }
+        jclass global = (jclass)env->NewGlobalRef(local);
+        env->DeleteLocalRef(local);
+        if(!global)
+        {
+            throw std::runtime_error(std::string("Failed to create global reference for ") + name);
+        }
+        return global;
+    }
+
+    jmethodID method_id(JNIEnv* env, jclass cls, const char* name, const char* sig)
+    {
+        jmethodID id = env->GetMethodID(cls, name, sig);
+        if(!id)
+        {
+            throw_lookup_error(env, std::string(name) + sig);
+        }
+        return id;
+    }
+
+    jmethodID static_method_id(JNIEnv* env, jclass cls, const char* name, const char* sig)
+    {
+        jmethodID id = env->GetStaticMethodID(cls, name, sig);
+        if(!id)
+        {
+            throw_lookup_error(env, std::string(name) + sig);
+        }
+        return id;
+    }
+
+    void load_boxed_type(JNIEnv* env, jni_symbols::boxed_type& out, const char* cls, const char* value_of_sig, const char* unbox, const char* unbox_sig)
+    {
+        out.cls = global_class(env, cls);
+        out.value_of = static_method_id(env, out.cls, "valueOf", value_of_sig);
+        out.unbox = method_id(env, out.cls, unbox, unbox_sig);
+
+        jfieldID type_field = env->GetStaticFieldID(out.cls, "TYPE", "Ljava/lang/Class;");
+        if(!type_field)
+        {
+            throw_lookup_error(env, std::string(cls) + ".TYPE");
+        }
+        jclass primitive = (jclass)env->GetStaticObjectField(out.cls, type_field);
+        if(!primitive)
+        {
+            throw_lookup_error(env, std::string(cls) + ".TYPE");
+        }
+        out.primitive = (jclass)env->NewGlobalRef(primitive);
+        env->DeleteLocalRef(primitive);
+        if(!out.primitive)
+        {
+            throw std::runtime_error(std::string("Failed to create global reference for ") + cls + ".TYPE");
+        }
+    }
+
+    void delete_class(JNIEnv* env, jclass& cls)
+    {
+        if(cls)
+        {
+            env->DeleteGlobalRef(cls);
+            cls = nullptr;
+        }
+    }
+
+    void delete_symbols(JNIEnv* env, jni_symbols& s)
+    {
+        delete_class(env, s.boolean_type.cls);
+        delete_class(env, s.boolean_type.primitive);
+        delete_class(env, s.byte_type.cls);
+        delete_class(env, s.byte_type.primitive);
+        delete_class(env, s.short_type.cls);
+        delete_class(env, s.short_type.primitive);
+        delete_class(env, s.integer_type.cls);
+        delete_class(env, s.integer_type.primitive);
+        delete_class(env, s.long_type.cls);
+        delete_class(env, s.long_type.primitive);
+        delete_class(env, s.float_type.cls);
+        delete_class(env, s.float_type.primitive);
+        delete_class(env, s.double_type.cls);
+        delete_class(env, s.double_type.primitive);
+        delete_class(env, s.character_type.cls);
+        delete_class(env, s.character_type.primitive);
+        delete_class(env, s.number_cls);
+        delete_class(env, s.big_integer_cls);
+        delete_class(env, s.object_cls);
+        delete_class(env, s.object_array_cls);
+        delete_class(env, s.string_cls);
+        delete_class(env, s.system_cls);
+        delete_class(env, s.thread_cls);
+        delete_class(env, s.boolean_array_cls);
+        delete_class(env, s.byte_array_cls);
+        delete_class(env, s.short_array_cls);
+        delete_class(env, s.int_array_cls);
+        delete_class(env, s.long_array_cls);
+        delete_class(env, s.float_array_cls);
+        delete_class(env, s.double_array_cls);
+        delete_class(env, s.class_cls);
+        delete_class(env, s.class_loader_cls);
+        delete_class(env, s.class_not_found_cls);
+        delete_class(env, s.accessible_object_cls);
+        delete_class(env, s.method_cls);
+        delete_class(env, s.constructor_cls);
+        delete_class(env, s.field_cls);
+        delete_class(env, s.byte_buffer_cls);
+        delete_class(env, s.modifier_cls);
+    }
+}
+
+void load_jni_symbols(JNIEnv* env)
+{
+    if(g_symbols.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    auto s = std::make_unique<jni_symbols>();
+    try
+    {
+        load_boxed_type(env, s->boolean_type, "java/lang/Boolean", "(Z)Ljava/lang/Boolean;", "booleanValue", "()Z");
+        load_boxed_type(env, s->byte_type, "java/lang/Byte", "(B)Ljava/lang/Byte;", "byteValue", "()B");
+        load_boxed_type(env, s->short_type, "java/lang/Short", "(S)Ljava/lang/Short;", "shortValue", "()S");
+        load_boxed_type(env, s->integer_type, "java/lang/Integer", "(I)Ljava/lang/Integer;", "intValue", "()I");
+        load_boxed_type(env, s->long_type, "java/lang/Long", "(J)Ljava/lang/Long;", "longValue", "()J");
+        load_boxed_type(env, s->float_type, "java/lang/Float", "(F)Ljava/lang/Float;", "floatValue", "()F");
+        load_boxed_type(env, s->double_type, "java/lang/Double", "(D)Ljava/lang/Double;", "doubleValue", "()D");
+        load_boxed_type(env, s->character_type, "java/lang/Character", "(C)Ljava/lang/Character;", "charValue", "()C");
+
+        s->number_cls = global_class(env, "java/lang/Number");
+        s->number_byte_value = method_id(env, s->number_cls, "byteValue", "()B");
+        s->number_short_value = method_id(env, s->number_cls, "shortValue", "()S");
+        s->number_int_value = method_id(env, s->number_cls, "intValue", "()I");
+        s->number_long_value = method_id(env, s->number_cls, "longValue", "()J");
+        s->number_float_value = method_id(env, s->number_cls, "floatValue", "()F");
+        s->number_double_value = method_id(env, s->number_cls, "doubleValue", "()D");
+
+        s->big_integer_cls = global_class(env, "java/math/BigInteger");
+        s->big_integer_ctor = method_id(env, s->big_integer_cls, "<init>", "(I[B)V");
+        s->big_integer_zero = env->GetStaticFieldID(s->big_integer_cls, "ZERO", "Ljava/math/BigInteger;");
+        if(!s->big_integer_zero)
+        {
+            throw_lookup_error(env, "BigInteger.ZERO");
+        }
+        s->big_integer_bit_length = method_id(env, s->big_integer_cls, "bitLength", "()I");
+        s->big_integer_long_value = method_id(env, s->big_integer_cls, "longValue", "()J");
+
+        s->object_cls = global_class(env, "java/lang/Object");
+        s->object_get_class = method_id(env, s->object_cls, "getClass", "()Ljava/lang/Class;");
+        s->object_array_cls = global_class(env, "[Ljava/lang/Object;");
+
+        s->string_cls = global_class(env, "java/lang/String");
+        s->string_intern = method_id(env, s->string_cls, "intern", "()Ljava/lang/String;");
+        s->system_cls = global_class(env, "java/lang/System");
+        s->system_identity_hash_code = static_method_id(env, s->system_cls, "identityHashCode", "(Ljava/lang/Object;)I");
+        s->thread_cls = global_class(env, "java/lang/Thread");
+        s->thread_current_thread = static_method_id(env, s->thread_cls, "currentThread", "()Ljava/lang/Thread;");
+        s->thread_interrupt = method_id(env, s->thread_cls, "interrupt", "()V");
+        s->thread_interrupted = static_method_id(env, s->thread_cls, "interrupted", "()Z");
+
+        s->boolean_array_cls = global_class(env, "[Z");
+        s->byte_array_cls = global_class(env, "[B");
+        s->short_array_cls = global_class(env, "[S");
+        s->int_array_cls = global_class(env, "[I");
+        s->long_array_cls = global_class(env, "[J");
+        s->float_array_cls = global_class(env, "[F");
+        s->double_array_cls = global_class(env, "[D");
+
+        s->class_cls = global_class(env, "java/lang/Class");
+        s->class_get_name = method_id(env, s->class_cls, "getName", "()Ljava/lang/String;");
+        s->class_get_declared_method = method_id(env, s->class_cls, "getDeclaredMethod", "(Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;");
+        s->class_get_declared_constructor = method_id(env, s->class_cls, "getDeclaredConstructor", "([Ljava/lang/Class;)Ljava/lang/reflect/Constructor;");
+        s->class_get_declared_field = method_id(env, s->class_cls, "getDeclaredField", "(Ljava/lang/String;)Ljava/lang/reflect/Field;");
+        s->class_get_declared_fields = method_id(env, s->class_cls, "getDeclaredFields", "()[Ljava/lang/reflect/Field;");
+        s->class_for_name = static_method_id(env, s->class_cls, "forName", "(Ljava/lang/String;ZLjava/lang/ClassLoader;)Ljava/lang/Class;");
+
+        s->class_loader_cls = global_class(env, "java/lang/ClassLoader");
+        s->class_loader_get_resource = method_id(env, s->class_loader_cls, "getResource", "(Ljava/lang/String;)Ljava/net/URL;");
+        s->class_not_found_cls = global_class(env, "java/lang/ClassNotFoundException");
+
+        s->accessible_object_cls = global_class(env, "java/lang/reflect/AccessibleObject");
+        s->accessible_object_set_accessible = method_id(env, s->accessible_object_cls, "setAccessible", "(Z)V");
+
+        s->method_cls = global_class(env, "java/lang/reflect/Method");
+        s->method_invoke = method_id(env, s->method_cls, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+        s->method_get_modifiers = method_id(env, s->method_cls, "getModifiers", "()I");
+        s->method_get_return_type = method_id(env, s->method_cls, "getReturnType", "()Ljava/lang/Class;");
+
+        s->constructor_cls = global_class(env, "java/lang/reflect/Constructor");
+        s->constructor_new_instance = method_id(env, s->constructor_cls, "newInstance", "([Ljava/lang/Object;)Ljava/lang/Object;");
+
+        s->field_cls = global_class(env, "java/lang/reflect/Field");
+        s->field_get = method_id(env, s->field_cls, "get", "(Ljava/lang/Object;)Ljava/lang/Object;");
+        s->field_set = method_id(env, s->field_cls, "set", "(Ljava/lang/Object;Ljava/lang/Object;)V");
+        s->field_get_modifiers = method_id(env, s->field_cls, "getModifiers", "()I");
+        s->field_get_type = method_id(env, s->field_cls, "getType", "()Ljava/lang/Class;");
+
+        s->byte_buffer_cls = global_class(env, "java/nio/ByteBuffer");
+        s->buffer_position = method_id(env, s->byte_buffer_cls, "position", "()I");
+        s->buffer_limit = method_id(env, s->byte_buffer_cls, "limit", "()I");
+        s->byte_buffer_duplicate = method_id(env, s->byte_buffer_cls, "duplicate", "()Ljava/nio/ByteBuffer;");
+        s->byte_buffer_get_bytes = method_id(env, s->byte_buffer_cls, "get", "([B)Ljava/nio/ByteBuffer;");
+
+        s->modifier_cls = global_class(env, "java/lang/reflect/Modifier");
+        s->modifier_is_static = static_method_id(env, s->modifier_cls, "isStatic", "(I)Z");
+        s->modifier_is_final = static_method_id(env, s->modifier_cls, "isFinal", "(I)Z");
+    }
+    catch(...)
+    {
+        delete_symbols(env, *s);
+        throw;
+    }
+
+    g_symbols.store(s.release(), std::memory_order_release);
+}
+
+void release_jni_symbols(JNIEnv* env)
+{
+    jni_symbols* s = g_symbols.exchange(nullptr, std::memory_order_acq_rel);
+    if(!s)
+    {
+        return;
+    }
+
+    if(env)
+    {
+        delete_symbols(env, *s);
+    }
+    delete s;
+}
+
+const jni_symbols& get_jni_symbols()
+{
+    jni_symbols* s = g_symbols.load(std::memory_order_acquire);
+    if(!s)
+    {
+        throw std::runtime_error("JNI symbols are not loaded");
+    }
+    return *s;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <jni.h>
+
+// Process-wide cache of JNI classes, method IDs and field IDs used by the JVM runtime plugin.
+// Populated once in load_runtime() and released in free_runtime(); all classes are global refs.
+struct jni_symbols
+{
+    struct boxed_type
+    {
+        jclass cls = nullptr;
+        jmethodID value_of = nullptr; // static valueOf(primitive)
+        jmethodID unbox = nullptr;    // <primitive>Value()
+        jclass primitive = nullptr;   // TYPE, the primitive's class (int.class)
+    };
+
+    boxed_type boolean_type;
+    boxed_type byte_type;
+    boxed_type short_type;
+    boxed_type integer_type;
+    boxed_type long_type;
+    boxed_type float_type;
+    boxed_type double_type;
+    boxed_type character_type;
+
+    jclass number_cls = nullptr;
+    jmethodID number_byte_value = nullptr;
+    jmethodID number_short_value = nullptr;
+    jmethodID number_int_value = nullptr;
+    jmethodID number_long_value = nullptr;
+    jmethodID number_float_value = nullptr;
+    jmethodID number_double_value = nullptr;
+
+    jclass big_integer_cls = nullptr;
+    jmethodID big_integer_ctor = nullptr; // BigInteger(int signum, byte[] magnitude)
+    jfieldID big_integer_zero = nullptr;
+    jmethodID big_integer_bit_length = nullptr;
+    jmethodID big_integer_long_value = nullptr;
+
+    jclass object_cls = nullptr;
+    jmethodID object_get_class = nullptr;
+    jclass object_array_cls = nullptr; // Object[]
+
+    jclass string_cls = nullptr;
+    jmethodID string_intern = nullptr;
+
+    jclass system_cls = nullptr;
+    jmethodID system_identity_hash_code = nullptr;
+
+    jclass thread_cls = nullptr;
+    jmethodID thread_current_thread = nullptr;
+    jmethodID thread_interrupt = nullptr;
+    jmethodID thread_interrupted = nullptr; // static; reads and clears the current thread's flag
+
+    // primitive array classes, used to type-check arrays before bulk copies
+    jclass boolean_array_cls = nullptr;
+    jclass byte_array_cls = nullptr;
+    jclass short_array_cls = nullptr;
+    jclass int_array_cls = nullptr;
+    jclass long_array_cls = nullptr;
+    jclass float_array_cls = nullptr;
+    jclass double_array_cls = nullptr;
+
+    jclass class_cls = nullptr;
+    jmethodID class_get_name = nullptr;
+    jmethodID class_get_declared_method = nullptr;
+    jmethodID class_get_declared_constructor = nullptr;
+    jmethodID class_get_declared_field = nullptr;
+    jmethodID class_get_declared_fields = nullptr;
+    jmethodID class_for_name = nullptr; // static forName(String, boolean, ClassLoader)
+
+    jclass class_loader_cls = nullptr;
+    jmethodID class_loader_get_resource = nullptr;
+    jclass class_not_found_cls = nullptr; // java.lang.ClassNotFoundException
+
+    jclass accessible_object_cls = nullptr;
+    jmethodID accessible_object_set_accessible = nullptr;
+
+    jclass method_cls = nullptr;
+    jmethodID method_invoke = nullptr;
+    jmethodID method_get_modifiers = nullptr;
+    jmethodID method_get_return_type = nullptr;
+
+    jclass constructor_cls = nullptr;
+    jmethodID constructor_new_instance = nullptr;
+
+    jclass field_cls = nullptr;
+    jmethodID field_get = nullptr;
+    jmethodID field_set = nullptr;
+    jmethodID field_get_modifiers = nullptr;
+    jmethodID field_get_type = nullptr;
+
+    jclass byte_buffer_cls = nullptr;
+    jmethodID buffer_position = nullptr;
+    jmethodID buffer_limit = nullptr;
+    jmethodID byte_buffer_duplicate = nullptr;
+    jmethodID byte_buffer_get_bytes = nullptr; // get(byte[])
+
+    jclass modifier_cls = nullptr;
+    jmethodID modifier_is_static = nullptr;
+    jmethodID modifier_is_final = nullptr;
+};
+
+// Resolves all symbols. Throws std::runtime_error if any lookup fails. Not thread-safe with
+// respect to release_jni_symbols(); callers serialize both under the runtime mutex.
+void load_jni_symbols(JNIEnv* env);
+
+// Deletes the cached global references. Safe to call when symbols were never loaded.
+void release_jni_symbols(JNIEnv* env);
+
+// Returns the loaded symbols. Throws std::runtime_error if load_jni_symbols() was not called.
+const jni_symbols& get_jni_symbols();
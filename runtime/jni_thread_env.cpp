@@ -0,0 +1,111 @@
+#include "jni_thread_env.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    std::atomic<JavaVM*> g_vm{nullptr};
+
+    // bumped whenever the JVM is registered or released, so attachments made against a
+    // previous JVM are recognized as stale
+    std::atomic<uint64_t> g_generation{0};
+
+    std::atomic<uint64_t> g_attaches{0};
+    std::atomic<uint64_t> g_detaches{0};
+
+    struct thread_attachment
+    {
+        JNIEnv* env = nullptr;
+        uint64_t generation = 0;
+        bool attached_here = false;
+
+        ~thread_attachment()
+        {
+            detach();
+        }
+
+        void detach()
+        {
+            if(attached_here)
+            {
+                JavaVM* vm = g_vm.load(std::memory_order_acquire);
+                if(vm && generation == g_generation.load(std::memory_order_acquire))
+                {
+                    vm->DetachCurrentThread();
+                    g_detaches.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            env = nullptr;
+            attached_here = false;
+        }
+    };
+
+    thread_local thread_attachment t_attachment;
+}
+
+void set_thread_env_jvm(JavaVM* vm)
+{
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+    g_vm.store(vm, std::memory_order_release);
+}
+
+void release_thread_env_jvm()
+{
+    t_attachment.detach();
+    g_vm.store(nullptr, std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+JNIEnv* get_thread_env()
+{
+    uint64_t generation = g_generation.load(std::memory_order_acquire);
+    if(t_attachment.env && t_attachment.generation == generation)
+    {
+        return t_attachment.env;
+    }
+
+    JavaVM* vm = g_vm.load(std::memory_order_acquire);
+    if(!vm)
+    {
+        throw std::runtime_error("JVM is not loaded");
+    }
+
+    // a stale attachment belongs to a JVM that no longer exists
+    t_attachment.env = nullptr;
+    t_attachment.attached_here = false;
+
+    JNIEnv* env = nullptr;
+    jint rc = vm->GetEnv((void**)&env, JNI_VERSION_1_8);
+    if(rc == JNI_EDETACHED)
+    {
+        JavaVMAttachArgs args{JNI_VERSION_1_8, const_cast<char*>("metaffi-host-thread"), nullptr};
+        rc = vm->AttachCurrentThreadAsDaemon((void**)&env, &args);
+        if(rc != JNI_OK || !env)
+        {
+            throw std::runtime_error("Failed to attach thread to JVM. Error code: " + std::to_string(rc));
+        }
+        t_attachment.attached_here = true;
+        g_attaches.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if(rc != JNI_OK || !env)
+    {
+        throw std::runtime_error("Failed to get JNIEnv. Error code: " + std::to_string(rc));
+    }
+
+    t_attachment.env = env;
+    t_attachment.generation = generation;
+    return env;
+}
+
+uint64_t get_thread_env_attach_count()
+{
+    return g_attaches.load(std::memory_order_relaxed);
+}
+
+uint64_t get_thread_env_detach_count()
+{
+    return g_detaches.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+
+// Persistent per-thread JNIEnv attachment.
+// A host thread is attached to the JVM the first time it needs a JNIEnv and stays attached
+// (as a daemon thread) until the thread exits, where it is detached automatically.
+// Threads that were already attached (e.g. Java threads calling back into the host) are
+// used as-is and never detached by this module.
+
+// Registers the JVM to attach to. Called by load_runtime() once the JVM is up.
+void set_thread_env_jvm(JavaVM* vm);
+
+// Forgets the JVM. Detaches the calling thread if it was attached here; other threads'
+// attachments become stale and are not detached from the destroyed JVM at thread exit.
+void release_thread_env_jvm();
+
+// Returns the calling thread's JNIEnv, attaching the thread on first use.
+// Throws std::runtime_error if no JVM is registered or attaching fails.
+JNIEnv* get_thread_env();
+
+uint64_t get_thread_env_attach_count();
+uint64_t get_thread_env_detach_count();
@@ -0,0 +1,153 @@
+#include "jvm_call_watchdog.h"
+#include "jni_symbols.h"
+#include "jni_thread_env.h"
+
+#include <stdexcept>
+
+jvm_call_watchdog::jvm_call_watchdog()
+{
+    _thread = std::thread([this]() { watchdog_main(); });
+}
+
+jvm_call_watchdog::~jvm_call_watchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_one();
+    _thread.join();
+}
+
+uint64_t jvm_call_watchdog::begin(JNIEnv* env, const void* owner, clock::time_point deadline)
+{
+    const jni_symbols& symbols = get_jni_symbols();
+    jobject local = env->CallStaticObjectMethod(symbols.thread_cls, symbols.thread_current_thread);
+    jobject thread = local ? env->NewGlobalRef(local) : nullptr;
+    if(local)
+    {
+        env->DeleteLocalRef(local);
+    }
+    if(!thread)
+    {
+        env->ExceptionClear();
+        throw std::runtime_error("Failed to resolve the Java thread of the call");
+    }
+
+    bool earliest = false;
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        id = _next_id++;
+        watched_call& call = _calls[id];
+        call.thread = thread;
+        call.owner = owner;
+        if(deadline != clock::time_point::max())
+        {
+            call.deadline_pos = _deadlines.emplace(deadline, id);
+            call.deadline_pending = true;
+            earliest = call.deadline_pos == _deadlines.begin();
+        }
+    }
+
+    if(earliest)
+    {
+        _wake.notify_one();
+    }
+    return id;
+}
+
+jvm_call_watchdog::outcome jvm_call_watchdog::end(JNIEnv* env, uint64_t id)
+{
+    watched_call call;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _calls.find(id);
+        if(it == _calls.end())
+        {
+            return outcome::completed;
+        }
+        call = it->second;
+        if(call.deadline_pending)
+        {
+            _deadlines.erase(call.deadline_pos);
+        }
+        _calls.erase(it);
+    }
+
+    env->DeleteGlobalRef(call.thread);
+    if(call.state != outcome::completed)
+    {
+        const jni_symbols& symbols = get_jni_symbols();
+        env->CallStaticBooleanMethod(symbols.thread_cls, symbols.thread_interrupted);
+        env->ExceptionClear();
+    }
+    return call.state;
+}
+
+size_t jvm_call_watchdog::cancel(JNIEnv* env, const void* owner)
+{
+    size_t cancelled = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto& [id, call] : _calls)
+    {
+        if(call.owner == owner && call.state == outcome::completed)
+        {
+            interrupt(env, call, outcome::cancelled);
+            cancelled++;
+        }
+    }
+    return cancelled;
+}
+
+// called under _mutex, so the thread is never interrupted after end() unregistered its call
+void jvm_call_watchdog::interrupt(JNIEnv* env, watched_call& call, outcome reason)
+{
+    call.state = reason;
+    if(env)
+    {
+        env->CallVoidMethod(call.thread, get_jni_symbols().thread_interrupt);
+        env->ExceptionClear();
+    }
+}
+
+void jvm_call_watchdog::watchdog_main()
+{
+    JNIEnv* env = nullptr;
+    try
+    {
+        env = get_thread_env();
+    }
+    catch(const std::exception&)
+    {
+        // expired calls are still reported as timed out when they return
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(!_stop)
+    {
+        if(_deadlines.empty())
+        {
+            _wake.wait(lock);
+            continue;
+        }
+
+        auto first = _deadlines.begin();
+        if(first->first > clock::now())
+        {
+            _wake.wait_until(lock, first->first);
+            continue;
+        }
+
+        auto it = _calls.find(first->second);
+        _deadlines.erase(first);
+        if(it != _calls.end())
+        {
+            it->second.deadline_pending = false;
+            if(it->second.state == outcome::completed)
+            {
+                interrupt(env, it->second, outcome::timed_out);
+            }
+        }
+    }
+}
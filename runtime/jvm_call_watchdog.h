@@ -0,0 +1,71 @@
+#pragma once
+
+#include <jni.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Deadlines and cancellation for in-flight Java calls.
+// A watched call is registered for the duration of its JNI invocation together with the Java
+// thread executing it. One watchdog thread, attached to the JVM, interrupts that thread
+// (Thread.interrupt) when the call's deadline passes; cancel() does the same on request.
+// Java code blocked interruptibly (sleep, wait, interruptible channels, java.util.concurrent)
+// returns promptly; code that never checks for interruption runs on, and the call reports
+// the timeout once it returns.
+class jvm_call_watchdog
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    enum class outcome
+    {
+        completed,
+        timed_out,
+        cancelled
+    };
+
+    jvm_call_watchdog();
+
+    // Stops the watchdog thread; calls still registered are no longer interrupted.
+    ~jvm_call_watchdog();
+
+    jvm_call_watchdog(const jvm_call_watchdog&) = delete;
+    jvm_call_watchdog& operator=(const jvm_call_watchdog&) = delete;
+
+    // Registers the calling thread's call on behalf of owner (the entity). A deadline of
+    // clock::time_point::max() registers a call that can only be cancelled.
+    uint64_t begin(JNIEnv* env, const void* owner, clock::time_point deadline);
+
+    // Unregisters the call and tells whether it was interrupted. An interrupted thread's
+    // interrupt status is cleared so it does not leak into the thread's next call.
+    outcome end(JNIEnv* env, uint64_t id);
+
+    // Interrupts the in-flight calls of owner. Returns how many were interrupted.
+    size_t cancel(JNIEnv* env, const void* owner);
+
+private:
+    struct watched_call
+    {
+        jobject thread = nullptr; // global ref to the executing java.lang.Thread
+        const void* owner = nullptr;
+        std::multimap<clock::time_point, uint64_t>::iterator deadline_pos;
+        bool deadline_pending = false; // deadline_pos is still in _deadlines
+        outcome state = outcome::completed;
+    };
+
+    void interrupt(JNIEnv* env, watched_call& call, outcome reason);
+    void watchdog_main();
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::unordered_map<uint64_t, watched_call> _calls;
+    std::multimap<clock::time_point, uint64_t> _deadlines;
+    uint64_t _next_id = 1;
+    bool _stop = false;
+    std::thread _thread;
+};
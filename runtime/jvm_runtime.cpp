@@ -15,16 +15,38 @@
 #include <utils/env_utils.h>
 #include <utils/logger.hpp>
 #include <utils/scope_guard.hpp>
+#include "jni_array_cache.h"
+#include "jni_class_cache.h"
+#include "jvm_call_watchdog.h"
+#include "jni_futures.h"
+#include "jni_primitive_arrays.h"
+#include "jni_string_cache.h"
+#include "jni_strings.h"
+#include "jni_symbols.h"
+#include "jni_thread_env.h"
+#include "jvm_runtime_api.h"
+#include "jvm_runtime_epoch.h"
+#include "jvm_worker_pool.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 using metaffi::utils::cdts_jvm_serializer;
@@ -33,6 +55,109 @@ static auto LOG = metaffi::get_logger("jvm.runtime");
 
 namespace
 {
+    // Per-thread bump allocator behind call_serializer::scratch. Chunks are kept once grown,
+    // so steady-state calls do not touch the heap. Calls on a thread nest (a callback calling
+    // back into Java), so space is released by rewinding to the position a call started at.
+    class scratch_arena
+    {
+    public:
+        struct mark
+        {
+            size_t chunk = 0;
+            size_t used = 0;
+        };
+
+        mark position() const { return {_chunk, _used}; }
+
+        // only moves back, so serializers of one call may be destroyed in any order
+        void rewind(const mark& m)
+        {
+            if(m.chunk < _chunk || (m.chunk == _chunk && m.used < _used))
+            {
+                _chunk = m.chunk;
+                _used = m.used;
+            }
+        }
+
+        uint8_t* allocate(size_t size)
+        {
+            size = std::max<size_t>(size, 1);
+            for(; _chunk < _chunks.size(); _chunk++, _used = 0)
+            {
+                chunk& c = _chunks[_chunk];
+                if(c.size - _used >= size)
+                {
+                    uint8_t* p = c.data.get() + _used;
+                    _used += size;
+                    return p;
+                }
+            }
+
+            size_t chunk_size = std::max(size, _chunks.empty() ? min_chunk_size : _chunks.back().size * 2);
+            _chunks.push_back(chunk{std::unique_ptr<uint8_t[]>(new uint8_t[chunk_size]), chunk_size});
+            _used = size;
+            return _chunks.back().data.get();
+        }
+
+        static scratch_arena& for_thread()
+        {
+            thread_local scratch_arena arena;
+            return arena;
+        }
+
+    private:
+        struct chunk
+        {
+            std::unique_ptr<uint8_t[]> data;
+            size_t size = 0;
+        };
+
+        static constexpr size_t min_chunk_size = 64 * 1024;
+
+        std::vector<chunk> _chunks;
+        size_t _chunk = 0; // chunk allocations are served from
+        size_t _used = 0;  // bytes taken from it
+    };
+
+    // Serializer over one of the call's cdts that also exposes the current cdt, for the
+    // paths that marshal a whole array themselves (see jni_primitive_arrays.h)
+    class call_serializer : public cdts_jvm_serializer
+    {
+    public:
+        call_serializer(JNIEnv* env, cdts& data, jobject class_loader) : cdts_jvm_serializer(env, data, class_loader), _data(data), _class_loader(class_loader)
+        {
+        }
+
+        ~call_serializer()
+        {
+            if(_arena)
+            {
+                _arena->rewind(_scratch_start);
+            }
+        }
+
+        cdt& current() { return _data[get_index()]; }
+        void skip() { set_index(get_index() + 1); }
+        jobject class_loader() const { return _class_loader; }
+
+        // native memory that lives until the end of the call (the serializer's lifetime)
+        uint8_t* scratch(size_t size)
+        {
+            if(!_arena)
+            {
+                _arena = &scratch_arena::for_thread();
+                _scratch_start = _arena->position();
+            }
+            return _arena->allocate(size);
+        }
+
+    private:
+        cdts& _data;
+        jobject _class_loader;
+        scratch_arena* _arena = nullptr; // of the thread that first asked for scratch memory
+        scratch_arena::mark _scratch_start;
+    };
+
     bool trace_enabled()
     {
         static int enabled = -1;
@@ -111,40 +236,35 @@ namespace
         return candidates;
     }
 
-    jclass load_class_with_fallback(jni_class_loader& loader, const std::string& class_name)
+    // Resolves through the shared child loader's class cache; loader (the module's) is asked
+    // directly only when no candidate resolves, for its error.
+    jclass load_class_candidates(JNIEnv* env, jni_class_loader& loader, const std::vector<std::string>& candidates)
     {
-        std::string normalized = to_dotted_name(class_name);
-        std::string last_error;
-
-        for(const auto& candidate : build_class_candidates(normalized))
+        std::string error;
+        if(jclass cls = find_class_candidates(env, jni_class_loader::get_child_class_loader(), candidates, error))
         {
-            try
-            {
-                return (jclass)loader.load_class(candidate);
-            }
-            catch(const std::exception& e)
-            {
-                last_error = e.what();
-            }
+            return cls;
         }
 
-        throw std::runtime_error(last_error.empty() ? ("Failed to load Java class: " + normalized) : last_error);
-    }
-
-    jclass load_array_class_with_fallback(jni_class_loader& loader, const std::string& descriptor)
-    {
-        std::string binary = descriptor;
-        std::replace(binary.begin(), binary.end(), '/', '.');
-        std::string last_error;
-
         try
         {
-            return (jclass)loader.load_class(binary);
+            return (jclass)loader.load_class(candidates.front());
         }
         catch(const std::exception& e)
         {
-            last_error = e.what();
+            throw std::runtime_error(error.empty() ? std::string(e.what()) : error);
         }
+    }
+
+    jclass load_class_with_fallback(JNIEnv* env, jni_class_loader& loader, const std::string& class_name)
+    {
+        return load_class_candidates(env, loader, build_class_candidates(to_dotted_name(class_name)));
+    }
+
+    jclass load_array_class_with_fallback(JNIEnv* env, jni_class_loader& loader, const std::string& descriptor)
+    {
+        std::string binary = to_dotted_name(descriptor);
+        std::vector<std::string> candidates;
 
         auto pos = binary.find('L');
         auto end = binary.rfind(';');
@@ -154,43 +274,139 @@ namespace
             std::string type_name = binary.substr(pos + 1, end - pos - 1);
             std::string suffix = binary.substr(end);
 
+            // the first candidate is the element name as given, i.e. binary itself
             for(const auto& candidate : build_class_candidates(type_name))
             {
-                std::string candidate_binary = prefix + candidate + suffix;
-                try
-                {
-                    return (jclass)loader.load_class(candidate_binary);
-                }
-                catch(const std::exception& e)
-                {
-                    last_error = e.what();
-                }
+                candidates.push_back(prefix + candidate + suffix);
             }
         }
+        else
+        {
+            candidates.push_back(binary);
+        }
 
-        throw std::runtime_error(last_error.empty() ? ("Failed to load Java array class: " + binary) : last_error);
+        return load_class_candidates(env, loader, candidates);
     }
 
-    jclass get_primitive_class(JNIEnv* env, const char* wrapper_class_name)
+    // Classes resolve_jclass hands out: scalar types come from the symbol table, loaded once
+    // per runtime; the Caller class is found on first use, and array classes are memoized by
+    // (type, dimensions, alias). All are global refs, which delete_local_ref_if_needed leaves
+    // alone. Released by free_runtime().
+    std::shared_mutex g_jclass_memo_mutex;
+    std::unordered_map<std::string, jclass> g_array_jclasses;
+    jclass g_caller_cls = nullptr; // metaffi.api.accessor.Caller
+    constexpr size_t max_array_jclasses = 4096;
+
+    jclass scalar_jclass(const jni_symbols& sym, metaffi_type type)
+    {
+        switch(type)
+        {
+            case metaffi_bool_type: return sym.boolean_type.primitive;
+            case metaffi_int8_type: return sym.byte_type.primitive;
+            case metaffi_uint8_type: return sym.short_type.primitive;
+            case metaffi_int16_type: return sym.short_type.primitive;
+            case metaffi_uint16_type: return sym.integer_type.primitive;
+            case metaffi_int32_type: return sym.integer_type.primitive;
+            case metaffi_uint32_type: return sym.long_type.primitive;
+            case metaffi_int64_type: return sym.long_type.primitive;
+            case metaffi_size_type: return sym.long_type.primitive;
+            case metaffi_float32_type: return sym.float_type.primitive;
+            case metaffi_float64_type: return sym.double_type.primitive;
+            case metaffi_char8_type:
+            case metaffi_char16_type:
+            case metaffi_char32_type:
+                return sym.character_type.primitive;
+            case metaffi_string8_type:
+            case metaffi_string16_type:
+            case metaffi_string32_type:
+                return sym.string_cls;
+            case metaffi_uint64_type:
+                return sym.big_integer_cls;
+            default:
+                return nullptr;
+        }
+    }
+
+    jclass caller_jclass(JNIEnv* env)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(g_jclass_memo_mutex);
+            if(g_caller_cls)
+            {
+                return g_caller_cls;
+            }
+        }
+
+        jclass local = env->FindClass("metaffi/api/accessor/Caller");
+        if(!local)
+        {
+            return nullptr;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(g_jclass_memo_mutex);
+        if(!g_caller_cls)
+        {
+            g_caller_cls = (jclass)env->NewGlobalRef(local);
+        }
+        env->DeleteLocalRef(local);
+        return g_caller_cls;
+    }
+
+    std::string array_jclass_key(const metaffi_type_info& type_info, bool through_loader)
+    {
+        std::string key = std::to_string(type_info.type);
+        key += ':';
+        key += std::to_string(type_info.fixed_dimensions);
+        key += through_loader ? ":L:" : ":F:";
+        if(type_info.alias)
+        {
+            key += type_info.alias;
+        }
+        return key;
+    }
+
+    // resolve builds the class on a miss; a failure is not memoized
+    template<typename Resolve>
+    jclass memoized_array_jclass(JNIEnv* env, const std::string& key, Resolve&& resolve)
     {
-        jclass wrapper = env->FindClass(wrapper_class_name);
-        if(!wrapper)
         {
-            throw std::runtime_error("Failed to find wrapper class");
+            std::shared_lock<std::shared_mutex> lock(g_jclass_memo_mutex);
+            auto it = g_array_jclasses.find(key);
+            if(it != g_array_jclasses.end())
+            {
+                return it->second;
+            }
         }
-        jfieldID type_field = env->GetStaticFieldID(wrapper, "TYPE", "Ljava/lang/Class;");
-        if(!type_field)
+
+        jclass cls = resolve();
+        std::unique_lock<std::shared_mutex> lock(g_jclass_memo_mutex);
+        if(g_array_jclasses.size() < max_array_jclasses && g_array_jclasses.count(key) == 0)
         {
-            env->DeleteLocalRef(wrapper);
-            throw std::runtime_error("Failed to get TYPE field");
+            jclass global = (jclass)env->NewGlobalRef(cls);
+            if(global)
+            {
+                g_array_jclasses.emplace(key, global);
+            }
         }
-        jclass prim = (jclass)env->GetStaticObjectField(wrapper, type_field);
-        env->DeleteLocalRef(wrapper);
-        if(!prim)
+        return cls;
+    }
+
+    void release_jclass_memo(JNIEnv* env)
+    {
+        std::unique_lock<std::shared_mutex> lock(g_jclass_memo_mutex);
+        if(env)
         {
-            throw std::runtime_error("Failed to get primitive class");
+            for(auto& [key, cls] : g_array_jclasses)
+            {
+                env->DeleteGlobalRef(cls);
+            }
+            if(g_caller_cls)
+            {
+                env->DeleteGlobalRef(g_caller_cls);
+            }
         }
-        return prim;
+        g_array_jclasses.clear();
+        g_caller_cls = nullptr;
     }
 
     struct alias_array_info
@@ -275,52 +491,40 @@ namespace
                 throw std::runtime_error("Array type requires fixed_dimensions");
             }
 
-            std::string desc;
-            desc.reserve(static_cast<size_t>(type_info.fixed_dimensions) + 8);
-            for(int i = 0; i < type_info.fixed_dimensions; i++)
+            return memoized_array_jclass(env, array_jclass_key(type_info, loader != nullptr), [&]()
             {
-                desc.push_back('[');
-            }
-            desc += descriptor_for_base(base_type(type), type_info);
+                std::string desc;
+                desc.reserve(static_cast<size_t>(type_info.fixed_dimensions) + 8);
+                for(int i = 0; i < type_info.fixed_dimensions; i++)
+                {
+                    desc.push_back('[');
+                }
+                desc += descriptor_for_base(base_type(type), type_info);
 
-            if(loader)
-            {
-                return load_array_class_with_fallback(*loader, desc);
-            }
+                if(loader)
+                {
+                    return load_array_class_with_fallback(env, *loader, desc);
+                }
 
-            jclass arr_cls = env->FindClass(desc.c_str());
-            if(!arr_cls)
-            {
-                throw std::runtime_error("Failed to resolve array class: " + desc);
-            }
-            return arr_cls;
+                jclass arr_cls = env->FindClass(desc.c_str());
+                if(!arr_cls)
+                {
+                    throw std::runtime_error("Failed to resolve array class: " + desc);
+                }
+                return arr_cls;
+            });
+        }
+
+        const auto& sym = get_jni_symbols();
+        if(jclass cls = scalar_jclass(sym, type))
+        {
+            return cls;
         }
 
         switch(type)
         {
-            case metaffi_bool_type: return get_primitive_class(env, "java/lang/Boolean");
-            case metaffi_int8_type: return get_primitive_class(env, "java/lang/Byte");
-            case metaffi_uint8_type: return get_primitive_class(env, "java/lang/Short");
-            case metaffi_int16_type: return get_primitive_class(env, "java/lang/Short");
-            case metaffi_uint16_type: return get_primitive_class(env, "java/lang/Integer");
-            case metaffi_int32_type: return get_primitive_class(env, "java/lang/Integer");
-            case metaffi_uint32_type: return get_primitive_class(env, "java/lang/Long");
-            case metaffi_int64_type: return get_primitive_class(env, "java/lang/Long");
-            case metaffi_size_type: return get_primitive_class(env, "java/lang/Long");
-            case metaffi_float32_type: return get_primitive_class(env, "java/lang/Float");
-            case metaffi_float64_type: return get_primitive_class(env, "java/lang/Double");
-            case metaffi_char8_type:
-            case metaffi_char16_type:
-            case metaffi_char32_type:
-                return get_primitive_class(env, "java/lang/Character");
-            case metaffi_string8_type:
-            case metaffi_string16_type:
-            case metaffi_string32_type:
-                return env->FindClass("java/lang/String");
-            case metaffi_uint64_type:
-                return env->FindClass("java/math/BigInteger");
             case metaffi_callable_type:
-                return env->FindClass("metaffi/api/accessor/Caller");
+                return caller_jclass(env);
             case metaffi_handle_type:
             {
                 std::string alias = resolve_handle_alias(type_info);
@@ -329,26 +533,29 @@ namespace
                     auto parsed = parse_alias_array(alias);
                     if(parsed.dims > 0)
                     {
-                        std::string desc(static_cast<size_t>(parsed.dims), '[');
-                        desc += "L" + to_internal_name(parsed.base) + ";";
-                        if(loader)
+                        return memoized_array_jclass(env, array_jclass_key(type_info, loader != nullptr), [&]()
                         {
-                            return load_array_class_with_fallback(*loader, desc);
-                        }
-
-                        jclass arr_cls = env->FindClass(desc.c_str());
-                        if(!arr_cls)
-                        {
-                            throw std::runtime_error("Failed to resolve handle alias array class: " + alias);
-                        }
-                        return arr_cls;
+                            std::string desc(static_cast<size_t>(parsed.dims), '[');
+                            desc += "L" + to_internal_name(parsed.base) + ";";
+                            if(loader)
+                            {
+                                return load_array_class_with_fallback(env, *loader, desc);
+                            }
+
+                            jclass arr_cls = env->FindClass(desc.c_str());
+                            if(!arr_cls)
+                            {
+                                throw std::runtime_error("Failed to resolve handle alias array class: " + alias);
+                            }
+                            return arr_cls;
+                        });
                     }
 
                     std::string name = to_internal_name(parsed.base);
                     jclass cls = nullptr;
                     if(loader)
                     {
-                        cls = load_class_with_fallback(*loader, to_dotted_name(name));
+                        cls = load_class_with_fallback(env, *loader, to_dotted_name(name));
                     }
                     else
                     {
@@ -360,47 +567,26 @@ namespace
                     }
                     return cls;
                 }
-                return env->FindClass("java/lang/Object");
+                return sym.object_cls;
             }
             case metaffi_any_type:
             case metaffi_null_type:
             default:
-                return env->FindClass("java/lang/Object");
+                return sym.object_cls;
         }
     }
 
     jobject create_big_integer(JNIEnv* env, uint64_t value)
     {
-        jclass big_int_cls = env->FindClass("java/math/BigInteger");
-        if(!big_int_cls)
-        {
-            throw std::runtime_error("Failed to find BigInteger class");
-        }
-
+        const auto& sym = get_jni_symbols();
         if(value == 0)
         {
-            jfieldID zero_field = env->GetStaticFieldID(big_int_cls, "ZERO", "Ljava/math/BigInteger;");
-            if(!zero_field)
-            {
-                env->DeleteLocalRef(big_int_cls);
-                throw std::runtime_error("Failed to get BigInteger.ZERO");
-            }
-            jobject zero_obj = env->GetStaticObjectField(big_int_cls, zero_field);
-            env->DeleteLocalRef(big_int_cls);
-            return zero_obj;
-        }
-
-        jmethodID ctor = env->GetMethodID(big_int_cls, "<init>", "(I[B)V");
-        if(!ctor)
-        {
-            env->DeleteLocalRef(big_int_cls);
-            throw std::runtime_error("Failed to get BigInteger constructor");
+            return env->GetStaticObjectField(sym.big_integer_cls, sym.big_integer_zero);
         }
 
         jbyteArray bytes = env->NewByteArray(8);
         if(!bytes)
         {
-            env->DeleteLocalRef(big_int_cls);
             throw std::runtime_error("Failed to allocate BigInteger byte array");
         }
 
@@ -411,11 +597,11 @@ namespace
         }
 
         env->SetByteArrayRegion(bytes, 0, 8, buf);
-        jobject big = env->NewObject(big_int_cls, ctor, 1, bytes);
+        jobject big = env->NewObject(sym.big_integer_cls, sym.big_integer_ctor, 1, bytes);
         env->DeleteLocalRef(bytes);
-        env->DeleteLocalRef(big_int_cls);
         return big;
     }
+
     uint64_t big_integer_to_uint64(JNIEnv* env, jobject big_int)
     {
         if(!big_int)
@@ -423,65 +609,17 @@ namespace
             return 0;
         }
 
-        jclass cls = env->FindClass("java/math/BigInteger");
-        if(!cls)
-        {
-            throw std::runtime_error("Failed to find BigInteger class");
-        }
-
-        jmethodID bit_length = env->GetMethodID(cls, "bitLength", "()I");
-        jmethodID long_value = env->GetMethodID(cls, "longValue", "()J");
-        if(!bit_length || !long_value)
-        {
-            env->DeleteLocalRef(cls);
-            throw std::runtime_error("Failed to get BigInteger methods");
-        }
-
-        jint bits = env->CallIntMethod(big_int, bit_length);
+        const auto& sym = get_jni_symbols();
+        jint bits = env->CallIntMethod(big_int, sym.big_integer_bit_length);
         if(bits > 64)
         {
-            env->DeleteLocalRef(cls);
             throw std::runtime_error("BigInteger value exceeds 64 bits");
         }
 
-        jlong value = env->CallLongMethod(big_int, long_value);
-        env->DeleteLocalRef(cls);
+        jlong value = env->CallLongMethod(big_int, sym.big_integer_long_value);
         return static_cast<uint64_t>(value);
     }
 
-    int get_array_dimensions(JNIEnv* env, jarray arr)
-    {
-        if(!arr)
-        {
-            return 0;
-        }
-
-        jclass cls = env->GetObjectClass(arr);
-        jmethodID get_class = env->GetMethodID(cls, "getClass", "()Ljava/lang/Class;");
-        jobject cls_obj = env->CallObjectMethod(arr, get_class);
-        jclass cls_cls = env->GetObjectClass(cls_obj);
-        jmethodID get_name = env->GetMethodID(cls_cls, "getName", "()Ljava/lang/String;");
-        jstring name = (jstring)env->CallObjectMethod(cls_obj, get_name);
-        const char* name_str = env->GetStringUTFChars(name, nullptr);
-
-        int dims = 0;
-        for(const char* c = name_str; *c != '\0'; ++c)
-        {
-            if(*c == '[')
-            {
-                dims++;
-            }
-        }
-
-        env->ReleaseStringUTFChars(name, name_str);
-        env->DeleteLocalRef(name);
-        env->DeleteLocalRef(cls_cls);
-        env->DeleteLocalRef(cls_obj);
-        env->DeleteLocalRef(cls);
-
-        return dims;
-    }
-
     bool is_local_ref(JNIEnv* env, jobject obj)
     {
         if(!obj)
@@ -499,204 +637,110 @@ namespace
         }
     }
 
-    struct number_cache
-    {
-        jclass cls = nullptr;
-        jmethodID byte_value = nullptr;
-        jmethodID short_value = nullptr;
-        jmethodID int_value = nullptr;
-        jmethodID long_value = nullptr;
-        jmethodID float_value = nullptr;
-        jmethodID double_value = nullptr;
-    };
-
-    number_cache& get_number_cache(JNIEnv* env)
-    {
-        static number_cache cache;
-        if(!cache.cls)
-        {
-            jclass tmp = env->FindClass("java/lang/Number");
-            if(!tmp)
-            {
-                throw std::runtime_error("Failed to find java/lang/Number");
-            }
-            cache.cls = (jclass)env->NewGlobalRef(tmp);
-            env->DeleteLocalRef(tmp);
-        }
-        if(!cache.byte_value)
-        {
-            cache.byte_value = env->GetMethodID(cache.cls, "byteValue", "()B");
-            cache.short_value = env->GetMethodID(cache.cls, "shortValue", "()S");
-            cache.int_value = env->GetMethodID(cache.cls, "intValue", "()I");
-            cache.long_value = env->GetMethodID(cache.cls, "longValue", "()J");
-            cache.float_value = env->GetMethodID(cache.cls, "floatValue", "()F");
-            cache.double_value = env->GetMethodID(cache.cls, "doubleValue", "()D");
-            if(!cache.byte_value || !cache.short_value || !cache.int_value || !cache.long_value || !cache.float_value || !cache.double_value)
-            {
-                throw std::runtime_error("Failed to resolve Number methods");
-            }
-        }
-        return cache;
-    }
-
     bool is_number(JNIEnv* env, jobject obj)
     {
-        auto& cache = get_number_cache(env);
-        return env->IsInstanceOf(obj, cache.cls) == JNI_TRUE;
+        return env->IsInstanceOf(obj, get_jni_symbols().number_cls) == JNI_TRUE;
     }
 
     jlong number_long_value(JNIEnv* env, jobject obj)
     {
-        auto& cache = get_number_cache(env);
-        return env->CallLongMethod(obj, cache.long_value);
+        return env->CallLongMethod(obj, get_jni_symbols().number_long_value);
     }
 
     jdouble number_double_value(JNIEnv* env, jobject obj)
     {
-        auto& cache = get_number_cache(env);
-        return env->CallDoubleMethod(obj, cache.double_value);
+        return env->CallDoubleMethod(obj, get_jni_symbols().number_double_value);
     }
 
     jboolean boolean_value(JNIEnv* env, jobject obj)
     {
-        jclass cls = env->FindClass("java/lang/Boolean");
-        jmethodID mid = env->GetMethodID(cls, "booleanValue", "()Z");
-        jboolean val = env->CallBooleanMethod(obj, mid);
-        env->DeleteLocalRef(cls);
-        return val;
+        return env->CallBooleanMethod(obj, get_jni_symbols().boolean_type.unbox);
     }
 
     jchar char_value(JNIEnv* env, jobject obj)
     {
-        jclass cls = env->FindClass("java/lang/Character");
-        jmethodID mid = env->GetMethodID(cls, "charValue", "()C");
-        jchar val = env->CallCharMethod(obj, mid);
-        env->DeleteLocalRef(cls);
-        return val;
+        return env->CallCharMethod(obj, get_jni_symbols().character_type.unbox);
     }
 
+    // boxing goes through valueOf() so the JDK's small-value caches are used
     jobject box_boolean(JNIEnv* env, jboolean val)
     {
-        jclass cls = env->FindClass("java/lang/Boolean");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(Z)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().boolean_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_byte(JNIEnv* env, jbyte val)
     {
-        jclass cls = env->FindClass("java/lang/Byte");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(B)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().byte_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_short(JNIEnv* env, jshort val)
     {
-        jclass cls = env->FindClass("java/lang/Short");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(S)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().short_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_int(JNIEnv* env, jint val)
     {
-        jclass cls = env->FindClass("java/lang/Integer");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(I)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().integer_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_long(JNIEnv* env, jlong val)
     {
-        jclass cls = env->FindClass("java/lang/Long");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(J)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().long_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_float(JNIEnv* env, jfloat val)
     {
-        jclass cls = env->FindClass("java/lang/Float");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(F)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().float_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_double(JNIEnv* env, jdouble val)
     {
-        jclass cls = env->FindClass("java/lang/Double");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(D)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().double_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     jobject box_char(JNIEnv* env, jchar val)
     {
-        jclass cls = env->FindClass("java/lang/Character");
-        jmethodID ctor = env->GetMethodID(cls, "<init>", "(C)V");
-        jobject obj = env->NewObject(cls, ctor, val);
-        env->DeleteLocalRef(cls);
-        return obj;
+        const auto& box = get_jni_symbols().character_type;
+        return env->CallStaticObjectMethod(box.cls, box.value_of, val);
     }
 
     void set_accessible(JNIEnv* env, jobject obj)
     {
-        jclass cls = env->FindClass("java/lang/reflect/AccessibleObject");
-        jmethodID mid = env->GetMethodID(cls, "setAccessible", "(Z)V");
-        env->CallVoidMethod(obj, mid, JNI_TRUE);
-        env->DeleteLocalRef(cls);
+        env->CallVoidMethod(obj, get_jni_symbols().accessible_object_set_accessible, JNI_TRUE);
     }
 
     jobject invoke_method(JNIEnv* env, jobject method, jobject instance, jobjectArray args)
     {
-        jclass cls = env->FindClass("java/lang/reflect/Method");
-        jmethodID mid = env->GetMethodID(cls, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
-        jobject res = env->CallObjectMethod(method, mid, instance, args);
-        env->DeleteLocalRef(cls);
-        return res;
+        return env->CallObjectMethod(method, get_jni_symbols().method_invoke, instance, args);
     }
 
     jobject invoke_constructor(JNIEnv* env, jobject ctor, jobjectArray args)
     {
-        jclass cls = env->FindClass("java/lang/reflect/Constructor");
-        jmethodID mid = env->GetMethodID(cls, "newInstance", "([Ljava/lang/Object;)Ljava/lang/Object;");
-        jobject res = env->CallObjectMethod(ctor, mid, args);
-        env->DeleteLocalRef(cls);
-        return res;
+        return env->CallObjectMethod(ctor, get_jni_symbols().constructor_new_instance, args);
     }
 
     jobject field_get_value(JNIEnv* env, jobject field, jobject instance)
     {
-        jclass cls = env->FindClass("java/lang/reflect/Field");
-        jmethodID mid = env->GetMethodID(cls, "get", "(Ljava/lang/Object;)Ljava/lang/Object;");
-        jobject res = env->CallObjectMethod(field, mid, instance);
-        env->DeleteLocalRef(cls);
-        return res;
+        return env->CallObjectMethod(field, get_jni_symbols().field_get, instance);
     }
 
     void field_set_value(JNIEnv* env, jobject field, jobject instance, jobject value)
     {
-        jclass cls = env->FindClass("java/lang/reflect/Field");
-        jmethodID mid = env->GetMethodID(cls, "set", "(Ljava/lang/Object;Ljava/lang/Object;)V");
-        env->CallVoidMethod(field, mid, instance, value);
-        env->DeleteLocalRef(cls);
+        env->CallVoidMethod(field, get_jni_symbols().field_set, instance, value);
     }
 
-    jobjectArray build_args_array(JNIEnv* env, const std::vector<jobject>& args)
+    jobjectArray build_args_array(JNIEnv* env, const jobject* args, size_t count)
     {
-        jclass obj_cls = env->FindClass("java/lang/Object");
-        jobjectArray arr = env->NewObjectArray(static_cast<jsize>(args.size()), obj_cls, nullptr);
-        env->DeleteLocalRef(obj_cls);
+        jobjectArray arr = env->NewObjectArray(static_cast<jsize>(count), get_jni_symbols().object_cls, nullptr);
 
-        for(jsize i = 0; i < static_cast<jsize>(args.size()); i++)
+        for(jsize i = 0; i < static_cast<jsize>(count); i++)
         {
             env->SetObjectArrayElement(arr, i, args[static_cast<size_t>(i)]);
         }
@@ -704,23 +748,6 @@ namespace
         return arr;
     }
 
-    struct entity_context
-    {
-        std::string module_path;
-        std::string class_name;
-        std::string member_name;
-        bool is_callable = false;
-        bool is_constructor = false;
-        bool is_getter = false;
-        bool is_setter = false;
-        bool instance_required = false;
-        bool use_direct_call = false;
-        jobject member = nullptr; // global ref to Method/Constructor/Field
-        jvm_context direct_ctx{};
-        std::vector<metaffi_type_info> params_types;
-        std::vector<metaffi_type_info> retvals_types;
-    };
-
     enum class jni_ret_type
     {
         void_type,
@@ -735,55 +762,323 @@ namespace
         object_type
     };
 
-    jni_ret_type get_ret_type(const std::vector<metaffi_type_info>& retvals)
+    // Fixed inline storage for per-call argument arrays; only entities with more than
+    // N parameters fall back to the heap.
+    template<typename T, size_t N>
+    class inline_buffer
     {
-        if(retvals.empty())
+    public:
+        explicit inline_buffer(size_t size) : _size(size)
         {
-            return jni_ret_type::void_type;
+            if(size > N)
+            {
+                _heap.resize(size);
+                _data = _heap.data();
+            }
+            else
+            {
+                _data = _inline.data();
+            }
         }
 
-        if(retvals.size() > 1)
+        inline_buffer(const inline_buffer&) = delete;
+        inline_buffer& operator=(const inline_buffer&) = delete;
+
+        T& operator[](size_t i) { return _data[i]; }
+        const T& operator[](size_t i) const { return _data[i]; }
+        T* data() { return _data; }
+        [[nodiscard]] size_t size() const { return _size; }
+        [[nodiscard]] bool empty() const { return _size == 0; }
+
+    private:
+        std::array<T, N> _inline{};
+        std::vector<T> _heap;
+        T* _data = nullptr;
+        size_t _size = 0;
+    };
+
+    constexpr size_t inline_arg_count = 16;
+
+    // JNI local frame: every local ref created while it is open is released by a single
+    // PopLocalFrame, so the call path never has to ask the JVM what kind a reference is.
+    class local_frame
+    {
+    public:
+        local_frame(JNIEnv* env, jint capacity) : _env(env)
         {
-            return jni_ret_type::object_type;
+            if(env->PushLocalFrame(capacity) != JNI_OK)
+            {
+                env->ExceptionClear();
+                throw std::runtime_error("Failed to reserve JNI local references");
+            }
         }
 
-        metaffi_type type = retvals[0].type;
-        if(is_array_type(type))
+        ~local_frame()
         {
-            return jni_ret_type::object_type;
+            if(_env)
+            {
+                _env->PopLocalFrame(nullptr);
+            }
         }
 
-        switch(type)
+        local_frame(const local_frame&) = delete;
+        local_frame& operator=(const local_frame&) = delete;
+
+        // closes the frame and returns result as a local ref in the enclosing frame
+        jobject pop(jobject result)
         {
-            case metaffi_bool_type: return jni_ret_type::boolean_type;
-            case metaffi_int8_type: return jni_ret_type::byte_type;
-            case metaffi_uint8_type: return jni_ret_type::short_type;
-            case metaffi_int16_type: return jni_ret_type::short_type;
-            case metaffi_uint16_type: return jni_ret_type::int_type;
-            case metaffi_int32_type: return jni_ret_type::int_type;
-            case metaffi_uint32_type: return jni_ret_type::long_type;
-            case metaffi_int64_type: return jni_ret_type::long_type;
-            case metaffi_uint64_type: return jni_ret_type::object_type;
-            case metaffi_size_type: return jni_ret_type::long_type;
-            case metaffi_float32_type: return jni_ret_type::float_type;
-            case metaffi_float64_type: return jni_ret_type::double_type;
-            case metaffi_char8_type:
-            case metaffi_char16_type:
-            case metaffi_char32_type:
-                return jni_ret_type::char_type;
-            case metaffi_string8_type:
-            case metaffi_string16_type:
-            case metaffi_string32_type:
-            case metaffi_handle_type:
-            case metaffi_callable_type:
-            case metaffi_any_type:
+            JNIEnv* env = _env;
+            _env = nullptr;
+            return env->PopLocalFrame(result);
+        }
+
+    private:
+        JNIEnv* _env;
+    };
+
+    // refs reserved on top of the plan's per-parameter count: instance, result,
+    // reflection argument array and temporaries of boxing/BigInteger conversions
+    constexpr jint call_frame_slack = 8;
+
+    // arrays are marshalled inside their own frame; reference-element arrays are stored in
+    // chunks of this many elements, each in a frame of its own
+    constexpr jint array_frame_capacity = 1024;
+
+    // whether a marshalled value occupies a local ref slot in the call frame
+    enum class local_ref_ownership : uint8_t
+    {
+        none,   // primitive or null
+        owned,  // always a fresh local ref
+        check   // may be a global ref (e.g. handle payload)
+    };
+
+    using jvalue_converter = jvalue (*)(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info);
+    using object_converter = jobject (*)(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info);
+    using return_storer = void (*)(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info, jvalue val);
+
+    struct param_step
+    {
+        jvalue_converter to_jvalue = nullptr; // typed JNI dispatch
+        object_converter to_object = nullptr; // reflection / receiver (boxed)
+        char sig = 'L';
+        local_ref_ownership jvalue_ownership = local_ref_ownership::check;
+        local_ref_ownership object_ownership = local_ref_ownership::check;
+    };
+
+    // Marshalling plan compiled once per entity (load_entity / make_callable) so the call path
+    // does not re-decode metaffi_type_info for every argument of every call.
+    struct call_plan
+    {
+        std::vector<param_step> params; // one step per entry of params_types, including the instance
+        size_t first_arg = 0;           // index of the first non-instance parameter
+        jni_ret_type ret_kind = jni_ret_type::void_type;
+        char ret_sig = 'V';
+        return_storer store_return = nullptr; // set when there is exactly one return value
+        bool multiple_returns = false;
+        jint local_capacity = call_frame_slack; // size of the per-call PushLocalFrame
+    };
+
+    // instance field of a multiple-return wrapper, in declaration order
+    struct wrapper_field
+    {
+        jfieldID id = nullptr;
+        jni_ret_type kind = jni_ret_type::object_type;
+        return_storer store = nullptr; // typed store; null if the field must be boxed first
+    };
+
+    // Layout of a multiple-return wrapper class, resolved once per (entity, class)
+    struct wrapper_layout
+    {
+        jclass cls = nullptr;      // global ref
+        bool object_array = false; // Object[] returned as-is, values are read by index
+        std::vector<wrapper_field> fields;
+    };
+
+    // Dedicated thread of a module's actor entities. Entities share it through a shared_ptr, so
+    // an xcall that outlives free_runtime() finds the actor stopped rather than freed.
+    struct jvm_actor
+    {
+        std::unique_ptr<jvm_worker_pool> pool; // reset by stop_actors()
+        std::atomic<bool> stopped{false};
+    };
+
+    struct entity_context
+    {
+        std::string module_path;
+        std::string class_name;
+        std::string member_name;
+        bool is_callable = false;
+        bool is_constructor = false;
+        bool is_getter = false;
+        bool is_setter = false;
+        bool instance_required = false;
+        bool use_direct_call = false;
+        bool use_direct_field = false;
+        bool direct_buffers = false; // buffer=direct: 1-D int8/uint8 arrays cross as java.nio.ByteBuffer
+        bool returns_future = false; // single return aliased CompletableFuture/CompletionStage; its type is the completed value's
+        std::shared_ptr<jvm_actor> actor; // actor: calls run on the module's dedicated thread
+        uint64_t timeout_ms = 0; // timeout_ms=N: deadline of each call; 0 for none
+        bool cancellable = false; // cancellable (or a timeout): in-flight calls can be interrupted
+        jni_ret_type field_type = jni_ret_type::object_type; // JNI kind of the field for direct access
+        jfieldID field_id = nullptr;
+        jobject member = nullptr; // global ref to Method/Constructor/Field
+        jvm_context direct_ctx{};
+        std::vector<jclass> arg_classes; // global refs by parameter index: class a direct argument or field value is checked against; null if unchecked
+        bool checks_arguments = false; // some arg_classes entry is set
+        std::vector<metaffi_type_info> params_types;
+        std::vector<metaffi_type_info> retvals_types;
+        call_plan plan;
+        std::mutex wrapper_mutex; // guards wrapper_layouts
+        std::vector<std::unique_ptr<wrapper_layout>> wrapper_layouts;
+        std::atomic<const wrapper_layout*> last_wrapper{nullptr};
+        std::string cache_key; // key in the entity cache; empty if the context is not shared
+        uint32_t refs = 1; // xcalls sharing the context and calls still running on it; guarded by g_entity_cache_mutex
+        std::deque<std::string> aliases; // owned copies the type aliases of a shared context point to
+    };
+
+    // The (module, entity path, parameter types, return types) tuple a resolved entity is shared by.
+    std::string entity_cache_key(const char* module_path, const char* entity_path,
+                                 const metaffi_type_info* params_types, int8_t params_count,
+                                 const metaffi_type_info* retvals_types, int8_t retval_count)
+    {
+        std::string key = module_path ? module_path : "";
+        key += '\0';
+        key += entity_path;
+        key += '\0';
+
+        auto append_types = [&key](const metaffi_type_info* types, int8_t count)
+        {
+            for(int8_t i = 0; i < count; i++)
+            {
+                key += std::to_string(types[i].type);
+                key += ':';
+                key += std::to_string(types[i].fixed_dimensions);
+                key += ':';
+                if(types[i].alias)
+                {
+                    key += types[i].alias;
+                }
+                key += ';';
+            }
+        };
+        append_types(params_types, params_count);
+        key += '|';
+        append_types(retvals_types, retval_count);
+        return key;
+    }
+
+    // a shared context outlives the load_entity call, so it must not point into the caller's strings
+    void own_type_aliases(entity_context& ctx)
+    {
+        for(auto* types : {&ctx.params_types, &ctx.retvals_types})
+        {
+            for(auto& type_info : *types)
+            {
+                if(type_info.alias)
+                {
+                    type_info.alias = ctx.aliases.emplace_back(type_info.alias).data();
+                }
+            }
+        }
+    }
+
+    // a future entity delivers its completed value only through jvm_runtime_xcall_future;
+    // the synchronous paths still return the stage itself when it is declared as a handle
+    bool needs_future_call(const entity_context* ctx)
+    {
+        return ctx->returns_future && ctx->retvals_types[0].type != metaffi_handle_type;
+    }
+
+    jni_ret_type jni_kind_from_type_info(const metaffi_type_info& type_info)
+    {
+        metaffi_type type = type_info.type;
+        if(is_array_type(type))
+        {
+            return jni_ret_type::object_type;
+        }
+
+        switch(type)
+        {
+            case metaffi_bool_type: return jni_ret_type::boolean_type;
+            case metaffi_int8_type: return jni_ret_type::byte_type;
+            case metaffi_uint8_type: return jni_ret_type::short_type;
+            case metaffi_int16_type: return jni_ret_type::short_type;
+            case metaffi_uint16_type: return jni_ret_type::int_type;
+            case metaffi_int32_type: return jni_ret_type::int_type;
+            case metaffi_uint32_type: return jni_ret_type::long_type;
+            case metaffi_int64_type: return jni_ret_type::long_type;
+            case metaffi_uint64_type: return jni_ret_type::object_type;
+            case metaffi_size_type: return jni_ret_type::long_type;
+            case metaffi_float32_type: return jni_ret_type::float_type;
+            case metaffi_float64_type: return jni_ret_type::double_type;
+            case metaffi_char8_type:
+            case metaffi_char16_type:
+            case metaffi_char32_type:
+                return jni_ret_type::char_type;
+            case metaffi_string8_type:
+            case metaffi_string16_type:
+            case metaffi_string32_type:
+            case metaffi_handle_type:
+            case metaffi_callable_type:
+            case metaffi_any_type:
             case metaffi_null_type:
                 return jni_ret_type::object_type;
             default:
                 return jni_ret_type::object_type;
         }
     }
-    jobject convert_any_to_object(JNIEnv* env, cdts_jvm_serializer& ser)
+
+    jni_ret_type get_ret_type(const std::vector<metaffi_type_info>& retvals)
+    {
+        if(retvals.empty())
+        {
+            return jni_ret_type::void_type;
+        }
+
+        if(retvals.size() > 1)
+        {
+            return jni_ret_type::object_type;
+        }
+
+        return jni_kind_from_type_info(retvals[0]);
+    }
+
+    // string8 goes through the UTF-16 transcoding of jni_strings.h; string16/32 and nulls
+    // keep the serializer path
+    jstring extract_string(JNIEnv* env, call_serializer& ser)
+    {
+        cdt& item = ser.current();
+        if(item.type != metaffi_string8_type || !item.cdt_val.string8_val)
+        {
+            return ser.extract_string();
+        }
+
+        std::u8string_view utf8(item.cdt_val.string8_val);
+        jstring result = cached_jstring(env, utf8);
+        if(!result)
+        {
+            result = utf8_to_jstring(env, utf8.data(), utf8.size());
+        }
+        ser.skip();
+        return result;
+    }
+
+    void store_string(JNIEnv* env, call_serializer& ser, jstring str, metaffi_type type)
+    {
+        if(type != metaffi_string8_type)
+        {
+            ser.add(str, type);
+            return;
+        }
+
+        if(!cached_string_to_cdt(env, str, ser.current()))
+        {
+            jstring_to_cdt(env, str, ser.current());
+        }
+        ser.skip();
+    }
+
+    jobject convert_any_to_object(JNIEnv* env, call_serializer& ser)
     {
         metaffi_type actual = ser.peek_type();
         if(actual == metaffi_null_type)
@@ -845,7 +1140,7 @@ namespace
             case metaffi_string8_type:
             case metaffi_string16_type:
             case metaffi_string32_type:
-                return ser.extract_string();
+                return extract_string(env, ser);
             case metaffi_handle_type:
             case metaffi_callable_type:
                 return ser.extract_handle();
@@ -854,187 +1149,231 @@ namespace
         }
     }
 
-    jobject convert_param_to_object(JNIEnv* env, cdts_jvm_serializer& ser, const metaffi_type_info& type_info)
+    // Object[] and nested arrays create one local ref per element while being marshalled
+    bool array_holds_references(const metaffi_type_info& type_info)
+    {
+        if(type_info.fixed_dimensions != 1)
+        {
+            return true;
+        }
+
+        switch(base_type(type_info.type))
+        {
+            case metaffi_bool_type:
+            case metaffi_int8_type:
+            case metaffi_uint8_type:
+            case metaffi_int16_type:
+            case metaffi_uint16_type:
+            case metaffi_int32_type:
+            case metaffi_uint32_type:
+            case metaffi_int64_type:
+            case metaffi_uint64_type:
+            case metaffi_float32_type:
+            case metaffi_float64_type:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    jobject extract_array(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info)
+    {
+        if(!array_holds_references(type_info))
+        {
+            if(jarray bulk = critical_array_from_cdt(env, ser.current(), type_info))
+            {
+                ser.skip();
+                return bulk;
+            }
+            return ser.extract_array(type_info);
+        }
+
+        if(jobjectArray bulk = string_array_from_cdt(env, ser.current()))
+        {
+            ser.skip();
+            return bulk;
+        }
+
+        // element refs die with the frame; only the array itself survives into the call frame
+        local_frame frame(env, array_frame_capacity);
+        return frame.pop(ser.extract_array(type_info));
+    }
+
+    jvalue_converter select_jvalue_converter(const metaffi_type_info& type_info, char& sig, local_ref_ownership& ownership)
     {
         metaffi_type type = type_info.type;
+        sig = 'L';
+        ownership = local_ref_ownership::owned;
+
         if(is_array_type(type))
         {
-            return ser.extract_array(type_info);
+            return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info& ti) { jvalue v{}; v.l = extract_array(env, ser, ti); return v; };
         }
 
         switch(type)
         {
             case metaffi_any_type:
-                return convert_any_to_object(env, ser);
+                ownership = local_ref_ownership::check;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.l = convert_any_to_object(env, ser); return v; };
             case metaffi_bool_type:
-                return box_boolean(env, ser.extract_boolean());
+                sig = 'Z';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.z = ser.extract_boolean(); return v; };
             case metaffi_int8_type:
-                return box_byte(env, ser.extract_byte());
+                sig = 'B';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.b = ser.extract_byte(); return v; };
             case metaffi_uint8_type:
-            {
-                jbyte b = ser.extract_byte();
-                jshort s = static_cast<jshort>(static_cast<uint8_t>(b));
-                return box_short(env, s);
-            }
+                sig = 'S';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.s = static_cast<jshort>(static_cast<uint8_t>(ser.extract_byte())); return v; };
             case metaffi_int16_type:
-                return box_short(env, ser.extract_short());
+                sig = 'S';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.s = ser.extract_short(); return v; };
             case metaffi_uint16_type:
-            {
-                jshort s = ser.extract_short();
-                jint i = static_cast<jint>(static_cast<uint16_t>(s));
-                return box_int(env, i);
-            }
+                sig = 'I';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.i = static_cast<jint>(static_cast<uint16_t>(ser.extract_short())); return v; };
             case metaffi_int32_type:
-                return box_int(env, ser.extract_int());
+                sig = 'I';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.i = ser.extract_int(); return v; };
             case metaffi_uint32_type:
-            {
-                jint i = ser.extract_int();
-                jlong l = static_cast<jlong>(static_cast<uint32_t>(i));
-                return box_long(env, l);
-            }
+                sig = 'J';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.j = static_cast<jlong>(static_cast<uint32_t>(ser.extract_int())); return v; };
             case metaffi_int64_type:
-                return box_long(env, ser.extract_long());
-            case metaffi_uint64_type:
-            {
-                jlong v = ser.extract_long();
-                return create_big_integer(env, static_cast<uint64_t>(v));
-            }
             case metaffi_size_type:
-                return box_long(env, ser.extract_long());
+                sig = 'J';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.j = ser.extract_long(); return v; };
+            case metaffi_uint64_type:
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.l = create_big_integer(env, static_cast<uint64_t>(ser.extract_long())); return v; };
             case metaffi_float32_type:
-                return box_float(env, ser.extract_float());
+                sig = 'F';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.f = ser.extract_float(); return v; };
             case metaffi_float64_type:
-                return box_double(env, ser.extract_double());
+                sig = 'D';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.d = ser.extract_double(); return v; };
             case metaffi_char8_type:
             case metaffi_char16_type:
             case metaffi_char32_type:
-                return box_char(env, ser.extract_char());
+                sig = 'C';
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.c = ser.extract_char(); return v; };
             case metaffi_string8_type:
             case metaffi_string16_type:
             case metaffi_string32_type:
-                return ser.extract_string();
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.l = extract_string(env, ser); return v; };
+            case metaffi_null_type:
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { ser.set_index(ser.get_index() + 1); jvalue v{}; v.l = nullptr; return v; };
             case metaffi_handle_type:
             case metaffi_callable_type:
-                return ser.extract_handle();
-            case metaffi_null_type:
-                ser.set_index(ser.get_index() + 1);
-                return nullptr;
             default:
-                return ser.extract_handle();
+                ownership = local_ref_ownership::check;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { jvalue v{}; v.l = ser.extract_handle(); return v; };
         }
     }
 
-    struct jvalue_with_sig
-    {
-        jvalue value{};
-        char sig = 'L';
-    };
-
-    jvalue_with_sig convert_param_to_jvalue(JNIEnv* env, cdts_jvm_serializer& ser, const metaffi_type_info& type_info)
+    object_converter select_object_converter(const metaffi_type_info& type_info, local_ref_ownership& ownership)
     {
-        jvalue_with_sig out;
         metaffi_type type = type_info.type;
+        ownership = local_ref_ownership::owned;
 
         if(is_array_type(type))
         {
-            out.value.l = ser.extract_array(type_info);
-            out.sig = 'L';
-            return out;
+            return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info& ti) { return extract_array(env, ser, ti); };
         }
 
         switch(type)
         {
             case metaffi_any_type:
-                out.value.l = convert_any_to_object(env, ser);
-                out.sig = 'L';
-                return out;
+                ownership = local_ref_ownership::check;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return convert_any_to_object(env, ser); };
             case metaffi_bool_type:
-                out.value.z = ser.extract_boolean();
-                out.sig = 'Z';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_boolean(env, ser.extract_boolean()); };
             case metaffi_int8_type:
-                out.value.b = ser.extract_byte();
-                out.sig = 'B';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_byte(env, ser.extract_byte()); };
             case metaffi_uint8_type:
-            {
-                jbyte b = ser.extract_byte();
-                out.value.s = static_cast<jshort>(static_cast<uint8_t>(b));
-                out.sig = 'S';
-                return out;
-            }
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_short(env, static_cast<jshort>(static_cast<uint8_t>(ser.extract_byte()))); };
             case metaffi_int16_type:
-                out.value.s = ser.extract_short();
-                out.sig = 'S';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_short(env, ser.extract_short()); };
             case metaffi_uint16_type:
-            {
-                jshort s = ser.extract_short();
-                out.value.i = static_cast<jint>(static_cast<uint16_t>(s));
-                out.sig = 'I';
-                return out;
-            }
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_int(env, static_cast<jint>(static_cast<uint16_t>(ser.extract_short()))); };
             case metaffi_int32_type:
-                out.value.i = ser.extract_int();
-                out.sig = 'I';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_int(env, ser.extract_int()); };
             case metaffi_uint32_type:
-            {
-                jint i = ser.extract_int();
-                out.value.j = static_cast<jlong>(static_cast<uint32_t>(i));
-                out.sig = 'J';
-                return out;
-            }
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_long(env, static_cast<jlong>(static_cast<uint32_t>(ser.extract_int()))); };
             case metaffi_int64_type:
-                out.value.j = ser.extract_long();
-                out.sig = 'J';
-                return out;
-            case metaffi_uint64_type:
-                out.value.l = create_big_integer(env, static_cast<uint64_t>(ser.extract_long()));
-                out.sig = 'L';
-                return out;
             case metaffi_size_type:
-                out.value.j = ser.extract_long();
-                out.sig = 'J';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_long(env, ser.extract_long()); };
+            case metaffi_uint64_type:
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return create_big_integer(env, static_cast<uint64_t>(ser.extract_long())); };
             case metaffi_float32_type:
-                out.value.f = ser.extract_float();
-                out.sig = 'F';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_float(env, ser.extract_float()); };
             case metaffi_float64_type:
-                out.value.d = ser.extract_double();
-                out.sig = 'D';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_double(env, ser.extract_double()); };
             case metaffi_char8_type:
             case metaffi_char16_type:
             case metaffi_char32_type:
-                out.value.c = ser.extract_char();
-                out.sig = 'C';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) { return box_char(env, ser.extract_char()); };
             case metaffi_string8_type:
             case metaffi_string16_type:
             case metaffi_string32_type:
-                out.value.l = ser.extract_string();
-                out.sig = 'L';
-                return out;
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info&) -> jobject { return extract_string(env, ser); };
+            case metaffi_null_type:
+                ownership = local_ref_ownership::none;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) -> jobject { ser.set_index(ser.get_index() + 1); return nullptr; };
             case metaffi_handle_type:
             case metaffi_callable_type:
-                out.value.l = ser.extract_handle();
-                out.sig = 'L';
-                return out;
-            case metaffi_null_type:
-                ser.set_index(ser.get_index() + 1);
-                out.value.l = nullptr;
-                out.sig = 'L';
-                return out;
             default:
-                out.value.l = ser.extract_handle();
-                out.sig = 'L';
-                return out;
+                ownership = local_ref_ownership::check;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&) { return ser.extract_handle(); };
+        }
+    }
+
+    void store_return_value_from_object(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info, jobject obj);
+
+    // Object[] and nested arrays are walked element by element, and the local frame is popped
+    // and pushed again every array_frame_capacity elements, so a huge result holds at most one
+    // chunk of element refs at a time.
+    void store_reference_array(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info, jobjectArray arr, int dims)
+    {
+        jsize length = env->GetArrayLength(arr);
+        cdt& out = ser.current();
+        out.set_new_array(static_cast<metaffi_size>(length), dims, base_type(type_info.type));
+        ser.skip();
+
+        metaffi_type_info element_info = type_info;
+        if(dims > 1)
+        {
+            element_info.fixed_dimensions = dims - 1;
+        }
+        else
+        {
+            element_info.type = base_type(type_info.type);
+            element_info.fixed_dimensions = 0;
+        }
+
+        call_serializer elements(env, static_cast<cdts&>(out), ser.class_loader());
+        for(jsize begin = 0; begin < length; begin += array_frame_capacity)
+        {
+            jsize end = std::min<jsize>(length, begin + array_frame_capacity);
+
+            // each element and the temporaries of its conversion
+            local_frame frame(env, (end - begin) * 2 + 1);
+            for(jsize i = begin; i < end; i++)
+            {
+                store_return_value_from_object(env, elements, element_info, env->GetObjectArrayElement(arr, i));
+            }
         }
     }
 
-    void store_return_value_from_object(JNIEnv* env, cdts_jvm_serializer& ser, const metaffi_type_info& type_info, jobject obj)
+    void store_return_value_from_object(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info, jobject obj)
     {
         if(!obj)
         {
@@ -1045,8 +1384,24 @@ namespace
         metaffi_type type = type_info.type;
         if(is_array_type(type))
         {
-            int dims = type_info.fixed_dimensions > 0 ? static_cast<int>(type_info.fixed_dimensions) : get_array_dimensions(env, (jarray)obj);
-            ser.add_array((jarray)obj, dims, base_type(type));
+            int dims = type_info.fixed_dimensions > 0 ? static_cast<int>(type_info.fixed_dimensions) : get_array_class_info(env, (jarray)obj).dimensions;
+            if(dims == 1 && critical_array_to_cdt(env, (jarray)obj, base_type(type), ser.current()))
+            {
+                ser.skip();
+                return;
+            }
+            if(!array_holds_references(type_info))
+            {
+                ser.add_array((jarray)obj, dims, base_type(type));
+                return;
+            }
+            if(dims == 1 && base_type(type) == metaffi_string8_type && string_array_to_cdt(env, (jobjectArray)obj, ser.current()))
+            {
+                ser.skip();
+                return;
+            }
+
+            store_reference_array(env, ser, type_info, (jobjectArray)obj, dims);
             return;
         }
 
@@ -1114,7 +1469,7 @@ namespace
             case metaffi_string8_type:
             case metaffi_string16_type:
             case metaffi_string32_type:
-                ser.add((jstring)obj, type);
+                store_string(env, ser, (jstring)obj, type);
                 return;
             case metaffi_handle_type:
                 ser.add_handle(obj);
@@ -1131,128 +1486,64 @@ namespace
         }
     }
 
-    void store_return_value_from_jvalue(JNIEnv* env, cdts_jvm_serializer& ser, const metaffi_type_info& type_info, jvalue val, char sig)
+    return_storer select_return_storer(const metaffi_type_info& type_info, char sig)
     {
         if(sig == 'L')
         {
-            store_return_value_from_object(env, ser, type_info, val.l);
-            return;
+            switch(type_info.type)
+            {
+                case metaffi_string8_type:
+                case metaffi_string16_type:
+                case metaffi_string32_type:
+                    return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info& ti, jvalue val) {
+                        if(!val.l) ser.null(); else store_string(env, ser, (jstring)val.l, ti.type);
+                    };
+                case metaffi_handle_type:
+                    return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) {
+                        if(!val.l) ser.null(); else ser.add_handle(val.l);
+                    };
+                default:
+                    // arrays, any, callables and boxed primitives
+                    return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info& ti, jvalue val) {
+                        store_return_value_from_object(env, ser, ti, val.l);
+                    };
+            }
         }
 
         switch(type_info.type)
         {
             case metaffi_bool_type:
-                ser.add(val.z, metaffi_bool_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.z, metaffi_bool_type); };
             case metaffi_int8_type:
-                ser.add(val.b, metaffi_int8_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.b, metaffi_int8_type); };
             case metaffi_uint8_type:
-                ser.add(static_cast<jbyte>(static_cast<uint8_t>(val.s)), metaffi_uint8_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(static_cast<jbyte>(static_cast<uint8_t>(val.s)), metaffi_uint8_type); };
             case metaffi_int16_type:
-                ser.add(val.s, metaffi_int16_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.s, metaffi_int16_type); };
             case metaffi_uint16_type:
-                ser.add(static_cast<jshort>(static_cast<uint16_t>(val.i)), metaffi_uint16_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(static_cast<jshort>(static_cast<uint16_t>(val.i)), metaffi_uint16_type); };
             case metaffi_int32_type:
-                ser.add(val.i, metaffi_int32_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.i, metaffi_int32_type); };
             case metaffi_uint32_type:
-                ser.add(static_cast<jint>(static_cast<uint32_t>(val.j)), metaffi_uint32_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(static_cast<jint>(static_cast<uint32_t>(val.j)), metaffi_uint32_type); };
             case metaffi_int64_type:
-                ser.add(val.j, metaffi_int64_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.j, metaffi_int64_type); };
             case metaffi_uint64_type:
-                ser.add(static_cast<jlong>(val.j), metaffi_uint64_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.j, metaffi_uint64_type); };
             case metaffi_size_type:
-                ser.add(static_cast<jlong>(val.j), metaffi_size_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.j, metaffi_size_type); };
             case metaffi_float32_type:
-                ser.add(val.f, metaffi_float32_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.f, metaffi_float32_type); };
             case metaffi_float64_type:
-                ser.add(val.d, metaffi_float64_type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info&, jvalue val) { ser.add(val.d, metaffi_float64_type); };
             case metaffi_char8_type:
             case metaffi_char16_type:
             case metaffi_char32_type:
-                ser.add(val.c, type_info.type);
-                return;
+                return [](JNIEnv*, call_serializer& ser, const metaffi_type_info& ti, jvalue val) { ser.add(val.c, ti.type); };
             default:
-                store_return_value_from_object(env, ser, type_info, val.l);
-                return;
-        }
-    }
-
-    void store_multiple_return_values(JNIEnv* env, cdts_jvm_serializer& ser, const std::vector<metaffi_type_info>& retvals, jobject wrapper)
-    {
-        if(!wrapper)
-        {
-            throw std::runtime_error("Expected wrapper object for multiple return values");
-        }
-
-        jclass cls = env->GetObjectClass(wrapper);
-        jmethodID get_fields = env->GetMethodID(cls, "getDeclaredFields", "()[Ljava/lang/reflect/Field;");
-        jobjectArray fields = (jobjectArray)env->CallObjectMethod(cls, get_fields);
-        env->DeleteLocalRef(cls);
-
-        if(!fields)
-        {
-            throw std::runtime_error("Failed to get declared fields from wrapper");
-        }
-
-        jclass field_cls = env->FindClass("java/lang/reflect/Field");
-        jmethodID get_mods = env->GetMethodID(field_cls, "getModifiers", "()I");
-        jclass modifier_cls = env->FindClass("java/lang/reflect/Modifier");
-        jmethodID is_static = env->GetStaticMethodID(modifier_cls, "isStatic", "(I)Z");
-
-        std::vector<jobject> instance_fields;
-        jsize count = env->GetArrayLength(fields);
-        for(jsize i = 0; i < count; i++)
-        {
-            jobject field = env->GetObjectArrayElement(fields, i);
-            jint mods = env->CallIntMethod(field, get_mods);
-            jboolean static_flag = env->CallStaticBooleanMethod(modifier_cls, is_static, mods);
-            if(static_flag == JNI_FALSE)
-            {
-                instance_fields.push_back(field);
-            }
-            else
-            {
-                env->DeleteLocalRef(field);
-            }
-        }
-
-        env->DeleteLocalRef(fields);
-        env->DeleteLocalRef(field_cls);
-        env->DeleteLocalRef(modifier_cls);
-
-        if(instance_fields.size() < retvals.size())
-        {
-            for(auto* f : instance_fields)
-            {
-                env->DeleteLocalRef(f);
-            }
-            throw std::runtime_error("Wrapper field count does not match return values");
-        }
-
-        for(size_t i = 0; i < retvals.size(); i++)
-        {
-            jobject field = instance_fields[i];
-            set_accessible(env, field);
-            jobject value = field_get_value(env, field, wrapper);
-            store_return_value_from_object(env, ser, retvals[i], value);
-            delete_local_ref_if_needed(env, value);
-            env->DeleteLocalRef(field);
-        }
-
-        for(size_t i = retvals.size(); i < instance_fields.size(); i++)
-        {
-            env->DeleteLocalRef(instance_fields[i]);
+                return [](JNIEnv* env, call_serializer& ser, const metaffi_type_info& ti, jvalue val) {
+                    store_return_value_from_object(env, ser, ti, val.l);
+                };
         }
     }
 
@@ -1284,119 +1575,191 @@ namespace
         return jvms.front();
     }
 
-    void throw_if_jni_exception(JNIEnv* env, const std::string& fallback)
+    // takes a C string so the success path does not construct a std::string per call
+    void throw_if_jni_exception(JNIEnv* env, const char* fallback)
     {
         if(env && env->ExceptionCheck())
         {
             std::string error = get_exception_description(env);
-            throw std::runtime_error(error.empty() ? fallback : error);
+            throw std::runtime_error(error.empty() ? std::string(fallback) : error);
         }
     }
 
-    jobject resolve_method(JNIEnv* env, jclass cls, const std::string& name, const std::vector<jclass>& param_types, bool instance_required)
+    void throw_if_jni_exception(JNIEnv* env, const std::string& fallback)
+    {
+        throw_if_jni_exception(env, fallback.c_str());
+    }
+
+    bool is_byte_buffer_type(const metaffi_type_info& type_info)
     {
-        jclass class_cls = env->FindClass("java/lang/Class");
-        if(!class_cls)
+        return (type_info.type == metaffi_uint8_array_type || type_info.type == metaffi_int8_array_type) &&
+               type_info.fixed_dimensions == 1;
+    }
+
+    // Exposes a host byte array to Java as a direct ByteBuffer over call-scoped native memory.
+    // Host arrays are cdt-per-element, so the bytes are packed once; there is no short[]
+    // widening and no Java heap copy. The buffer must not be used after the call returns.
+    jobject byte_buffer_from_cdt(JNIEnv* env, call_serializer& ser, const metaffi_type_info&)
+    {
+        cdt& item = ser.current();
+        if(item.type == metaffi_null_type)
         {
-            throw_if_jni_exception(env, "Failed to find java/lang/Class");
-            throw std::runtime_error("Failed to find java/lang/Class");
+            ser.skip();
+            return nullptr;
         }
 
-        jmethodID get_declared_method = env->GetMethodID(class_cls, "getDeclaredMethod", "(Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;");
-        if(!get_declared_method)
+        if(!is_array_type(item.type) || (base_type(item.type) != metaffi_int8_type && base_type(item.type) != metaffi_uint8_type))
         {
-            env->DeleteLocalRef(class_cls);
-            throw_if_jni_exception(env, "Failed to get Class.getDeclaredMethod");
-            throw std::runtime_error("Failed to get Class.getDeclaredMethod");
+            throw std::runtime_error("ByteBuffer parameter expects a 1-D int8 or uint8 array");
         }
-
-        jobjectArray params_array = env->NewObjectArray(static_cast<jsize>(param_types.size()), class_cls, nullptr);
-        if(!params_array)
+        cdts& src = static_cast<cdts&>(item);
+        if(src.fixed_dimensions != 1)
         {
-            env->DeleteLocalRef(class_cls);
-            throw std::runtime_error("Failed to allocate parameter types array");
+            throw std::runtime_error("ByteBuffer parameter expects a 1-D int8 or uint8 array");
         }
 
-        for(jsize i = 0; i < static_cast<jsize>(param_types.size()); i++)
+        uint8_t* data = ser.scratch(static_cast<size_t>(src.length));
+        for(metaffi_size i = 0; i < src.length; i++)
         {
-            env->SetObjectArrayElement(params_array, i, param_types[static_cast<size_t>(i)]);
+            data[i] = src[i].cdt_val.uint8_val; // int8 and uint8 share the byte
         }
+        ser.skip();
 
-        jstring name_obj = env->NewStringUTF(name.c_str());
-        jobject method = env->CallObjectMethod(cls, get_declared_method, name_obj, params_array);
-        env->DeleteLocalRef(name_obj);
-        env->DeleteLocalRef(params_array);
-        env->DeleteLocalRef(class_cls);
+        jobject buffer = env->NewDirectByteBuffer(data, static_cast<jlong>(src.length));
+        if(!buffer)
+        {
+            throw_if_jni_exception(env, "Failed to create direct ByteBuffer");
+            throw std::runtime_error("Direct ByteBuffers are not supported by the JVM");
+        }
+        return buffer;
+    }
 
-        throw_if_jni_exception(env, "Failed to resolve Java method: " + name);
-        if(!method)
+    template<typename M>
+    void copy_bytes_to_cdts(cdts& dst, const uint8_t* src)
+    {
+        for(metaffi_size i = 0; i < dst.length; i++)
         {
-            throw std::runtime_error("Failed to resolve Java method: " + name);
+            dst[i] = static_cast<M>(src[i]);
         }
+    }
 
-        jclass method_cls = env->FindClass("java/lang/reflect/Method");
-        jmethodID get_mods = env->GetMethodID(method_cls, "getModifiers", "()I");
-        jclass modifier_cls = env->FindClass("java/lang/reflect/Modifier");
-        jmethodID is_static = env->GetStaticMethodID(modifier_cls, "isStatic", "(I)Z");
-        if(!get_mods || !is_static)
+    // Copies the remaining bytes of a returned ByteBuffer into a 1-D host array. Direct buffers
+    // are read through GetDirectBufferAddress; heap buffers go through a byte[] copy.
+    void store_byte_buffer(JNIEnv* env, call_serializer& ser, const metaffi_type_info& type_info, jvalue val)
+    {
+        jobject buffer = val.l;
+        const auto& sym = get_jni_symbols();
+        if(!buffer || env->IsInstanceOf(buffer, sym.byte_buffer_cls) == JNI_FALSE)
         {
-            env->DeleteLocalRef(method_cls);
-            env->DeleteLocalRef(modifier_cls);
-            env->DeleteLocalRef(method);
-            throw_if_jni_exception(env, "Failed to inspect method modifiers");
-            throw std::runtime_error("Failed to inspect method modifiers");
+            store_return_value_from_object(env, ser, type_info, buffer);
+            return;
         }
 
-        jint mods = env->CallIntMethod(method, get_mods);
-        jboolean is_static_flag = env->CallStaticBooleanMethod(modifier_cls, is_static, mods);
-        bool is_static_method = is_static_flag == JNI_TRUE;
-        if(is_static_method == instance_required)
+        jint position = env->CallIntMethod(buffer, sym.buffer_position);
+        jint limit = env->CallIntMethod(buffer, sym.buffer_limit);
+        throw_if_jni_exception(env, "Failed to read ByteBuffer bounds");
+        jsize length = limit - position;
+
+        metaffi_type elem_type = base_type(type_info.type);
+        cdt& out = ser.current();
+        out.set_new_array(static_cast<metaffi_size>(length), 1, elem_type);
+        cdts& dst = static_cast<cdts&>(out);
+
+        auto copy = [&](const uint8_t* bytes)
         {
-            env->DeleteLocalRef(method_cls);
-            env->DeleteLocalRef(modifier_cls);
-            env->DeleteLocalRef(method);
-            throw std::runtime_error("Java method static/instance mismatch for " + name);
+            if(elem_type == metaffi_uint8_type)
+            {
+                copy_bytes_to_cdts<metaffi_uint8>(dst, bytes);
+            }
+            else
+            {
+                copy_bytes_to_cdts<metaffi_int8>(dst, bytes);
+            }
+        };
+
+        auto* address = static_cast<const uint8_t*>(env->GetDirectBufferAddress(buffer));
+        if(address)
+        {
+            copy(address + position);
         }
+        else
+        {
+            // duplicate() so the caller's buffer position is left untouched
+            jbyteArray bytes = env->NewByteArray(length);
+            jobject view = bytes ? env->CallObjectMethod(buffer, sym.byte_buffer_duplicate) : nullptr;
+            if(view)
+            {
+                env->CallObjectMethod(view, sym.byte_buffer_get_bytes, bytes);
+            }
+            throw_if_jni_exception(env, "Failed to read heap ByteBuffer");
+            if(!bytes || !view)
+            {
+                throw std::runtime_error("Failed to read heap ByteBuffer");
+            }
 
-        env->DeleteLocalRef(method_cls);
-        env->DeleteLocalRef(modifier_cls);
+            void* pinned = env->GetPrimitiveArrayCritical(bytes, nullptr);
+            if(!pinned)
+            {
+                throw_if_jni_exception(env, "Failed to access ByteBuffer contents");
+                throw std::runtime_error("Failed to access ByteBuffer contents");
+            }
+            copy(static_cast<const uint8_t*>(pinned));
+            env->ReleasePrimitiveArrayCritical(bytes, pinned, JNI_ABORT);
+        }
 
-        set_accessible(env, method);
-        return method;
+        ser.skip();
     }
 
-    jobject resolve_constructor(JNIEnv* env, jclass cls, const std::vector<jclass>& param_types)
+    jobjectArray build_class_array(JNIEnv* env, const std::vector<jclass>& classes)
     {
-        jclass class_cls = env->FindClass("java/lang/Class");
-        if(!class_cls)
+        jobjectArray arr = env->NewObjectArray(static_cast<jsize>(classes.size()), get_jni_symbols().class_cls, nullptr);
+        if(!arr)
         {
-            throw_if_jni_exception(env, "Failed to find java/lang/Class");
-            throw std::runtime_error("Failed to find java/lang/Class");
+            throw_if_jni_exception(env, "Failed to allocate parameter types array");
+            throw std::runtime_error("Failed to allocate parameter types array");
         }
 
-        jmethodID get_declared_ctor = env->GetMethodID(class_cls, "getDeclaredConstructor", "([Ljava/lang/Class;)Ljava/lang/reflect/Constructor;");
-        if(!get_declared_ctor)
+        for(jsize i = 0; i < static_cast<jsize>(classes.size()); i++)
         {
-            env->DeleteLocalRef(class_cls);
-            throw_if_jni_exception(env, "Failed to get Class.getDeclaredConstructor");
-            throw std::runtime_error("Failed to get Class.getDeclaredConstructor");
+            env->SetObjectArrayElement(arr, i, classes[static_cast<size_t>(i)]);
         }
+        return arr;
+    }
+
+    jobject resolve_method(JNIEnv* env, jclass cls, const std::string& name, const std::vector<jclass>& param_types, bool instance_required)
+    {
+        const auto& sym = get_jni_symbols();
+        jobjectArray params_array = build_class_array(env, param_types);
+
+        jstring name_obj = env->NewStringUTF(name.c_str());
+        jobject method = env->CallObjectMethod(cls, sym.class_get_declared_method, name_obj, params_array);
+        env->DeleteLocalRef(name_obj);
+        env->DeleteLocalRef(params_array);
 
-        jobjectArray params_array = env->NewObjectArray(static_cast<jsize>(param_types.size()), class_cls, nullptr);
-        if(!params_array)
+        throw_if_jni_exception(env, "Failed to resolve Java method: " + name);
+        if(!method)
         {
-            env->DeleteLocalRef(class_cls);
-            throw std::runtime_error("Failed to allocate constructor parameter types array");
+            throw std::runtime_error("Failed to resolve Java method: " + name);
         }
 
-        for(jsize i = 0; i < static_cast<jsize>(param_types.size()); i++)
+        jint mods = env->CallIntMethod(method, sym.method_get_modifiers);
+        jboolean is_static_flag = env->CallStaticBooleanMethod(sym.modifier_cls, sym.modifier_is_static, mods);
+        bool is_static_method = is_static_flag == JNI_TRUE;
+        if(is_static_method == instance_required)
         {
-            env->SetObjectArrayElement(params_array, i, param_types[static_cast<size_t>(i)]);
+            env->DeleteLocalRef(method);
+            throw std::runtime_error("Java method static/instance mismatch for " + name);
         }
 
-        jobject ctor = env->CallObjectMethod(cls, get_declared_ctor, params_array);
+        set_accessible(env, method);
+        return method;
+    }
+
+    jobject resolve_constructor(JNIEnv* env, jclass cls, const std::vector<jclass>& param_types)
+    {
+        jobjectArray params_array = build_class_array(env, param_types);
+        jobject ctor = env->CallObjectMethod(cls, get_jni_symbols().class_get_declared_constructor, params_array);
         env->DeleteLocalRef(params_array);
-        env->DeleteLocalRef(class_cls);
 
         throw_if_jni_exception(env, "Failed to resolve Java constructor");
         if(!ctor)
@@ -1408,27 +1771,12 @@ namespace
         return ctor;
     }
 
-    jobject resolve_field(JNIEnv* env, jclass cls, const std::string& name, bool instance_required)
+    jobject resolve_field(JNIEnv* env, jclass cls, const std::string& name, bool instance_required, bool* is_final = nullptr)
     {
-        jclass class_cls = env->FindClass("java/lang/Class");
-        if(!class_cls)
-        {
-            throw_if_jni_exception(env, "Failed to find java/lang/Class");
-            throw std::runtime_error("Failed to find java/lang/Class");
-        }
-
-        jmethodID get_declared_field = env->GetMethodID(class_cls, "getDeclaredField", "(Ljava/lang/String;)Ljava/lang/reflect/Field;");
-        if(!get_declared_field)
-        {
-            env->DeleteLocalRef(class_cls);
-            throw_if_jni_exception(env, "Failed to get Class.getDeclaredField");
-            throw std::runtime_error("Failed to get Class.getDeclaredField");
-        }
-
+        const auto& sym = get_jni_symbols();
         jstring name_obj = env->NewStringUTF(name.c_str());
-        jobject field = env->CallObjectMethod(cls, get_declared_field, name_obj);
+        jobject field = env->CallObjectMethod(cls, sym.class_get_declared_field, name_obj);
         env->DeleteLocalRef(name_obj);
-        env->DeleteLocalRef(class_cls);
 
         throw_if_jni_exception(env, "Failed to resolve Java field: " + name);
         if(!field)
@@ -1436,37 +1784,76 @@ namespace
             throw std::runtime_error("Failed to resolve Java field: " + name);
         }
 
-        jclass field_cls = env->FindClass("java/lang/reflect/Field");
-        jmethodID get_mods = env->GetMethodID(field_cls, "getModifiers", "()I");
-        jclass modifier_cls = env->FindClass("java/lang/reflect/Modifier");
-        jmethodID is_static = env->GetStaticMethodID(modifier_cls, "isStatic", "(I)Z");
-        if(!get_mods || !is_static)
-        {
-            env->DeleteLocalRef(field_cls);
-            env->DeleteLocalRef(modifier_cls);
-            env->DeleteLocalRef(field);
-            throw_if_jni_exception(env, "Failed to inspect field modifiers");
-            throw std::runtime_error("Failed to inspect field modifiers");
-        }
-
-        jint mods = env->CallIntMethod(field, get_mods);
-        jboolean is_static_flag = env->CallStaticBooleanMethod(modifier_cls, is_static, mods);
+        jint mods = env->CallIntMethod(field, sym.field_get_modifiers);
+        jboolean is_static_flag = env->CallStaticBooleanMethod(sym.modifier_cls, sym.modifier_is_static, mods);
         bool is_static_field = is_static_flag == JNI_TRUE;
         if(is_static_field == instance_required)
         {
-            env->DeleteLocalRef(field_cls);
-            env->DeleteLocalRef(modifier_cls);
             env->DeleteLocalRef(field);
             throw std::runtime_error("Java field static/instance mismatch for " + name);
         }
 
-        env->DeleteLocalRef(field_cls);
-        env->DeleteLocalRef(modifier_cls);
+        if(is_final)
+        {
+            *is_final = env->CallStaticBooleanMethod(sym.modifier_cls, sym.modifier_is_final, mods) == JNI_TRUE;
+        }
 
         set_accessible(env, field);
         return field;
     }
 
+    jni_ret_type jni_kind_of_class(JNIEnv* env, jobject type_cls)
+    {
+        jstring name = (jstring)env->CallObjectMethod(type_cls, get_jni_symbols().class_get_name);
+        throw_if_jni_exception(env, "Failed to get class name");
+
+        const char* name_str = env->GetStringUTFChars(name, nullptr);
+        std::string type_name = name_str ? name_str : "";
+        env->ReleaseStringUTFChars(name, name_str);
+        env->DeleteLocalRef(name);
+
+        if(type_name == "void") return jni_ret_type::void_type;
+        if(type_name == "boolean") return jni_ret_type::boolean_type;
+        if(type_name == "byte") return jni_ret_type::byte_type;
+        if(type_name == "short") return jni_ret_type::short_type;
+        if(type_name == "int") return jni_ret_type::int_type;
+        if(type_name == "long") return jni_ret_type::long_type;
+        if(type_name == "float") return jni_ret_type::float_type;
+        if(type_name == "double") return jni_ret_type::double_type;
+        if(type_name == "char") return jni_ret_type::char_type;
+        return jni_ret_type::object_type;
+    }
+
+    jni_ret_type resolve_member_jni_kind(JNIEnv* env, jobject member, jmethodID type_getter)
+    {
+        jobject type_cls = env->CallObjectMethod(member, type_getter);
+        throw_if_jni_exception(env, "Failed to inspect member type");
+        jni_ret_type kind = jni_kind_of_class(env, type_cls);
+        env->DeleteLocalRef(type_cls);
+        return kind;
+    }
+
+    jni_ret_type resolve_method_ret_type(JNIEnv* env, jobject method)
+    {
+        return resolve_member_jni_kind(env, method, get_jni_symbols().method_get_return_type);
+    }
+
+    jni_ret_type resolve_field_type(JNIEnv* env, jobject field)
+    {
+        return resolve_member_jni_kind(env, field, get_jni_symbols().field_get_type);
+    }
+
+    // Decide whether a method resolved by load_entity can be dispatched through typed
+    // Call<Type>MethodA. The JNI call must use the Java method's actual return kind;
+    // object returns are unboxed by store_return_value_from_object, and a primitive return
+    // is only usable if it matches the declared type exactly (otherwise reflection converts it).
+    bool can_call_direct(jni_ret_type actual, jni_ret_type declared)
+    {
+        return actual == declared ||
+               actual == jni_ret_type::object_type ||
+               declared == jni_ret_type::void_type;
+    }
+
     char ret_sig_from_type(jni_ret_type type)
     {
         switch(type)
@@ -1486,55 +1873,206 @@ namespace
         }
     }
 
-    void invoke_direct_call(entity_context* ctx, JNIEnv* env, cdts_jvm_serializer* params_ser, cdts_jvm_serializer* ret_ser)
+    jvalue read_wrapper_field(JNIEnv* env, jobject wrapper, const wrapper_field& field)
     {
-        if(!ctx)
+        jvalue value{};
+        switch(field.kind)
         {
-            throw std::runtime_error("Context is null");
+            case jni_ret_type::boolean_type: value.z = env->GetBooleanField(wrapper, field.id); break;
+            case jni_ret_type::byte_type: value.b = env->GetByteField(wrapper, field.id); break;
+            case jni_ret_type::short_type: value.s = env->GetShortField(wrapper, field.id); break;
+            case jni_ret_type::int_type: value.i = env->GetIntField(wrapper, field.id); break;
+            case jni_ret_type::long_type: value.j = env->GetLongField(wrapper, field.id); break;
+            case jni_ret_type::float_type: value.f = env->GetFloatField(wrapper, field.id); break;
+            case jni_ret_type::double_type: value.d = env->GetDoubleField(wrapper, field.id); break;
+            case jni_ret_type::char_type: value.c = env->GetCharField(wrapper, field.id); break;
+            case jni_ret_type::object_type:
+            case jni_ret_type::void_type:
+                value.l = env->GetObjectField(wrapper, field.id);
+                break;
         }
+        return value;
+    }
 
-        size_t param_count = ctx->params_types.size();
-        size_t param_offset = ctx->direct_ctx.instance_required ? 1 : 0;
-        if(param_offset > param_count)
+    jobject box_jvalue(JNIEnv* env, jni_ret_type kind, jvalue value)
+    {
+        switch(kind)
         {
-            throw std::runtime_error("Instance parameter is missing");
+            case jni_ret_type::boolean_type: return box_boolean(env, value.z);
+            case jni_ret_type::byte_type: return box_byte(env, value.b);
+            case jni_ret_type::short_type: return box_short(env, value.s);
+            case jni_ret_type::int_type: return box_int(env, value.i);
+            case jni_ret_type::long_type: return box_long(env, value.j);
+            case jni_ret_type::float_type: return box_float(env, value.f);
+            case jni_ret_type::double_type: return box_double(env, value.d);
+            case jni_ret_type::char_type: return box_char(env, value.c);
+            case jni_ret_type::object_type:
+            case jni_ret_type::void_type:
+            default:
+                return value.l;
         }
+    }
 
-        jobject instance = nullptr;
-        if(ctx->direct_ctx.instance_required)
+    std::unique_ptr<wrapper_layout> resolve_wrapper_layout(JNIEnv* env, jclass cls, const std::vector<metaffi_type_info>& retvals)
+    {
+        const auto& sym = get_jni_symbols();
+        auto layout = std::make_unique<wrapper_layout>();
+
+        if(env->IsAssignableFrom(cls, sym.object_array_cls) == JNI_TRUE)
         {
-            if(!params_ser)
+            layout->object_array = true;
+        }
+        else
+        {
+            jobjectArray fields = (jobjectArray)env->CallObjectMethod(cls, sym.class_get_declared_fields);
+            throw_if_jni_exception(env, "Failed to get declared fields from wrapper");
+            if(!fields)
             {
-                throw std::runtime_error("Parameters are required for instance call");
+                throw std::runtime_error("Failed to get declared fields from wrapper");
             }
-            instance = convert_param_to_object(env, *params_ser, ctx->params_types[0]);
-            if(instance && jni_metaffi_handle::is_metaffi_handle_wrapper_object(env, instance))
+
+            jsize count = env->GetArrayLength(fields);
+            for(jsize i = 0; i < count && layout->fields.size() < retvals.size(); i++)
             {
-                delete_local_ref_if_needed(env, instance);
-                throw std::runtime_error("Instance is not a JVM object");
+                jobject field = env->GetObjectArrayElement(fields, i);
+                jint mods = env->CallIntMethod(field, sym.field_get_modifiers);
+                jboolean static_flag = env->CallStaticBooleanMethod(sym.modifier_cls, sym.modifier_is_static, mods);
+                throw_if_jni_exception(env, "Failed to inspect wrapper field");
+
+                if(static_flag == JNI_FALSE)
+                {
+                    const metaffi_type_info& type_info = retvals[layout->fields.size()];
+                    wrapper_field wf;
+                    wf.id = env->FromReflectedField(field);
+                    if(!wf.id)
+                    {
+                        throw_if_jni_exception(env, "Failed to resolve wrapper field");
+                        throw std::runtime_error("Failed to resolve wrapper field");
+                    }
+                    wf.kind = resolve_field_type(env, field);
+                    // same rule as direct dispatch: a primitive field is stored as-is only if
+                    // it matches the declared return type, otherwise it is boxed and converted
+                    if(wf.kind == jni_ret_type::object_type || wf.kind == jni_kind_from_type_info(type_info))
+                    {
+                        wf.store = select_return_storer(type_info, ret_sig_from_type(wf.kind));
+                    }
+                    layout->fields.push_back(wf);
+                }
+                env->DeleteLocalRef(field);
+            }
+            env->DeleteLocalRef(fields);
+
+            if(layout->fields.size() < retvals.size())
+            {
+                throw std::runtime_error("Wrapper field count does not match return values");
             }
         }
 
-        std::vector<jvalue_with_sig> args;
-        std::vector<jvalue> jargs;
-        if(param_count > param_offset)
+        layout->cls = (jclass)env->NewGlobalRef(cls);
+        if(!layout->cls)
+        {
+            throw std::runtime_error("Failed to create global reference for wrapper class");
+        }
+        return layout;
+    }
+
+    const wrapper_layout& get_wrapper_layout(JNIEnv* env, entity_context* ctx, jobject wrapper)
+    {
+        jclass cls = env->GetObjectClass(wrapper);
+
+        // an entity almost always returns the same wrapper class
+        const wrapper_layout* last = ctx->last_wrapper.load(std::memory_order_acquire);
+        if(last && env->IsSameObject(cls, last->cls) == JNI_TRUE)
         {
-            args.reserve(param_count - param_offset);
-            jargs.reserve(param_count - param_offset);
+            return *last;
         }
 
-        for(size_t i = param_offset; i < param_count; i++)
+        std::lock_guard<std::mutex> lock(ctx->wrapper_mutex);
+        for(const auto& layout : ctx->wrapper_layouts)
         {
-            if(!params_ser)
+            if(env->IsSameObject(cls, layout->cls) == JNI_TRUE)
             {
-                throw std::runtime_error("Parameters are missing");
+                ctx->last_wrapper.store(layout.get(), std::memory_order_release);
+                return *layout;
             }
-            jvalue_with_sig v = convert_param_to_jvalue(env, *params_ser, ctx->params_types[i]);
-            args.push_back(v);
-            jargs.push_back(v.value);
         }
 
-        const jvalue* argv = jargs.empty() ? nullptr : jargs.data();
+        ctx->wrapper_layouts.push_back(resolve_wrapper_layout(env, cls, ctx->retvals_types));
+        const wrapper_layout* layout = ctx->wrapper_layouts.back().get();
+        ctx->last_wrapper.store(layout, std::memory_order_release);
+        return *layout;
+    }
+
+    void store_multiple_return_values(JNIEnv* env, call_serializer& ser, entity_context* ctx, jobject wrapper)
+    {
+        if(!wrapper)
+        {
+            throw std::runtime_error("Expected wrapper object for multiple return values");
+        }
+
+        const std::vector<metaffi_type_info>& retvals = ctx->retvals_types;
+        const wrapper_layout& layout = get_wrapper_layout(env, ctx, wrapper);
+
+        if(layout.object_array)
+        {
+            jobjectArray values = (jobjectArray)wrapper;
+            if(env->GetArrayLength(values) < static_cast<jsize>(retvals.size()))
+            {
+                throw std::runtime_error("Returned array has fewer elements than return values");
+            }
+
+            for(size_t i = 0; i < retvals.size(); i++)
+            {
+                jobject value = env->GetObjectArrayElement(values, static_cast<jsize>(i));
+                store_return_value_from_object(env, ser, retvals[i], value);
+            }
+            return;
+        }
+
+        for(size_t i = 0; i < retvals.size(); i++)
+        {
+            const wrapper_field& field = layout.fields[i];
+            jvalue value = read_wrapper_field(env, wrapper, field);
+            if(field.store)
+            {
+                field.store(env, ser, retvals[i], value);
+            }
+            else
+            {
+                store_return_value_from_object(env, ser, retvals[i], box_jvalue(env, field.kind, value));
+            }
+        }
+    }
+
+    jobject extract_direct_instance(JNIEnv* env, entity_context* ctx, call_serializer* params_ser)
+    {
+        if(!params_ser)
+        {
+            throw std::runtime_error("Parameters are required for instance call");
+        }
+
+        const param_step& step = ctx->plan.params[0];
+        jobject instance = step.to_object(env, *params_ser, ctx->params_types[0]);
+        if(!instance)
+        {
+            throw std::runtime_error("Instance is null");
+        }
+        if(jni_metaffi_handle::is_metaffi_handle_wrapper_object(env, instance))
+        {
+            throw std::runtime_error("Instance is not a JVM object");
+        }
+        // JNI does not type-check the receiver (unlike Method.invoke/Field.get)
+        if(env->IsInstanceOf(instance, ctx->direct_ctx.cls) == JNI_FALSE)
+        {
+            throw std::runtime_error("Instance is not of the declaring class");
+        }
+        return instance;
+    }
+
+    // one typed JNI call to the resolved method or constructor; exceptions are left pending
+    jvalue call_direct_member(JNIEnv* env, const entity_context* ctx, jobject instance, const jvalue* argv)
+    {
+        const call_plan& plan = ctx->plan;
         jvalue result{};
 
         if(ctx->direct_ctx.constructor)
@@ -1543,10 +2081,9 @@ namespace
         }
         else
         {
-            jni_ret_type ret_type = get_ret_type(ctx->retvals_types);
             if(ctx->direct_ctx.instance_required)
             {
-                switch(ret_type)
+                switch(plan.ret_kind)
                 {
                     case jni_ret_type::void_type: env->CallVoidMethodA(instance, ctx->direct_ctx.method, argv); break;
                     case jni_ret_type::boolean_type: result.z = env->CallBooleanMethodA(instance, ctx->direct_ctx.method, argv); break;
@@ -1562,7 +2099,7 @@ namespace
             }
             else
             {
-                switch(ret_type)
+                switch(plan.ret_kind)
                 {
                     case jni_ret_type::void_type: env->CallStaticVoidMethodA(ctx->direct_ctx.cls, ctx->direct_ctx.method, argv); break;
                     case jni_ret_type::boolean_type: result.z = env->CallStaticBooleanMethodA(ctx->direct_ctx.cls, ctx->direct_ctx.method, argv); break;
@@ -1577,86 +2114,273 @@ namespace
                 }
             }
         }
+        return result;
+    }
 
-        throw_if_jni_exception(env, "Failed to invoke Java method");
-
-        if(ret_ser)
-        {
-            size_t ret_count = ctx->retvals_types.size();
-            if(ret_count == 1)
-            {
-                jni_ret_type ret_type = get_ret_type(ctx->retvals_types);
-                char sig = ret_sig_from_type(ret_type);
-                store_return_value_from_jvalue(env, *ret_ser, ctx->retvals_types[0], result, sig);
-            }
-            else if(ret_count > 1)
-            {
-                store_multiple_return_values(env, *ret_ser, ctx->retvals_types, result.l);
-            }
-        }
-
-        for(const auto& arg : args)
+    // JNI does not type-check reference arguments (unlike Method.invoke/Constructor.newInstance)
+    void check_direct_arguments(JNIEnv* env, const entity_context* ctx, const jvalue* argv)
+    {
+        const call_plan& plan = ctx->plan;
+        for(size_t i = plan.first_arg; i < ctx->arg_classes.size(); i++)
         {
-            if(arg.sig == 'L')
+            jclass expected = ctx->arg_classes[i];
+            jobject arg = argv[i - plan.first_arg].l;
+            if(expected && arg && env->IsInstanceOf(arg, expected) == JNI_FALSE)
             {
-                delete_local_ref_if_needed(env, arg.value.l);
+                throw std::runtime_error("Argument " + std::to_string(i) + " is not an instance of the parameter type");
             }
         }
-
-        delete_local_ref_if_needed(env, instance);
-        if(ret_ser && ctx->retvals_types.size() >= 1 && ret_sig_from_type(get_ret_type(ctx->retvals_types)) == 'L')
-        {
-            delete_local_ref_if_needed(env, result.l);
-        }
     }
 
-    void invoke_reflection_call(entity_context* ctx, JNIEnv* env, cdts_jvm_serializer* params_ser, cdts_jvm_serializer* ret_ser)
+    // marshals the parameters and makes the typed call; returns the raw JNI result
+    jvalue invoke_direct_member(entity_context* ctx, JNIEnv* env, call_serializer* params_ser)
     {
         if(!ctx)
         {
             throw std::runtime_error("Context is null");
         }
 
-        size_t param_count = ctx->params_types.size();
-        size_t param_offset = ctx->instance_required ? 1 : 0;
-        if(param_offset > param_count)
+        const call_plan& plan = ctx->plan;
+        size_t param_count = plan.params.size();
+        if(plan.first_arg > param_count)
         {
             throw std::runtime_error("Instance parameter is missing");
         }
 
         jobject instance = nullptr;
-        if(ctx->instance_required)
+        if(ctx->direct_ctx.instance_required)
         {
-            if(!params_ser)
-            {
-                throw std::runtime_error("Parameters are required for instance call");
-            }
-            instance = convert_param_to_object(env, *params_ser, ctx->params_types[0]);
-            if(instance && jni_metaffi_handle::is_metaffi_handle_wrapper_object(env, instance))
-            {
-                delete_local_ref_if_needed(env, instance);
-                throw std::runtime_error("Instance is not a JVM object");
+            instance = extract_direct_instance(env, ctx, params_ser);
+        }
+
+        inline_buffer<jvalue, inline_arg_count> jargs(param_count - plan.first_arg);
+        if(!jargs.empty() && !params_ser)
+        {
+            throw std::runtime_error("Parameters are missing");
+        }
+
+        for(size_t i = plan.first_arg; i < param_count; i++)
+        {
+            jargs[i - plan.first_arg] = plan.params[i].to_jvalue(env, *params_ser, ctx->params_types[i]);
+        }
+
+        const jvalue* argv = jargs.empty() ? nullptr : jargs.data();
+        if(ctx->checks_arguments)
+        {
+            check_direct_arguments(env, ctx, argv);
+        }
+        jvalue result = call_direct_member(env, ctx, instance, argv);
+
+        throw_if_jni_exception(env, "Failed to invoke Java method");
+        return result;
+    }
+
+    void invoke_direct_call(entity_context* ctx, JNIEnv* env, call_serializer* params_ser, call_serializer* ret_ser)
+    {
+        jvalue result = invoke_direct_member(ctx, env, params_ser);
+        const call_plan& plan = ctx->plan;
+        if(ret_ser)
+        {
+            if(plan.store_return)
+            {
+                plan.store_return(env, *ret_ser, ctx->retvals_types[0], result);
+            }
+            else if(plan.multiple_returns)
+            {
+                store_multiple_return_values(env, *ret_ser, ctx, result.l);
             }
         }
+    }
 
-        if(ctx->is_callable)
+    // Runs a columnar batch: one serializer per parameter column, each advancing one value per
+    // row. Rows share a local frame per block instead of paying a frame per call.
+    void invoke_direct_batch(entity_context* ctx, JNIEnv* env, std::vector<std::unique_ptr<call_serializer>>& columns, call_serializer* ret_column, size_t rows)
+    {
+        const call_plan& plan = ctx->plan;
+        size_t param_count = plan.params.size();
+        inline_buffer<jvalue, inline_arg_count> jargs(param_count - plan.first_arg);
+        const jvalue* argv = jargs.empty() ? nullptr : jargs.data();
+        size_t rows_per_frame = std::max<size_t>(1, static_cast<size_t>(array_frame_capacity / plan.local_capacity));
+
+        for(size_t block = 0; block < rows; block += rows_per_frame)
+        {
+            size_t block_end = std::min(rows, block + rows_per_frame);
+            local_frame frame(env, static_cast<jint>(block_end - block) * plan.local_capacity);
+            for(size_t row = block; row < block_end; row++)
+            {
+                try
+                {
+                    jobject instance = nullptr;
+                    if(ctx->direct_ctx.instance_required)
+                    {
+                        instance = extract_direct_instance(env, ctx, columns[0].get());
+                    }
+                    for(size_t i = plan.first_arg; i < param_count; i++)
+                    {
+                        jargs[i - plan.first_arg] = plan.params[i].to_jvalue(env, *columns[i], ctx->params_types[i]);
+                    }
+                    if(ctx->checks_arguments)
+                    {
+                        check_direct_arguments(env, ctx, argv);
+                    }
+
+                    jvalue result = call_direct_member(env, ctx, instance, argv);
+                    throw_if_jni_exception(env, "Failed to invoke Java method");
+
+                    if(ret_column && plan.store_return)
+                    {
+                        plan.store_return(env, *ret_column, ctx->retvals_types[0], result);
+                    }
+                }
+                catch(const std::exception& e)
+                {
+                    throw std::runtime_error("Batch row " + std::to_string(row) + ": " + e.what());
+                }
+            }
+        }
+    }
+
+    void invoke_direct_field(entity_context* ctx, JNIEnv* env, call_serializer* params_ser, call_serializer* ret_ser)
+    {
+        if(!ctx)
+        {
+            throw std::runtime_error("Context is null");
+        }
+
+        const call_plan& plan = ctx->plan;
+        jobject instance = nullptr;
+        if(ctx->direct_ctx.instance_required)
         {
-            std::vector<jobject> args;
-            if(param_count > param_offset)
+            instance = extract_direct_instance(env, ctx, params_ser);
+        }
+
+        jclass cls = ctx->direct_ctx.cls;
+        jfieldID fid = ctx->field_id;
+
+        if(ctx->is_getter)
+        {
+            if(!ret_ser)
             {
-                args.reserve(param_count - param_offset);
+                throw std::runtime_error("Return values are required for getter");
             }
 
-            for(size_t i = param_offset; i < param_count; i++)
+            jvalue value{};
+            switch(ctx->field_type)
             {
-                if(!params_ser)
+                case jni_ret_type::boolean_type: value.z = instance ? env->GetBooleanField(instance, fid) : env->GetStaticBooleanField(cls, fid); break;
+                case jni_ret_type::byte_type: value.b = instance ? env->GetByteField(instance, fid) : env->GetStaticByteField(cls, fid); break;
+                case jni_ret_type::short_type: value.s = instance ? env->GetShortField(instance, fid) : env->GetStaticShortField(cls, fid); break;
+                case jni_ret_type::int_type: value.i = instance ? env->GetIntField(instance, fid) : env->GetStaticIntField(cls, fid); break;
+                case jni_ret_type::long_type: value.j = instance ? env->GetLongField(instance, fid) : env->GetStaticLongField(cls, fid); break;
+                case jni_ret_type::float_type: value.f = instance ? env->GetFloatField(instance, fid) : env->GetStaticFloatField(cls, fid); break;
+                case jni_ret_type::double_type: value.d = instance ? env->GetDoubleField(instance, fid) : env->GetStaticDoubleField(cls, fid); break;
+                case jni_ret_type::char_type: value.c = instance ? env->GetCharField(instance, fid) : env->GetStaticCharField(cls, fid); break;
+                case jni_ret_type::object_type:
+                case jni_ret_type::void_type:
+                    value.l = instance ? env->GetObjectField(instance, fid) : env->GetStaticObjectField(cls, fid);
+                    break;
+            }
+            throw_if_jni_exception(env, "Failed to read Java field");
+
+            if(plan.store_return)
+            {
+                plan.store_return(env, *ret_ser, ctx->retvals_types[0], value);
+            }
+            else if(plan.multiple_returns)
+            {
+                store_multiple_return_values(env, *ret_ser, ctx, value.l);
+            }
+        }
+        else
+        {
+            if(!params_ser)
+            {
+                throw std::runtime_error("Parameters are missing");
+            }
+
+            const param_step& step = plan.params[plan.first_arg];
+            const metaffi_type_info& value_type = ctx->params_types[plan.first_arg];
+            if(ctx->field_type == jni_ret_type::object_type)
+            {
+                // boxes primitives the same way Field.set would receive them
+                jobject value = step.to_object(env, *params_ser, value_type);
+                if(ctx->checks_arguments && value && env->IsInstanceOf(value, ctx->arg_classes[plan.first_arg]) == JNI_FALSE)
                 {
-                    throw std::runtime_error("Parameters are missing");
+                    throw std::runtime_error("Value is not an instance of the field type");
+                }
+                if(instance)
+                {
+                    env->SetObjectField(instance, fid, value);
+                }
+                else
+                {
+                    env->SetStaticObjectField(cls, fid, value);
+                }
+            }
+            else
+            {
+                jvalue value = step.to_jvalue(env, *params_ser, value_type);
+                switch(ctx->field_type)
+                {
+                    case jni_ret_type::boolean_type: instance ? env->SetBooleanField(instance, fid, value.z) : env->SetStaticBooleanField(cls, fid, value.z); break;
+                    case jni_ret_type::byte_type: instance ? env->SetByteField(instance, fid, value.b) : env->SetStaticByteField(cls, fid, value.b); break;
+                    case jni_ret_type::short_type: instance ? env->SetShortField(instance, fid, value.s) : env->SetStaticShortField(cls, fid, value.s); break;
+                    case jni_ret_type::int_type: instance ? env->SetIntField(instance, fid, value.i) : env->SetStaticIntField(cls, fid, value.i); break;
+                    case jni_ret_type::long_type: instance ? env->SetLongField(instance, fid, value.j) : env->SetStaticLongField(cls, fid, value.j); break;
+                    case jni_ret_type::float_type: instance ? env->SetFloatField(instance, fid, value.f) : env->SetStaticFloatField(cls, fid, value.f); break;
+                    case jni_ret_type::double_type: instance ? env->SetDoubleField(instance, fid, value.d) : env->SetStaticDoubleField(cls, fid, value.d); break;
+                    case jni_ret_type::char_type: instance ? env->SetCharField(instance, fid, value.c) : env->SetStaticCharField(cls, fid, value.c); break;
+                    case jni_ret_type::object_type:
+                    case jni_ret_type::void_type:
+                        break;
                 }
-                args.push_back(convert_param_to_object(env, *params_ser, ctx->params_types[i]));
+            }
+            throw_if_jni_exception(env, "Failed to write Java field");
+        }
+    }
+
+    void invoke_reflection_call(entity_context* ctx, JNIEnv* env, call_serializer* params_ser, call_serializer* ret_ser)
+    {
+        if(!ctx)
+        {
+            throw std::runtime_error("Context is null");
+        }
+
+        const call_plan& plan = ctx->plan;
+        size_t param_count = plan.params.size();
+        if(plan.first_arg > param_count)
+        {
+            throw std::runtime_error("Instance parameter is missing");
+        }
+
+        jobject instance = nullptr;
+        if(ctx->instance_required)
+        {
+            if(!params_ser)
+            {
+                throw std::runtime_error("Parameters are required for instance call");
+            }
+            instance = plan.params[0].to_object(env, *params_ser, ctx->params_types[0]);
+            if(instance && jni_metaffi_handle::is_metaffi_handle_wrapper_object(env, instance))
+            {
+                throw std::runtime_error("Instance is not a JVM object");
+            }
+        }
+
+        if(ctx->is_callable)
+        {
+            inline_buffer<jobject, inline_arg_count> args(param_count - plan.first_arg);
+            if(!args.empty() && !params_ser)
+            {
+                throw std::runtime_error("Parameters are missing");
+            }
+
+            for(size_t i = plan.first_arg; i < param_count; i++)
+            {
+                args[i - plan.first_arg] = plan.params[i].to_object(env, *params_ser, ctx->params_types[i]);
             }
 
-            jobjectArray args_array = build_args_array(env, args);
+            jobjectArray args_array = build_args_array(env, args.data(), args.size());
             jobject result = nullptr;
             if(ctx->is_constructor)
             {
@@ -1667,7 +2391,6 @@ namespace
                 result = invoke_method(env, ctx->member, ctx->instance_required ? instance : nullptr, args_array);
             }
 
-            env->DeleteLocalRef(args_array);
             throw_if_jni_exception(env, "Failed to invoke Java method");
 
             if(ret_ser)
@@ -1679,16 +2402,9 @@ namespace
                 }
                 else if(ret_count > 1)
                 {
-                    store_multiple_return_values(env, *ret_ser, ctx->retvals_types, result);
+                    store_multiple_return_values(env, *ret_ser, ctx, result);
                 }
             }
-
-            for(jobject arg : args)
-            {
-                delete_local_ref_if_needed(env, arg);
-            }
-
-            delete_local_ref_if_needed(env, result);
         }
         else if(ctx->is_getter || ctx->is_setter)
         {
@@ -1708,14 +2424,12 @@ namespace
                 }
                 else if(ret_count > 1)
                 {
-                    store_multiple_return_values(env, *ret_ser, ctx->retvals_types, value);
+                    store_multiple_return_values(env, *ret_ser, ctx, value);
                 }
-
-                delete_local_ref_if_needed(env, value);
             }
             else
             {
-                if(param_count < param_offset + 1)
+                if(param_count < plan.first_arg + 1)
                 {
                     throw std::runtime_error("Setter is missing value parameter");
                 }
@@ -1723,472 +2437,2068 @@ namespace
                 {
                     throw std::runtime_error("Parameters are missing");
                 }
-                jobject value = convert_param_to_object(env, *params_ser, ctx->params_types[param_offset]);
+                const param_step& step = plan.params[plan.first_arg];
+                jobject value = step.to_object(env, *params_ser, ctx->params_types[plan.first_arg]);
                 field_set_value(env, ctx->member, ctx->instance_required ? instance : nullptr, value);
                 throw_if_jni_exception(env, "Failed to write Java field");
-                delete_local_ref_if_needed(env, value);
             }
         }
         else
         {
             throw std::runtime_error("Unknown entity type");
         }
+    }
+
+    void build_call_plan(entity_context& ctx, jni_ret_type ret_kind, bool instance_required)
+    {
+        call_plan plan;
+        plan.first_arg = instance_required ? 1 : 0;
+        plan.params.resize(ctx.params_types.size());
+        for(size_t i = 0; i < ctx.params_types.size(); i++)
+        {
+            param_step& step = plan.params[i];
+            step.to_jvalue = select_jvalue_converter(ctx.params_types[i], step.sig, step.jvalue_ownership);
+            step.to_object = select_object_converter(ctx.params_types[i], step.object_ownership);
+            if(ctx.direct_buffers && is_byte_buffer_type(ctx.params_types[i]))
+            {
+                step.to_jvalue = [](JNIEnv* env, call_serializer& ser, const metaffi_type_info& ti) { jvalue v{}; v.l = byte_buffer_from_cdt(env, ser, ti); return v; };
+                step.to_object = byte_buffer_from_cdt;
+            }
+            if(step.jvalue_ownership != local_ref_ownership::none || step.object_ownership != local_ref_ownership::none)
+            {
+                plan.local_capacity += 2; // marshalled value plus a boxing or conversion temporary
+            }
+        }
+
+        plan.ret_kind = ret_kind;
+        plan.ret_sig = ret_sig_from_type(ret_kind);
+        if(ctx.retvals_types.size() == 1)
+        {
+            plan.store_return = ctx.direct_buffers && is_byte_buffer_type(ctx.retvals_types[0]) && plan.ret_sig == 'L'
+                                    ? store_byte_buffer
+                                    : select_return_storer(ctx.retvals_types[0], plan.ret_sig);
+        }
+        plan.multiple_returns = ctx.retvals_types.size() > 1;
+        // multiple returns read each value (plus a boxing temporary) from the wrapper
+        plan.local_capacity += static_cast<jint>(2 * ctx.retvals_types.size());
 
-        delete_local_ref_if_needed(env, instance);
+        ctx.plan = std::move(plan);
     }
 }
 
 static std::shared_ptr<jvm_runtime_manager> g_runtime_manager;
 static std::mutex g_runtime_mutex;
+static std::atomic<bool> g_persistent_attach{true};
 
-static void jvmxcall(entity_context* ctx, cdts* params, cdts* ret, char** out_err)
+namespace
 {
-    clear_error(out_err);
-    if(!ctx)
+    // Provides the calling thread's JNIEnv for the duration of a plugin call.
+    // By default host threads attach once and stay attached until they exit (jni_thread_env);
+    // METAFFI_JVM_ATTACH_MODE=call restores attach/detach per call through the runtime manager.
+    class scoped_env
     {
-        set_error(out_err, "Context is null");
-        return;
-    }
+    public:
+        scoped_env()
+        {
+            if(g_persistent_attach.load(std::memory_order_relaxed))
+            {
+                _env = get_thread_env();
+            }
+            else
+            {
+                _release = g_runtime_manager->get_env(&_env);
+            }
+        }
+
+        ~scoped_env()
+        {
+            if(_release)
+            {
+                _release();
+            }
+        }
+
+        scoped_env(const scoped_env&) = delete;
+        scoped_env& operator=(const scoped_env&) = delete;
+
+        [[nodiscard]] JNIEnv* get() const { return _env; }
+
+    private:
+        JNIEnv* _env = nullptr;
+        std::function<void()> _release;
+    };
+}
+
+// Dedicated threads of actor entities (entity path flag "actor"): one per module path, so a
+// library that must only be touched from one thread is, without a host-side lock. Started by
+// the module's first actor entity and stopped by free_runtime().
+static std::mutex g_actors_mutex;
+static std::map<std::string, std::shared_ptr<jvm_actor>> g_actors;
+static std::atomic<uint64_t> g_actor_calls{0};
+constexpr size_t actor_queue_capacity = 1024;
+constexpr unsigned actor_spin_iterations = 4000; // roughly the length of a short call
+
+// Entities resolved by load_entity, shared by later loads of the same key (entity_cache_key).
+// A context is reference counted by the xcalls pointing to it and by the asynchronous calls
+// still running on it; it is freed with the last reference, by free_xcall or by the call.
+// The map does not own the contexts and is emptied by free_runtime().
+static std::mutex g_entity_cache_mutex;
+static std::unordered_map<std::string, entity_context*> g_entity_cache;
+static std::atomic<uint64_t> g_entity_cache_hits{0};
+static std::atomic<uint64_t> g_entity_cache_misses{0};
 
-    if(!g_runtime_manager || !g_runtime_manager->is_runtime_loaded())
+namespace
+{
+    entity_context* acquire_cached_entity(const std::string& key)
     {
-        set_error(out_err, "JVM runtime is not loaded");
-        return;
+        std::lock_guard<std::mutex> lock(g_entity_cache_mutex);
+        auto it = g_entity_cache.find(key);
+        if(it == g_entity_cache.end())
+        {
+            return nullptr;
+        }
+        it->second->refs++;
+        return it->second;
     }
 
-    if(!params && !ctx->params_types.empty())
+    // shares ctx under key unless a concurrent load got there first, in which case ctx stays private
+    void publish_cached_entity(const std::string& key, entity_context& ctx)
     {
-        set_error(out_err, "Parameters are required but missing");
-        return;
+        std::lock_guard<std::mutex> lock(g_entity_cache_mutex);
+        if(g_entity_cache.try_emplace(key, &ctx).second)
+        {
+            ctx.cache_key = key;
+        }
     }
 
-    if(!ret && !ctx->retvals_types.empty())
+    // keeps ctx alive for a call that may outlive the xcall it was made through
+    void retain_entity(entity_context& ctx)
     {
-        set_error(out_err, "Return values are required but missing");
-        return;
+        std::lock_guard<std::mutex> lock(g_entity_cache_mutex);
+        ctx.refs++;
     }
 
-    JNIEnv* env = nullptr;
-    auto release_env = g_runtime_manager->get_env(&env);
-    metaffi::utils::scope_guard env_guard([&](){ release_env(); });
-
-    try
+    // drops one reference; true if the caller held the last one and must free ctx
+    bool release_entity(entity_context& ctx)
     {
-        std::unique_ptr<cdts_jvm_serializer> params_ser;
-        std::unique_ptr<cdts_jvm_serializer> ret_ser;
-
-        jobject class_loader = jni_class_loader::get_child_class_loader();
-        if(params)
+        std::lock_guard<std::mutex> lock(g_entity_cache_mutex);
+        if(--ctx.refs > 0)
         {
-            params_ser = std::make_unique<cdts_jvm_serializer>(env, *params, class_loader);
+            return false;
         }
-        if(ret)
+        if(!ctx.cache_key.empty())
         {
-            ret_ser = std::make_unique<cdts_jvm_serializer>(env, *ret, class_loader);
+            auto it = g_entity_cache.find(ctx.cache_key);
+            if(it != g_entity_cache.end() && it->second == &ctx)
+            {
+                g_entity_cache.erase(it);
+            }
         }
+        return true;
+    }
 
-        if(ctx->use_direct_call)
+    // deletes the global refs ctx holds; shared by free_entity() and the failure paths of
+    // resolve_entity() and make_callable(), which may have created only some of them
+    void release_entity_refs(JNIEnv* env, entity_context& ctx)
+    {
+        if(ctx.member)
         {
-            invoke_direct_call(ctx, env, params_ser.get(), ret_ser.get());
+            env->DeleteGlobalRef(ctx.member);
+            ctx.member = nullptr;
         }
-        else
+        if(ctx.direct_ctx.cls)
+        {
+            env->DeleteGlobalRef(ctx.direct_ctx.cls);
+            ctx.direct_ctx.cls = nullptr;
+        }
+        for(jclass arg_cls : ctx.arg_classes)
+        {
+            if(arg_cls)
+            {
+                env->DeleteGlobalRef(arg_cls);
+            }
+        }
+        ctx.arg_classes.clear();
+        for(const auto& layout : ctx.wrapper_layouts)
         {
-            invoke_reflection_call(ctx, env, params_ser.get(), ret_ser.get());
+            env->DeleteGlobalRef(layout->cls);
         }
+        ctx.wrapper_layouts.clear();
     }
-    catch(const std::exception& e)
+
+    // deletes ctx with its global refs, which are left to the JVM once the runtime is gone
+    void free_entity(entity_context* ctx, char** err)
     {
-        set_error(out_err, e.what());
-    }
-}
+        // keeps free_runtime() from releasing the JVM while the refs are deleted
+        runtime_call_scope runtime_scope;
+        if(runtime_scope)
+        {
+            try
+            {
+                scoped_env env_scope;
+                release_entity_refs(env_scope.get(), *ctx);
+            }
+            catch(const std::exception& e)
+            {
+                set_error(err, e.what());
+            }
+        }
 
-void load_runtime(char** err)
-{
-    clear_error(err);
-    std::lock_guard<std::mutex> lock(g_runtime_mutex);
+        delete ctx;
+    }
 
-    if(g_runtime_manager && g_runtime_manager->is_runtime_loaded())
+    // release_entity() for a retained call, freeing ctx if the xcall went first
+    void drop_entity(entity_context* ctx)
     {
-        return;
+        if(ctx && release_entity(*ctx))
+        {
+            free_entity(ctx, nullptr);
+        }
     }
 
-    try
+    void clear_entity_cache()
     {
-        trace("jvm_runtime: load_runtime start");
-        auto info = choose_jvm();
-        trace("jvm_runtime: choose_jvm ok");
-        g_runtime_manager = std::make_shared<jvm_runtime_manager>(info);
-        trace("jvm_runtime: manager created");
-        g_runtime_manager->load_runtime();
-        trace("jvm_runtime: load_runtime done");
+        std::lock_guard<std::mutex> lock(g_entity_cache_mutex);
+        g_entity_cache.clear();
     }
-    catch(const std::exception& e)
+
+    std::shared_ptr<jvm_actor> get_actor(const std::string& module_path)
     {
-        set_error(err, e.what());
+        std::lock_guard<std::mutex> lock(g_actors_mutex);
+        auto& actor = g_actors[module_path];
+        if(!actor)
+        {
+            actor = std::make_shared<jvm_actor>();
+            actor->pool = std::make_unique<jvm_worker_pool>(1, actor_queue_capacity, actor_spin_iterations);
+        }
+        return actor;
     }
-}
 
-void free_runtime(char** err)
-{
-    clear_error(err);
-    std::lock_guard<std::mutex> lock(g_runtime_mutex);
-
-    if(!g_runtime_manager)
+    // joins the actor threads; entities still holding an actor fail their calls from now on
+    void stop_actors()
     {
-        return;
+        std::map<std::string, std::shared_ptr<jvm_actor>> actors;
+        {
+            std::lock_guard<std::mutex> lock(g_actors_mutex);
+            actors.swap(g_actors);
+        }
+        for(auto& [module_path, actor] : actors)
+        {
+            actor->stopped.store(true, std::memory_order_release);
+            actor->pool.reset();
+        }
     }
 
-    try
+    constexpr const char* actor_stopped_error = "The actor thread of this entity was stopped by free_runtime; load the entity again";
+
+    // the actor's thread, or nullptr once free_runtime() has stopped it
+    jvm_worker_pool* actor_thread(const jvm_actor& actor)
     {
-        g_runtime_manager->release_runtime();
-        g_runtime_manager.reset();
+        return actor.stopped.load(std::memory_order_acquire) ? nullptr : actor.pool.get();
     }
-    catch(const std::exception& e)
+
+    constexpr const char* actor_deadline_error = "Java call deadline expired while waiting for the actor thread";
+
+    // runs fn on the actor thread and waits for it; inline when already on it (a Java
+    // callback into the host calling another entity of the module). Returns false, without
+    // running fn, if the actor is still busy with other calls when deadline passes.
+    template<typename F>
+    bool run_on_actor(jvm_worker_pool& actor, F&& fn, std::chrono::steady_clock::time_point deadline)
     {
-        set_error(err, e.what());
+        if(actor.on_worker_thread())
+        {
+            fn();
+            return true;
+        }
+
+        g_actor_calls.fetch_add(1, std::memory_order_relaxed);
+        return actor.run_sync([](void* state)
+        {
+            // the waiting caller holds the runtime for the duration of the hand-off
+            runtime_call_scope scope(runtime_call_scope::on_behalf);
+            (*static_cast<std::remove_reference_t<F>*>(state))();
+        }, &fn, deadline);
     }
 }
 
-static void jvmxcall_params_ret(entity_context* ctx, cdts params_ret[2], char** out_err)
+// Deadlines and cancellation of watched calls (entities with timeout_ms or cancellable, and
+// jvm_runtime_xcall_timeout). The watchdog thread starts with the first watched call and is
+// stopped by free_runtime().
+static std::atomic<jvm_call_watchdog*> g_watchdog{nullptr};
+static std::mutex g_watchdog_mutex;
+static std::atomic<uint64_t> g_calls_timed_out{0};
+static std::atomic<uint64_t> g_calls_cancelled{0};
+
+namespace
+{
+    using call_clock = jvm_call_watchdog::clock;
+
+    jvm_call_watchdog* get_watchdog()
+    {
+        jvm_call_watchdog* watchdog = g_watchdog.load(std::memory_order_acquire);
+        if(watchdog)
+        {
+            return watchdog;
+        }
+
+        std::lock_guard<std::mutex> lock(g_watchdog_mutex);
+        watchdog = g_watchdog.load(std::memory_order_relaxed);
+        if(!watchdog)
+        {
+            watchdog = new jvm_call_watchdog();
+            g_watchdog.store(watchdog, std::memory_order_release);
+        }
+        return watchdog;
+    }
+
+    void stop_watchdog()
+    {
+        std::lock_guard<std::mutex> lock(g_watchdog_mutex);
+        delete g_watchdog.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    call_clock::time_point deadline_after(uint64_t timeout_ms)
+    {
+        if(timeout_ms == 0)
+        {
+            return call_clock::time_point::max();
+        }
+        return call_clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+
+    // Keeps a call registered with the watchdog while it runs in Java. finish() reports an
+    // interrupted call as a timeout or cancellation, replacing whatever the interrupt made
+    // the Java code throw.
+    class watched_call
+    {
+    public:
+        watched_call(JNIEnv* env, const entity_context* ctx, call_clock::time_point deadline) : _env(env)
+        {
+            if(deadline <= call_clock::now())
+            {
+                g_calls_timed_out.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("Java call deadline expired before the call started");
+            }
+            _watchdog = get_watchdog();
+            _id = _watchdog->begin(env, ctx, deadline);
+        }
+
+        ~watched_call()
+        {
+            if(_watchdog)
+            {
+                _watchdog->end(_env, _id);
+            }
+        }
+
+        watched_call(const watched_call&) = delete;
+        watched_call& operator=(const watched_call&) = delete;
+
+        void finish()
+        {
+            jvm_call_watchdog::outcome outcome = _watchdog->end(_env, _id);
+            _watchdog = nullptr;
+            if(outcome == jvm_call_watchdog::outcome::timed_out)
+            {
+                g_calls_timed_out.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("Java call exceeded its deadline and was interrupted");
+            }
+            if(outcome == jvm_call_watchdog::outcome::cancelled)
+            {
+                g_calls_cancelled.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("Java call was cancelled");
+            }
+        }
+
+    private:
+        JNIEnv* _env;
+        jvm_call_watchdog* _watchdog = nullptr;
+        uint64_t _id = 0;
+    };
+}
+
+// Runs one call. A deadline other than time_point::max() bounds it, counting time spent
+// queued for an actor thread.
+static void jvmxcall_until(entity_context* ctx, cdts* params, cdts* ret, call_clock::time_point deadline, char** out_err)
+{
+    clear_error(out_err);
+    if(!ctx)
+    {
+        set_error(out_err, "Context is null");
+        return;
+    }
+
+    // keeps free_runtime() from tearing the runtime down under this call
+    runtime_call_scope runtime_scope;
+    if(!runtime_scope)
+    {
+        set_error(out_err, "JVM runtime is not loaded");
+        return;
+    }
+
+    if(!params && !ctx->params_types.empty())
+    {
+        set_error(out_err, "Parameters are required but missing");
+        return;
+    }
+
+    if(!ret && !ctx->retvals_types.empty())
+    {
+        set_error(out_err, "Return values are required but missing");
+        return;
+    }
+
+    if(needs_future_call(ctx))
+    {
+        set_error(out_err, "Entity returns a Java future; call it through jvm_runtime_xcall_future");
+        return;
+    }
+
+    if(ctx->actor)
+    {
+        jvm_worker_pool* actor = actor_thread(*ctx->actor);
+        if(!actor)
+        {
+            set_error(out_err, actor_stopped_error);
+            return;
+        }
+        if(!actor->on_worker_thread())
+        {
+            if(!run_on_actor(*actor, [&]() { jvmxcall_until(ctx, params, ret, deadline, out_err); }, deadline))
+            {
+                g_calls_timed_out.fetch_add(1, std::memory_order_relaxed);
+                set_error(out_err, actor_deadline_error);
+            }
+            return;
+        }
+    }
+
+    try
+    {
+        scoped_env env_scope;
+        JNIEnv* env = env_scope.get();
+
+        // all local refs of the call are released together when the frame closes
+        local_frame frame(env, ctx->plan.local_capacity);
+
+        std::optional<watched_call> watch;
+        if(deadline != call_clock::time_point::max() || ctx->cancellable)
+        {
+            watch.emplace(env, ctx, deadline);
+        }
+
+        // serializers live on the stack; the steady-state call path does not touch the heap
+        std::optional<call_serializer> params_ser;
+        std::optional<call_serializer> ret_ser;
+
+        jobject class_loader = jni_class_loader::get_child_class_loader();
+        if(params)
+        {
+            params_ser.emplace(env, *params, class_loader);
+        }
+        if(ret)
+        {
+            ret_ser.emplace(env, *ret, class_loader);
+        }
+
+        call_serializer* pparams = params_ser ? &*params_ser : nullptr;
+        call_serializer* pret = ret_ser ? &*ret_ser : nullptr;
+        try
+        {
+            if(ctx->use_direct_call)
+            {
+                invoke_direct_call(ctx, env, pparams, pret);
+            }
+            else if(ctx->use_direct_field)
+            {
+                invoke_direct_field(ctx, env, pparams, pret);
+            }
+            else
+            {
+                invoke_reflection_call(ctx, env, pparams, pret);
+            }
+        }
+        catch(const std::exception&)
+        {
+            if(watch)
+            {
+                watch->finish();
+            }
+            throw;
+        }
+
+        if(watch)
+        {
+            watch->finish();
+        }
+    }
+    catch(const std::exception& e)
+    {
+        set_error(out_err, e.what());
+    }
+}
+
+static void jvmxcall(entity_context* ctx, cdts* params, cdts* ret, char** out_err)
+{
+    jvmxcall_until(ctx, params, ret, deadline_after(ctx ? ctx->timeout_ms : 0), out_err);
+}
+
+// Worker pool of jvm_runtime_xcall_async, started by the first asynchronous call and
+// stopped by free_runtime() after the queued calls have run.
+static std::atomic<jvm_worker_pool*> g_worker_pool{nullptr};
+static std::mutex g_worker_pool_mutex;
+static std::atomic<size_t> g_async_workers{0}; // 0: one per hardware thread, at least 2
+static std::atomic<uint64_t> g_async_calls{0};
+static std::atomic<uint64_t> g_async_rejected{0};
+constexpr size_t async_queue_capacity = 65536;
+
+// Threads resolving a jvm_runtime_load_entities call, the caller's included; 0: one per
+// hardware thread.
+static std::atomic<size_t> g_load_workers{0};
+constexpr uint64_t min_entities_per_load_worker = 16; // below this a thread costs more than it saves
+
+// Helper threads of jvm_runtime_load_entities, started by the first load that needs them and
+// stopped by free_runtime(); they stay attached to the JVM from one load to the next.
+static std::mutex g_load_pool_mutex;
+static jvm_worker_pool* g_load_pool = nullptr; // guarded by g_load_pool_mutex
+constexpr size_t load_queue_capacity = 1024;
+
+namespace
+{
+    struct async_call
+    {
+        entity_context* ctx;
+        cdts* params;
+        cdts* ret;
+        jvm_xcall_completion on_complete;
+        void* user_data;
+    };
+
+    jvm_worker_pool* get_worker_pool()
+    {
+        jvm_worker_pool* pool = g_worker_pool.load(std::memory_order_acquire);
+        if(pool)
+        {
+            return pool;
+        }
+
+        std::lock_guard<std::mutex> lock(g_worker_pool_mutex);
+        pool = g_worker_pool.load(std::memory_order_relaxed);
+        if(!pool)
+        {
+            size_t workers = g_async_workers.load(std::memory_order_relaxed);
+            if(workers == 0)
+            {
+                workers = std::max<size_t>(2, std::thread::hardware_concurrency());
+            }
+            pool = new jvm_worker_pool(workers, async_queue_capacity);
+            g_worker_pool.store(pool, std::memory_order_release);
+        }
+        return pool;
+    }
+
+    void stop_worker_pool()
+    {
+        std::lock_guard<std::mutex> lock(g_worker_pool_mutex);
+        delete g_worker_pool.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    jvm_worker_pool* get_load_pool()
+    {
+        std::lock_guard<std::mutex> lock(g_load_pool_mutex);
+        if(!g_load_pool)
+        {
+            size_t threads = g_load_workers.load(std::memory_order_relaxed);
+            if(threads == 0)
+            {
+                threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            }
+            g_load_pool = new jvm_worker_pool(std::max<size_t>(1, threads - 1), load_queue_capacity);
+        }
+        return g_load_pool;
+    }
+
+    void stop_load_pool()
+    {
+        std::lock_guard<std::mutex> lock(g_load_pool_mutex);
+        delete g_load_pool;
+        g_load_pool = nullptr;
+    }
+
+    // true on a worker of the asynchronous call pool or on an actor thread (a completion
+    // callback or a host callback made from a call running there)
+    bool on_runtime_thread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_worker_pool_mutex);
+            jvm_worker_pool* pool = g_worker_pool.load(std::memory_order_acquire);
+            if(pool && pool->on_worker_thread())
+            {
+                return true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(g_actors_mutex);
+        for(const auto& [module_path, actor] : g_actors)
+        {
+            if(actor->pool && actor->pool->on_worker_thread())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+static void jvmxcall(entity_context* ctx, cdts* params, cdts* ret, char** out_err);
+
+static void run_async_call(void* state)
+{
+    std::unique_ptr<async_call> call(static_cast<async_call*>(state));
+    char* err = nullptr;
+    jvmxcall(call->ctx, call->params, call->ret, &err);
+    drop_entity(call->ctx); // retained by jvm_runtime_xcall_async
+    call->on_complete(call->user_data, err);
+}
+
+namespace
+{
+    // a call of jvm_runtime_xcall_future whose stage has not completed yet
+    struct pending_future
+    {
+        entity_context* ctx; // retained until the future completes
+        cdts* ret;
+        jvm_xcall_completion on_complete;
+        void* user_data;
+    };
+
+    // Bridged futures by the token their continuation carries. Tokens are never reused, so a
+    // continuation that fires after free_runtime() failed its future finds nothing; whoever
+    // takes a future out of the map completes it.
+    std::mutex g_pending_futures_mutex;
+    std::unordered_map<uint64_t, std::unique_ptr<pending_future>> g_pending_futures;
+    uint64_t g_next_future_token = 1; // guarded by g_pending_futures_mutex
+
+    uint64_t add_pending_future(std::unique_ptr<pending_future> pending)
+    {
+        std::lock_guard<std::mutex> lock(g_pending_futures_mutex);
+        uint64_t token = g_next_future_token++;
+        g_pending_futures.emplace(token, std::move(pending));
+        return token;
+    }
+
+    std::unique_ptr<pending_future> take_pending_future(uint64_t token)
+    {
+        std::lock_guard<std::mutex> lock(g_pending_futures_mutex);
+        auto it = g_pending_futures.find(token);
+        if(it == g_pending_futures.end())
+        {
+            return nullptr;
+        }
+        std::unique_ptr<pending_future> pending = std::move(it->second);
+        g_pending_futures.erase(it);
+        return pending;
+    }
+
+    void finish_future(std::unique_ptr<pending_future> pending, char* err)
+    {
+        drop_entity(pending->ctx); // retained by jvm_runtime_xcall_future
+        pending->on_complete(pending->user_data, err);
+    }
+
+    // FutureCompletion callback: runs on the Java thread that completed the stage, inside a
+    // runtime call
+    void complete_future(JNIEnv* env, void* token, jobject value, jthrowable error)
+    {
+        std::unique_ptr<pending_future> pending = take_pending_future(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(token)));
+        if(!pending)
+        {
+            return; // failed by free_runtime()
+        }
+
+        char* err = nullptr;
+        try
+        {
+            entity_context* ctx = pending->ctx;
+            local_frame frame(env, ctx->plan.local_capacity + 1);
+            if(error)
+            {
+                env->Throw(error);
+                set_error(&err, "Java future completed exceptionally: " + get_exception_description(env));
+                env->ExceptionClear();
+            }
+            else
+            {
+                call_serializer ret_ser(env, *pending->ret, jni_class_loader::get_child_class_loader());
+                jvalue result{};
+                result.l = value;
+                ctx->plan.store_return(env, ret_ser, ctx->retvals_types[0], result);
+            }
+        }
+        catch(const std::exception& e)
+        {
+            set_error(&err, e.what());
+        }
+
+        // nothing in the Java continuation can act on a leftover exception
+        if(env->ExceptionCheck())
+        {
+            env->ExceptionClear();
+        }
+        finish_future(std::move(pending), err);
+    }
+
+    // called by free_runtime() once no call is in flight: continuations that run from here on
+    // cannot reach the plugin, so the futures still pending fail now
+    void fail_pending_futures()
+    {
+        std::unordered_map<uint64_t, std::unique_ptr<pending_future>> pending;
+        {
+            std::lock_guard<std::mutex> lock(g_pending_futures_mutex);
+            pending.swap(g_pending_futures);
+        }
+
+        for(auto& [token, future] : pending)
+        {
+            char* err = nullptr;
+            set_error(&err, "JVM runtime was unloaded before the future completed");
+            finish_future(std::move(future), err);
+        }
+    }
+}
+
+static void jvmxcall_batch(entity_context* ctx, cdts* params, cdts* results, uint64_t rows, char** out_err)
+{
+    clear_error(out_err);
+    if(!ctx)
+    {
+        set_error(out_err, "Context is null");
+        return;
+    }
+
+    // keeps free_runtime() from tearing the runtime down under this call
+    runtime_call_scope runtime_scope;
+    if(!runtime_scope)
+    {
+        set_error(out_err, "JVM runtime is not loaded");
+        return;
+    }
+
+    // fields and reflection-invoked members read their values from one sequential serializer
+    if(!ctx->use_direct_call)
+    {
+        set_error(out_err, "Batched calls support directly invoked methods and constructors only");
+        return;
+    }
+
+    if(ctx->retvals_types.size() > 1)
+    {
+        set_error(out_err, "Batched calls support at most one return value");
+        return;
+    }
+
+    if(needs_future_call(ctx))
+    {
+        set_error(out_err, "Entity returns a Java future; call it through jvm_runtime_xcall_future");
+        return;
+    }
+
+    size_t param_count = ctx->params_types.size();
+    if(param_count > 0 && (!params || params->length != param_count))
+    {
+        set_error(out_err, "Batch requires one column per parameter");
+        return;
+    }
+
+    if(!ctx->retvals_types.empty() && (!results || results->length != 1))
+    {
+        set_error(out_err, "Batch requires a result column");
+        return;
+    }
+
+    for(size_t i = 0; i < param_count; i++)
+    {
+        cdt& column = (*params)[i];
+        if(!is_array_type(column.type) || static_cast<cdts&>(column).length != rows)
+        {
+            set_error(out_err, "Batch parameter column " + std::to_string(i) + " must be an array of " + std::to_string(rows) + " values");
+            return;
+        }
+    }
+
+    // the whole batch is one hand-off to the actor thread
+    if(ctx->actor)
+    {
+        jvm_worker_pool* actor = actor_thread(*ctx->actor);
+        if(!actor)
+        {
+            set_error(out_err, actor_stopped_error);
+            return;
+        }
+        if(!actor->on_worker_thread())
+        {
+            if(!run_on_actor(*actor, [&]() { jvmxcall_batch(ctx, params, results, rows, out_err); }, deadline_after(ctx->timeout_ms)))
+            {
+                g_calls_timed_out.fetch_add(1, std::memory_order_relaxed);
+                set_error(out_err, actor_deadline_error);
+            }
+            return;
+        }
+    }
+
+    try
+    {
+        scoped_env env_scope;
+        JNIEnv* env = env_scope.get();
+
+        jobject class_loader = jni_class_loader::get_child_class_loader();
+        std::vector<std::unique_ptr<call_serializer>> columns;
+        columns.reserve(param_count);
+        for(size_t i = 0; i < param_count; i++)
+        {
+            columns.push_back(std::make_unique<call_serializer>(env, static_cast<cdts&>((*params)[i]), class_loader));
+        }
+
+        std::optional<call_serializer> ret_column;
+        if(!ctx->retvals_types.empty())
+        {
+            const metaffi_type_info& ti = ctx->retvals_types[0];
+            cdt& column = (*results)[0];
+            if(is_array_type(ti.type))
+            {
+                column.set_new_array(rows, ti.fixed_dimensions > 0 ? ti.fixed_dimensions + 1 : MIXED_OR_UNKNOWN_DIMENSIONS, base_type(ti.type));
+            }
+            else
+            {
+                column.set_new_array(rows, 1, ti.type);
+            }
+            ret_column.emplace(env, static_cast<cdts&>(column), class_loader);
+        }
+
+        invoke_direct_batch(ctx, env, columns, ret_column ? &*ret_column : nullptr, static_cast<size_t>(rows));
+    }
+    catch(const std::exception& e)
+    {
+        set_error(out_err, e.what());
+    }
+}
+
+void load_runtime(char** err)
+{
+    clear_error(err);
+    std::lock_guard<std::mutex> lock(g_runtime_mutex);
+
+    if(g_runtime_manager && g_runtime_manager->is_runtime_loaded())
+    {
+        return;
+    }
+
+    try
+    {
+        trace("jvm_runtime: load_runtime start");
+        auto info = choose_jvm();
+        trace("jvm_runtime: choose_jvm ok");
+        g_runtime_manager = std::make_shared<jvm_runtime_manager>(info);
+        trace("jvm_runtime: manager created");
+        g_runtime_manager->load_runtime();
+        trace("jvm_runtime: load_runtime done");
+
+        JNIEnv* env = nullptr;
+        auto release_env = g_runtime_manager->get_env(&env);
+        metaffi::utils::scope_guard env_guard([&](){ release_env(); });
+        load_jni_symbols(env);
+        trace("jvm_runtime: jni symbols loaded");
+        if(!load_string_array_helper(env))
+        {
+            trace("jvm_runtime: String[] helper unavailable, using per-element marshalling");
+        }
+        if(!load_future_bridge(env, complete_future))
+        {
+            trace("jvm_runtime: future bridge unavailable, jvm_runtime_xcall_future disabled");
+        }
+
+        JavaVM* vm = nullptr;
+        if(env->GetJavaVM(&vm) != JNI_OK || !vm)
+        {
+            throw std::runtime_error("Failed to get JavaVM");
+        }
+        set_thread_env_jvm(vm);
+        g_persistent_attach.store(get_env_var("METAFFI_JVM_ATTACH_MODE") != "call", std::memory_order_relaxed);
+
+        std::string critical_threshold = get_env_var("METAFFI_JVM_CRITICAL_ARRAY_THRESHOLD");
+        if(!critical_threshold.empty())
+        {
+            try
+            {
+                set_critical_array_threshold(static_cast<size_t>(std::stoull(critical_threshold)));
+            }
+            catch(const std::exception&)
+            {
+                throw std::runtime_error("METAFFI_JVM_CRITICAL_ARRAY_THRESHOLD must be a byte count, got: " + critical_threshold);
+            }
+        }
+
+        std::string string_cache_capacity = get_env_var("METAFFI_JVM_STRING_CACHE_CAPACITY");
+        if(!string_cache_capacity.empty())
+        {
+            try
+            {
+                set_string_cache_capacity(static_cast<size_t>(std::stoull(string_cache_capacity)));
+            }
+            catch(const std::exception&)
+            {
+                throw std::runtime_error("METAFFI_JVM_STRING_CACHE_CAPACITY must be an entry count, got: " + string_cache_capacity);
+            }
+        }
+
+        std::string async_workers = get_env_var("METAFFI_JVM_ASYNC_WORKERS");
+        if(!async_workers.empty())
+        {
+            try
+            {
+                g_async_workers.store(static_cast<size_t>(std::stoull(async_workers)), std::memory_order_relaxed);
+            }
+            catch(const std::exception&)
+            {
+                throw std::runtime_error("METAFFI_JVM_ASYNC_WORKERS must be a thread count, got: " + async_workers);
+            }
+        }
+
+        std::string load_workers = get_env_var("METAFFI_JVM_LOAD_WORKERS");
+        if(!load_workers.empty())
+        {
+            try
+            {
+                g_load_workers.store(static_cast<size_t>(std::stoull(load_workers)), std::memory_order_relaxed);
+            }
+            catch(const std::exception&)
+            {
+                throw std::runtime_error("METAFFI_JVM_LOAD_WORKERS must be a thread count, got: " + load_workers);
+            }
+        }
+
+        publish_runtime();
+    }
+    catch(const std::exception& e)
+    {
+        set_error(err, e.what());
+    }
+}
+
+void free_runtime(char** err)
+{
+    clear_error(err);
+    std::lock_guard<std::mutex> lock(g_runtime_mutex);
+
+    if(!g_runtime_manager)
+    {
+        return;
+    }
+
+    try
+    {
+        // the pool and actor threads are joined below, which a thread cannot do to itself, and a
+        // call in progress would wait for its own drain
+        if(in_runtime_call() || on_runtime_thread())
+        {
+            set_error(err, "free_runtime cannot be called from inside a JVM call or from a JVM runtime thread");
+            return;
+        }
+
+        // queued asynchronous calls still need the runtime, and may be waiting on actors
+        stop_worker_pool();
+
+        // from here on calls fail fast; the ones in flight run to completion first
+        if(!withdraw_runtime())
+        {
+            set_error(err, "free_runtime cannot be called from inside a JVM call");
+            return;
+        }
+
+        // asynchronous calls submitted while the pool was stopping fail without the runtime
+        stop_worker_pool();
+        stop_load_pool();
+        stop_actors();
+        stop_watchdog();
+        fail_pending_futures();
+
+        // entities loaded from now on resolve against the next runtime; live xcalls keep theirs
+        clear_entity_cache();
+
+        if(g_runtime_manager->is_runtime_loaded())
+        {
+            JNIEnv* env = nullptr;
+            auto release_env = g_runtime_manager->get_env(&env);
+            metaffi::utils::scope_guard env_guard([&](){ release_env(); });
+            release_array_class_cache(env);
+            release_class_cache(env);
+            release_jclass_memo(env);
+            release_string_array_helper(env);
+            release_future_bridge(env);
+            release_string_cache(env);
+            release_jni_symbols(env);
+        }
+
+        release_thread_env_jvm();
+        g_runtime_manager->release_runtime();
+        g_runtime_manager.reset();
+    }
+    catch(const std::exception& e)
+    {
+        set_error(err, e.what());
+    }
+}
+
+static void jvmxcall_params_ret(entity_context* ctx, cdts params_ret[2], char** out_err)
 {
     jvmxcall(ctx, &params_ret[0], &params_ret[1], out_err);
 }
 
-static void jvmxcall_params_no_ret(entity_context* ctx, cdts parameters[1], char** out_err)
+static void jvmxcall_params_no_ret(entity_context* ctx, cdts parameters[1], char** out_err)
+{
+    jvmxcall(ctx, &parameters[0], nullptr, out_err);
+}
+
+static void jvmxcall_no_params_ret(entity_context* ctx, cdts return_values[1], char** out_err)
+{
+    jvmxcall(ctx, nullptr, &return_values[0], out_err);
+}
+
+static void jvmxcall_no_params_no_ret(entity_context* ctx, char** out_err)
+{
+    jvmxcall(ctx, nullptr, nullptr, out_err);
+}
+
+// IMPORTANT: the name of the function must be different from xcall_* to avoid symbol conflicts.
+static void jvm_api_xcall_params_ret(void* context, cdts params_ret[2], char** out_err)
+{
+    auto* ctx = static_cast<entity_context*>(context);
+    jvmxcall_params_ret(ctx, params_ret, out_err);
+}
+
+static void jvm_api_xcall_params_no_ret(void* context, cdts parameters[1], char** out_err)
+{
+    auto* ctx = static_cast<entity_context*>(context);
+    jvmxcall_params_no_ret(ctx, parameters, out_err);
+}
+
+static void jvm_api_xcall_no_params_ret(void* context, cdts return_values[1], char** out_err)
+{
+    auto* ctx = static_cast<entity_context*>(context);
+    jvmxcall_no_params_ret(ctx, return_values, out_err);
+}
+
+static void jvm_api_xcall_no_params_no_ret(void* context, char** out_err)
+{
+    auto* ctx = static_cast<entity_context*>(context);
+    jvmxcall_no_params_no_ret(ctx, out_err);
+}
+
+static void* select_xcall_func(const entity_context& ctx)
+{
+    return ctx.params_types.empty() && ctx.retvals_types.empty() ? (void*)jvm_api_xcall_no_params_no_ret
+           : ctx.params_types.empty() ? (void*)jvm_api_xcall_no_params_ret
+           : ctx.retvals_types.empty() ? (void*)jvm_api_xcall_params_no_ret
+           : (void*)jvm_api_xcall_params_ret;
+}
+
+// Enters a runtime call for the entry points that are not calls (loading entities, making
+// callables), loading the runtime first if it is not. False, with err set, if it cannot be
+// loaded or free_runtime() got in between.
+static bool enter_loaded_runtime(std::optional<runtime_call_scope>& runtime_scope, char** err)
+{
+    runtime_scope.emplace();
+    if(*runtime_scope)
+    {
+        return true;
+    }
+    runtime_scope.reset();
+
+    load_runtime(err);
+    if(err && *err)
+    {
+        return false;
+    }
+    runtime_scope.emplace();
+    if(!*runtime_scope)
+    {
+        runtime_scope.reset();
+        set_error(err, "JVM runtime is not loaded");
+        return false;
+    }
+    return true;
+}
+
+// The argument errors load_entity reports before touching the JVM, or nullptr.
+static const char* check_entity_args(const char* entity_path, const metaffi_type_info* params_types, int8_t params_count, const metaffi_type_info* retvals_types, int8_t retval_count)
+{
+    if(!entity_path || !*entity_path)
+    {
+        return "Entity path is empty";
+    }
+    if(params_count > 0 && !params_types)
+    {
+        return "Parameter types are missing";
+    }
+    if(retval_count > 0 && !retvals_types)
+    {
+        return "Return types are missing";
+    }
+    return nullptr;
+}
+
+// An xcall over the entity cached under key, or nullptr on a miss.
+static xcall* share_cached_entity(const std::string& key)
+{
+    if(entity_context* cached = acquire_cached_entity(key))
+    {
+        g_entity_cache_hits.fetch_add(1, std::memory_order_relaxed);
+        return new xcall(select_xcall_func(*cached), cached);
+    }
+    g_entity_cache_misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+// Resolves an entity missing from the entity cache through the module's class loader, and
+// shares it under cache_key.
+static xcall* resolve_entity(JNIEnv* env, jni_class_loader& loader, const char* module_path, const char* entity_path, metaffi_type_info* params_types, int8_t params_count, metaffi_type_info* retvals_types, int8_t retval_count, const std::string& cache_key, char** err)
+{
+    std::unique_ptr<entity_context> ctx;
+    try
+    {
+        ctx = std::make_unique<entity_context>();
+        if(params_types && params_count > 0)
+        {
+            ctx->params_types.assign(params_types, params_types + params_count);
+        }
+        if(retvals_types && retval_count > 0)
+        {
+            ctx->retvals_types.assign(retvals_types, retvals_types + retval_count);
+        }
+
+        metaffi::utils::entity_path_parser fp(entity_path);
+        if(!fp.contains("class"))
+        {
+            set_error(err, "Entity path must include class");
+            return nullptr;
+        }
+
+        ctx->instance_required = fp.contains("instance_required");
+        ctx->direct_buffers = fp.contains("buffer") && fp["buffer"] == "direct";
+        if(fp.contains("actor"))
+        {
+            ctx->actor = get_actor(module_path ? module_path : "");
+        }
+        if(fp.contains("timeout_ms"))
+        {
+            try
+            {
+                ctx->timeout_ms = std::stoull(fp["timeout_ms"]);
+            }
+            catch(const std::exception&)
+            {
+                throw std::runtime_error("timeout_ms must be a number of milliseconds, got: " + fp["timeout_ms"]);
+            }
+        }
+        ctx->cancellable = ctx->timeout_ms > 0 || fp.contains("cancellable");
+
+        std::string class_name = fp["class"];
+        jclass cls = load_class_with_fallback(env, loader, class_name);
+        jni_ret_type plan_ret_kind = get_ret_type(ctx->retvals_types);
+
+        if(fp.contains("callable"))
+        {
+            std::string callable = fp["callable"];
+            ctx->is_callable = true;
+            ctx->is_constructor = (callable == "<init>");
+
+            if(ctx->is_constructor && ctx->instance_required)
+            {
+                throw std::runtime_error("Constructor cannot require instance");
+            }
+            if(ctx->is_constructor && ctx->retvals_types.size() != 1)
+            {
+                throw std::runtime_error("Constructor must return exactly one value");
+            }
+
+            // the alias marks the Java return type; the declared metaffi type is the completed value's
+            ctx->returns_future = !ctx->is_constructor && ctx->retvals_types.size() == 1 && is_future_alias(ctx->retvals_types[0].alias);
+
+            size_t param_offset = ctx->instance_required ? 1 : 0;
+            if(ctx->params_types.size() < param_offset)
+            {
+                throw std::runtime_error("Instance parameter is missing");
+            }
+
+            std::vector<jclass> param_classes;
+            for(size_t i = param_offset; i < ctx->params_types.size(); i++)
+            {
+                if(ctx->direct_buffers && is_byte_buffer_type(ctx->params_types[i]))
+                {
+                    param_classes.push_back(get_jni_symbols().byte_buffer_cls);
+                    continue;
+                }
+                param_classes.push_back(resolve_jclass(env, ctx->params_types[i], &loader));
+            }
+
+            jobject member = nullptr;
+            if(ctx->is_constructor)
+            {
+                member = resolve_constructor(env, cls, param_classes);
+            }
+            else
+            {
+                member = resolve_method(env, cls, callable, param_classes, ctx->instance_required);
+            }
+
+            // prefer typed JNI dispatch; the reflected member is kept for the reflection fallback
+            jni_ret_type actual_ret = ctx->is_constructor ? jni_ret_type::object_type : resolve_method_ret_type(env, member);
+            jmethodID method_id = env->FromReflectedMethod(member);
+            if(method_id && (ctx->is_constructor || ctx->returns_future || can_call_direct(actual_ret, get_ret_type(ctx->retvals_types))))
+            {
+                jclass global_cls = (jclass)env->NewGlobalRef(cls);
+                if(!global_cls)
+                {
+                    env->DeleteLocalRef(member);
+                    throw std::runtime_error("Failed to create global reference for declaring class");
+                }
+
+                ctx->use_direct_call = true;
+                plan_ret_kind = actual_ret;
+                ctx->direct_ctx.cls = global_cls;
+                ctx->direct_ctx.method = method_id;
+                ctx->direct_ctx.instance_required = ctx->instance_required;
+                ctx->direct_ctx.constructor = ctx->is_constructor;
+
+                // every reference argument (handles, strings, arrays) is checked against the
+                // parameter class, as the host value may not match its declared type;
+                // Object parameters take them all
+                const auto& sym = get_jni_symbols();
+                ctx->arg_classes.assign(ctx->params_types.size(), nullptr);
+                for(size_t i = param_offset; i < ctx->params_types.size(); i++)
+                {
+                    jclass pc = param_classes[i - param_offset];
+                    if(jni_kind_from_type_info(ctx->params_types[i]) == jni_ret_type::object_type && env->IsSameObject(pc, sym.object_cls) == JNI_FALSE)
+                    {
+                        ctx->arg_classes[i] = (jclass)env->NewGlobalRef(pc);
+                        ctx->checks_arguments = ctx->checks_arguments || ctx->arg_classes[i];
+                    }
+                }
+            }
+            else
+            {
+                trace("jvm_runtime: reflection fallback for " + class_name + "." + callable);
+            }
+
+            ctx->member = env->NewGlobalRef(member);
+            env->DeleteLocalRef(member);
+            if(!ctx->member)
+            {
+                throw std::runtime_error("Failed to create global reference for method");
+            }
+        }
+        else if(fp.contains("field"))
+        {
+            std::string field_name = fp["field"];
+            bool is_getter = fp.contains("getter");
+            bool is_setter = fp.contains("setter");
+            if(is_getter == is_setter)
+            {
+                throw std::runtime_error("Field entity must be getter or setter");
+            }
+            ctx->is_getter = is_getter;
+            ctx->is_setter = is_setter;
+
+            if(is_getter)
+            {
+                size_t expected_params = ctx->instance_required ? 1 : 0;
+                if(ctx->params_types.size() != expected_params)
+                {
+                    throw std::runtime_error("Getter parameter count mismatch");
+                }
+                if(ctx->retvals_types.empty())
+                {
+                    throw std::runtime_error("Getter requires a return value");
+                }
+            }
+            else
+            {
+                size_t expected_params = ctx->instance_required ? 2 : 1;
+                if(ctx->params_types.size() != expected_params)
+                {
+                    throw std::runtime_error("Setter parameter count mismatch");
+                }
+                if(!ctx->retvals_types.empty())
+                {
+                    throw std::runtime_error("Setter must not define return values");
+                }
+            }
+
+            bool is_final = false;
+            jobject field = resolve_field(env, cls, field_name, ctx->instance_required, &is_final);
+
+            // typed Get<Type>Field/Set<Type>Field access; final fields are written through
+            // reflection so Field.set keeps rejecting them
+            jni_ret_type actual_type = resolve_field_type(env, field);
+            jni_ret_type declared_type = is_getter ? get_ret_type(ctx->retvals_types) : jni_kind_from_type_info(ctx->params_types.back());
+            bool direct_type_ok = is_getter ? can_call_direct(actual_type, declared_type) : (actual_type == declared_type || actual_type == jni_ret_type::object_type);
+            jfieldID field_id = env->FromReflectedField(field);
+            if(field_id && direct_type_ok && !(is_setter && is_final))
+            {
+                // Set<Object>Field stores anything; values are checked against the field type as Field.set does
+                if(is_setter && actual_type == jni_ret_type::object_type)
+                {
+                    const auto& sym = get_jni_symbols();
+                    jclass field_type_cls = (jclass)env->CallObjectMethod(field, sym.field_get_type);
+                    if(env->ExceptionCheck() || !field_type_cls)
+                    {
+                        env->ExceptionClear();
+                        env->DeleteLocalRef(field);
+                        throw std::runtime_error("Failed to get type of field " + field_name);
+                    }
+                    if(env->IsSameObject(field_type_cls, sym.object_cls) == JNI_FALSE)
+                    {
+                        ctx->arg_classes.assign(ctx->params_types.size(), nullptr);
+                        ctx->arg_classes.back() = (jclass)env->NewGlobalRef(field_type_cls);
+                        ctx->checks_arguments = ctx->arg_classes.back() != nullptr;
+                    }
+                    env->DeleteLocalRef(field_type_cls);
+                }
+
+                jclass global_cls = (jclass)env->NewGlobalRef(cls);
+                if(!global_cls)
+                {
+                    env->DeleteLocalRef(field);
+                    throw std::runtime_error("Failed to create global reference for declaring class");
+                }
+
+                ctx->use_direct_field = true;
+                ctx->field_type = actual_type;
+                plan_ret_kind = is_getter ? actual_type : jni_ret_type::void_type;
+                ctx->field_id = field_id;
+                ctx->direct_ctx.cls = global_cls;
+                ctx->direct_ctx.instance_required = ctx->instance_required;
+            }
+            else
+            {
+                trace("jvm_runtime: reflection fallback for field " + class_name + "." + field_name);
+            }
+
+            ctx->member = env->NewGlobalRef(field);
+            env->DeleteLocalRef(field);
+            if(!ctx->member)
+            {
+                throw std::runtime_error("Failed to create global reference for field");
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Entity path must contain callable or field");
+        }
+
+        build_call_plan(*ctx, plan_ret_kind, ctx->instance_required);
+
+        own_type_aliases(*ctx);
+        xcall* pxcall = new xcall(select_xcall_func(*ctx), ctx.get());
+        publish_cached_entity(cache_key, *ctx);
+        ctx.release();
+        return pxcall;
+    }
+    catch(const std::exception& e)
+    {
+        set_error(err, e.what());
+        if(ctx)
+        {
+            release_entity_refs(env, *ctx);
+        }
+        return nullptr;
+    }
+}
+
+xcall* load_entity(const char* module_path, const char* entity_path, metaffi_type_info* params_types, int8_t params_count, metaffi_type_info* retvals_types, int8_t retval_count, char** err)
 {
-    jvmxcall(ctx, &parameters[0], nullptr, out_err);
+    clear_error(err);
+
+    if(const char* invalid = check_entity_args(entity_path, params_types, params_count, retvals_types, retval_count))
+    {
+        set_error(err, invalid);
+        return nullptr;
+    }
+
+    // keeps free_runtime() from tearing the runtime down under the resolution
+    std::optional<runtime_call_scope> runtime_scope;
+    if(!enter_loaded_runtime(runtime_scope, err))
+    {
+        return nullptr;
+    }
+
+    std::string cache_key = entity_cache_key(module_path, entity_path, params_types, params_count, retvals_types, retval_count);
+    if(xcall* shared = share_cached_entity(cache_key))
+    {
+        return shared;
+    }
+
+    try
+    {
+        scoped_env env_scope;
+        JNIEnv* env = env_scope.get();
+
+        // the local refs of the resolution go with the frame, as in run_bulk_load()
+        local_frame frame(env, 64);
+        std::string module = module_path ? module_path : "";
+        jni_class_loader loader(env, module);
+        note_class_path(module); // once the loader sees the module, so no stale miss outlives it
+        return resolve_entity(env, loader, module_path, entity_path, params_types, params_count, retvals_types, retval_count, cache_key, err);
+    }
+    catch(const std::exception& e)
+    {
+        set_error(err, e.what());
+        return nullptr;
+    }
 }
 
-static void jvmxcall_no_params_ret(entity_context* ctx, cdts return_values[1], char** out_err)
+xcall* make_callable(void* make_callable_context, metaffi_type_info* params_types, int8_t params_count, metaffi_type_info* retvals_types, int8_t retval_count, char** err)
 {
-    jvmxcall(ctx, nullptr, &return_values[0], out_err);
+    clear_error(err);
+
+    if(!make_callable_context)
+    {
+        set_error(err, "make_callable context is null");
+        return nullptr;
+    }
+
+    if(params_count > 0 && !params_types)
+    {
+        set_error(err, "Parameter types are missing");
+        return nullptr;
+    }
+
+    if(retval_count > 0 && !retvals_types)
+    {
+        set_error(err, "Return types are missing");
+        return nullptr;
+    }
+
+    // keeps free_runtime() from tearing the runtime down under the resolution
+    std::optional<runtime_call_scope> runtime_scope;
+    if(!enter_loaded_runtime(runtime_scope, err))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<entity_context> ctx;
+    std::optional<scoped_env> env_scope;
+    try
+    {
+        ctx = std::make_unique<entity_context>();
+        if(params_types && params_count > 0)
+        {
+            ctx->params_types.assign(params_types, params_types + params_count);
+        }
+        if(retvals_types && retval_count > 0)
+        {
+            ctx->retvals_types.assign(retvals_types, retvals_types + retval_count);
+        }
+
+        std::unique_ptr<jvm_context> pctxt(static_cast<jvm_context*>(make_callable_context));
+        if(!pctxt || !pctxt->method)
+        {
+            throw std::runtime_error("Method ID is null");
+        }
+
+        env_scope.emplace();
+        JNIEnv* env = env_scope->get();
+
+        ctx->use_direct_call = true;
+        ctx->direct_ctx = *pctxt;
+        if(!ctx->direct_ctx.cls)
+        {
+            throw std::runtime_error("Declaring class is null");
+        }
+        size_t param_offset = ctx->direct_ctx.instance_required ? 1 : 0;
+        if(ctx->params_types.size() < param_offset)
+        {
+            throw std::runtime_error("Instance parameter is missing");
+        }
+
+        // until the global ref is taken the class is the caller's, not ours to release
+        jclass declaring_cls = ctx->direct_ctx.cls;
+        ctx->direct_ctx.cls = nullptr;
+        jclass global_cls = (jclass)env->NewGlobalRef(declaring_cls);
+        if(!global_cls)
+        {
+            throw std::runtime_error("Failed to create global reference for declaring class");
+        }
+        ctx->direct_ctx.cls = global_cls;
+        build_call_plan(*ctx, ctx->direct_ctx.constructor ? jni_ret_type::object_type : get_ret_type(ctx->retvals_types), ctx->direct_ctx.instance_required);
+
+        xcall* pxcall = new xcall(select_xcall_func(*ctx), ctx.get());
+        ctx.release();
+        return pxcall;
+    }
+    catch(const std::exception& e)
+    {
+        set_error(err, e.what());
+        if(ctx && env_scope)
+        {
+            release_entity_refs(env_scope->get(), *ctx);
+        }
+        return nullptr;
+    }
 }
 
-static void jvmxcall_no_params_no_ret(entity_context* ctx, char** out_err)
+void free_xcall(xcall* pxcall, char** err)
 {
-    jvmxcall(ctx, nullptr, nullptr, out_err);
+    clear_error(err);
+    if(!pxcall)
+    {
+        return;
+    }
+
+    entity_context* ctx = static_cast<entity_context*>(pxcall->pxcall_and_context[1]);
+    if(ctx && release_entity(*ctx))
+    {
+        free_entity(ctx, err);
+    }
+
+    delete pxcall;
 }
 
-// IMPORTANT: the name of the function must be different from xcall_* to avoid symbol conflicts.
-static void jvm_api_xcall_params_ret(void* context, cdts params_ret[2], char** out_err)
+bool jvm_runtime_get_counter(const char* name, uint64_t* out_value)
 {
-    auto* ctx = static_cast<entity_context*>(context);
-    jvmxcall_params_ret(ctx, params_ret, out_err);
+    if(!name || !out_value)
+    {
+        return false;
+    }
+
+    std::string counter(name);
+    if(counter == "thread_attaches")
+    {
+        *out_value = get_thread_env_attach_count();
+        return true;
+    }
+    if(counter == "thread_detaches")
+    {
+        *out_value = get_thread_env_detach_count();
+        return true;
+    }
+    if(counter == "array_class_cache_hits")
+    {
+        *out_value = get_array_class_cache_hit_count();
+        return true;
+    }
+    if(counter == "array_class_cache_misses")
+    {
+        *out_value = get_array_class_cache_miss_count();
+        return true;
+    }
+    if(counter == "critical_array_copies")
+    {
+        *out_value = get_critical_array_count();
+        return true;
+    }
+    if(counter == "bulk_string_arrays")
+    {
+        *out_value = get_bulk_string_array_count();
+        return true;
+    }
+    if(counter == "string_param_cache_hits")
+    {
+        *out_value = get_string_param_cache_hit_count();
+        return true;
+    }
+    if(counter == "string_param_cache_misses")
+    {
+        *out_value = get_string_param_cache_miss_count();
+        return true;
+    }
+    if(counter == "string_result_cache_hits")
+    {
+        *out_value = get_string_result_cache_hit_count();
+        return true;
+    }
+    if(counter == "string_result_cache_misses")
+    {
+        *out_value = get_string_result_cache_miss_count();
+        return true;
+    }
+    if(counter == "async_calls")
+    {
+        *out_value = g_async_calls.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "async_calls_rejected")
+    {
+        *out_value = g_async_rejected.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "actor_calls")
+    {
+        *out_value = g_actor_calls.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "calls_timed_out")
+    {
+        *out_value = g_calls_timed_out.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "calls_cancelled")
+    {
+        *out_value = g_calls_cancelled.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "futures_bridged")
+    {
+        *out_value = get_bridged_future_count();
+        return true;
+    }
+    if(counter == "futures_completed")
+    {
+        *out_value = get_completed_future_count();
+        return true;
+    }
+    if(counter == "entity_cache_hits")
+    {
+        *out_value = g_entity_cache_hits.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "entity_cache_misses")
+    {
+        *out_value = g_entity_cache_misses.load(std::memory_order_relaxed);
+        return true;
+    }
+    if(counter == "class_cache_hits")
+    {
+        *out_value = get_class_cache_hit_count();
+        return true;
+    }
+    if(counter == "class_cache_negative_hits")
+    {
+        *out_value = get_class_cache_negative_hit_count();
+        return true;
+    }
+    if(counter == "class_cache_misses")
+    {
+        *out_value = get_class_cache_miss_count();
+        return true;
+    }
+
+    return false;
 }
 
-static void jvm_api_xcall_params_no_ret(void* context, cdts parameters[1], char** out_err)
+bool jvm_runtime_set_option(const char* name, uint64_t value)
 {
-    auto* ctx = static_cast<entity_context*>(context);
-    jvmxcall_params_no_ret(ctx, parameters, out_err);
+    if(!name)
+    {
+        return false;
+    }
+
+    std::string option(name);
+    if(option == "critical_array_threshold")
+    {
+        set_critical_array_threshold(static_cast<size_t>(value));
+        return true;
+    }
+    if(option == "string_cache_capacity")
+    {
+        set_string_cache_capacity(static_cast<size_t>(value));
+        return true;
+    }
+    if(option == "async_workers")
+    {
+        g_async_workers.store(static_cast<size_t>(value), std::memory_order_relaxed);
+        return true;
+    }
+    if(option == "load_workers")
+    {
+        g_load_workers.store(static_cast<size_t>(value), std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
 }
 
-static void jvm_api_xcall_no_params_ret(void* context, cdts return_values[1], char** out_err)
+void jvm_runtime_xcall_batch(xcall* pxcall, cdts* params, cdts* results, uint64_t rows, char** out_err)
 {
-    auto* ctx = static_cast<entity_context*>(context);
-    jvmxcall_no_params_ret(ctx, return_values, out_err);
+    if(!pxcall)
+    {
+        clear_error(out_err);
+        set_error(out_err, "xcall is null");
+        return;
+    }
+
+    jvmxcall_batch(static_cast<entity_context*>(pxcall->pxcall_and_context[1]), params, results, rows, out_err);
 }
 
-static void jvm_api_xcall_no_params_no_ret(void* context, char** out_err)
+bool jvm_runtime_xcall_async(xcall* pxcall, cdts* params, cdts* ret, jvm_xcall_completion on_complete, void* user_data, char** out_err)
 {
-    auto* ctx = static_cast<entity_context*>(context);
-    jvmxcall_no_params_no_ret(ctx, out_err);
+    clear_error(out_err);
+    if(!pxcall || !on_complete)
+    {
+        set_error(out_err, "xcall and completion callback are required");
+        return false;
+    }
+
+    // keeps free_runtime() from tearing the runtime down under this call
+    runtime_call_scope runtime_scope;
+    if(!runtime_scope)
+    {
+        set_error(out_err, "JVM runtime is not loaded");
+        return false;
+    }
+
+    auto* ctx = static_cast<entity_context*>(pxcall->pxcall_and_context[1]);
+    if(!ctx)
+    {
+        set_error(out_err, "Context is null");
+        return false;
+    }
+
+    // the queued call keeps the context alive should the host free the xcall before it runs
+    retain_entity(*ctx);
+    try
+    {
+        auto call = std::make_unique<async_call>(async_call{ctx, params, ret, on_complete, user_data});
+        if(!get_worker_pool()->submit(run_async_call, call.get()))
+        {
+            g_async_rejected.fetch_add(1, std::memory_order_relaxed);
+            set_error(out_err, "Asynchronous call queue is full");
+            drop_entity(ctx);
+            return false;
+        }
+        call.release();
+        g_async_calls.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+        set_error(out_err, e.what());
+        drop_entity(ctx);
+        return false;
+    }
 }
 
-xcall* load_entity(const char* module_path, const char* entity_path, metaffi_type_info* params_types, int8_t params_count, metaffi_type_info* retvals_types, int8_t retval_count, char** err)
-{
-    clear_error(err);
+bool jvm_runtime_xcall_future(xcall* pxcall, cdts* params, cdts* ret, jvm_xcall_completion on_complete, void* user_data, char** out_err)
+{
+    clear_error(out_err);
+    if(!pxcall || !on_complete)
+    {
+        set_error(out_err, "xcall and completion callback are required");
+        return false;
+    }
+
+    // keeps free_runtime() from tearing the runtime down under this call
+    runtime_call_scope runtime_scope;
+    if(!runtime_scope)
+    {
+        set_error(out_err, "JVM runtime is not loaded");
+        return false;
+    }
 
-    if(!entity_path || !*entity_path)
+    auto* ctx = static_cast<entity_context*>(pxcall->pxcall_and_context[1]);
+    if(!ctx || !ctx->returns_future)
     {
-        set_error(err, "Entity path is empty");
-        return nullptr;
+        set_error(out_err, "Entity does not return a Java future (return alias must be java.util.concurrent.CompletableFuture or CompletionStage)");
+        return false;
     }
 
-    if(params_count > 0 && !params_types)
+    // the reflection fallback stores its result immediately instead of handing back the stage
+    if(!ctx->use_direct_call)
     {
-        set_error(err, "Parameter types are missing");
-        return nullptr;
+        set_error(out_err, "Future-returning entities must be invoked directly");
+        return false;
     }
 
-    if(retval_count > 0 && !retvals_types)
+    if(!params && !ctx->params_types.empty())
     {
-        set_error(err, "Return types are missing");
-        return nullptr;
+        set_error(out_err, "Parameters are required but missing");
+        return false;
     }
 
-    if(!g_runtime_manager || !g_runtime_manager->is_runtime_loaded())
+    if(!ret)
     {
-        load_runtime(err);
-        if(err && *err)
-        {
-            return nullptr;
-        }
+        set_error(out_err, "Return values are required but missing");
+        return false;
     }
 
-    try
+    bool bridged = false;
+    auto call = [&]()
     {
-        auto ctx = std::make_unique<entity_context>();
-        if(params_types && params_count > 0)
+        try
         {
-            ctx->params_types.assign(params_types, params_types + params_count);
+            scoped_env env_scope;
+            JNIEnv* env = env_scope.get();
+            local_frame frame(env, ctx->plan.local_capacity + 1);
+
+            std::optional<call_serializer> params_ser;
+            if(params)
+            {
+                params_ser.emplace(env, *params, jni_class_loader::get_child_class_loader());
+            }
+
+            jvalue stage = invoke_direct_member(ctx, env, params_ser ? &*params_ser : nullptr);
+            // completed by complete_future from here on, which may already run inside
+            // whenComplete; the pending future keeps the context alive until then
+            retain_entity(*ctx);
+            uint64_t token = add_pending_future(std::make_unique<pending_future>(pending_future{ctx, ret, on_complete, user_data}));
+            try
+            {
+                bridge_completion_stage(env, stage.l, reinterpret_cast<void*>(static_cast<uintptr_t>(token)));
+            }
+            catch(...)
+            {
+                if(take_pending_future(token))
+                {
+                    drop_entity(ctx);
+                }
+                throw;
+            }
+            bridged = true;
         }
-        if(retvals_types && retval_count > 0)
+        catch(const std::exception& e)
         {
-            ctx->retvals_types.assign(retvals_types, retvals_types + retval_count);
+            set_error(out_err, e.what());
         }
+    };
 
-        metaffi::utils::entity_path_parser fp(entity_path);
-        if(!fp.contains("class"))
+    // an actor entity makes the call on its thread; the stage may complete anywhere
+    if(ctx->actor)
+    {
+        jvm_worker_pool* actor = actor_thread(*ctx->actor);
+        if(!actor)
         {
-            set_error(err, "Entity path must include class");
-            return nullptr;
+            set_error(out_err, actor_stopped_error);
+            return false;
         }
+        if(!run_on_actor(*actor, call, deadline_after(ctx->timeout_ms)))
+        {
+            g_calls_timed_out.fetch_add(1, std::memory_order_relaxed);
+            set_error(out_err, actor_deadline_error);
+            return false;
+        }
+    }
+    else
+    {
+        call();
+    }
+    return bridged;
+}
 
-        ctx->instance_required = fp.contains("instance_required");
-
-        JNIEnv* env = nullptr;
-        auto release_env = g_runtime_manager->get_env(&env);
-        metaffi::utils::scope_guard env_guard([&](){ release_env(); });
+void jvm_runtime_xcall_timeout(xcall* pxcall, cdts* params, cdts* ret, uint64_t timeout_ms, char** out_err)
+{
+    if(!pxcall)
+    {
+        clear_error(out_err);
+        set_error(out_err, "xcall is null");
+        return;
+    }
 
-        std::string module = module_path ? module_path : "";
-        jni_class_loader loader(env, module);
-        std::string class_name = fp["class"];
-        jclass cls = load_class_with_fallback(loader, class_name);
+    auto* ctx = static_cast<entity_context*>(pxcall->pxcall_and_context[1]);
+    jvmxcall_until(ctx, params, ret, deadline_after(timeout_ms ? timeout_ms : (ctx ? ctx->timeout_ms : 0)), out_err);
+}
 
-        if(fp.contains("callable"))
-        {
-            std::string callable = fp["callable"];
-            ctx->is_callable = true;
-            ctx->is_constructor = (callable == "<init>");
+uint64_t jvm_runtime_cancel_calls(xcall* pxcall)
+{
+    runtime_call_scope runtime_scope;
+    jvm_call_watchdog* watchdog = g_watchdog.load(std::memory_order_acquire);
+    if(!pxcall || !watchdog || !runtime_scope)
+    {
+        return 0;
+    }
 
-            if(ctx->is_constructor && ctx->instance_required)
-            {
-                throw std::runtime_error("Constructor cannot require instance");
-            }
-            if(ctx->is_constructor && ctx->retvals_types.size() != 1)
-            {
-                throw std::runtime_error("Constructor must return exactly one value");
-            }
+    try
+    {
+        scoped_env env_scope;
+        return watchdog->cancel(env_scope.get(), pxcall->pxcall_and_context[1]);
+    }
+    catch(const std::exception&)
+    {
+        return 0;
+    }
+}
 
-            size_t param_offset = ctx->instance_required ? 1 : 0;
-            if(ctx->params_types.size() < param_offset)
-            {
-                throw std::runtime_error("Instance parameter is missing");
-            }
+namespace
+{
+    // Shared by the caller and its helpers: a helper that starts after the caller returned
+    // finds nothing to claim, but still holds the state. Only claimed entries touch the
+    // caller's arrays, and the caller waits for those.
+    struct bulk_load
+    {
+        std::string module_path;
+        const jvm_entity_descriptor* entities = nullptr;
+        uint64_t count = 0;
+        xcall** out_xcalls = nullptr;
+        char** out_errors = nullptr;
+        std::atomic<uint64_t> next{0}; // next entry to claim
+        std::atomic<uint64_t> finished{0}; // claimed entries done with; the caller waits on it
+        std::atomic<uint64_t> loaded{0};
+        std::mutex mutex; // guards thread_error and the construction of class loaders
+        std::string thread_error; // why a thread could not take part, if one could not
+    };
 
-            std::vector<jclass> param_classes;
-            for(size_t i = param_offset; i < ctx->params_types.size(); i++)
-            {
-                param_classes.push_back(resolve_jclass(env, ctx->params_types[i], &loader));
-            }
+    // Claims entries until none are left, with the thread's env and its own class loader.
+    void run_bulk_load(bulk_load& load)
+    {
+        if(load.next.load(std::memory_order_relaxed) >= load.count)
+        {
+            return; // the others got through the entries before this thread started
+        }
 
-            jobject member = nullptr;
-            if(ctx->is_constructor)
-            {
-                member = resolve_constructor(env, cls, param_classes);
-            }
-            else
+        try
+        {
+            // a helper that starts once free_runtime() is under way leaves the entries to the caller
+            runtime_call_scope runtime_scope;
+            if(!runtime_scope)
             {
-                member = resolve_method(env, cls, callable, param_classes, ctx->instance_required);
+                return;
             }
+            scoped_env env_scope;
+            JNIEnv* env = env_scope.get();
 
-            for(jclass pc : param_classes)
+            std::optional<jni_class_loader> loader;
             {
-                delete_local_ref_if_needed(env, pc);
+                std::lock_guard<std::mutex> lock(load.mutex);
+                loader.emplace(env, load.module_path);
             }
+            note_class_path(load.module_path);
 
-            ctx->member = env->NewGlobalRef(member);
-            env->DeleteLocalRef(member);
-            if(!ctx->member)
-            {
-                throw std::runtime_error("Failed to create global reference for method");
-            }
-        }
-        else if(fp.contains("field"))
-        {
-            std::string field_name = fp["field"];
-            bool is_getter = fp.contains("getter");
-            bool is_setter = fp.contains("setter");
-            if(is_getter == is_setter)
+            const char* module_path = load.module_path.c_str();
+            for(uint64_t i = load.next.fetch_add(1, std::memory_order_relaxed); i < load.count; i = load.next.fetch_add(1, std::memory_order_relaxed))
             {
-                throw std::runtime_error("Field entity must be getter or setter");
-            }
-            ctx->is_getter = is_getter;
-            ctx->is_setter = is_setter;
+                const jvm_entity_descriptor& entry = load.entities[i];
+                char** entry_err = &load.out_errors[i];
+                xcall* pxcall = nullptr;
 
-            if(is_getter)
-            {
-                size_t expected_params = ctx->instance_required ? 1 : 0;
-                if(ctx->params_types.size() != expected_params)
-                {
-                    throw std::runtime_error("Getter parameter count mismatch");
-                }
-                if(ctx->retvals_types.empty())
+                if(const char* invalid = check_entity_args(entry.entity_path, entry.params_types, entry.params_count, entry.retvals_types, entry.retval_count))
                 {
-                    throw std::runtime_error("Getter requires a return value");
+                    set_error(entry_err, invalid);
                 }
-            }
-            else
-            {
-                size_t expected_params = ctx->instance_required ? 2 : 1;
-                if(ctx->params_types.size() != expected_params)
+                else
                 {
-                    throw std::runtime_error("Setter parameter count mismatch");
+                    try
+                    {
+                        std::string key = entity_cache_key(module_path, entry.entity_path, entry.params_types, entry.params_count, entry.retvals_types, entry.retval_count);
+                        pxcall = share_cached_entity(key);
+                        if(!pxcall)
+                        {
+                            // the local refs of one resolution go with it, not with the thread
+                            local_frame frame(env, 64);
+                            pxcall = resolve_entity(env, *loader, module_path, entry.entity_path,
+                                                    entry.params_types, entry.params_count, entry.retvals_types, entry.retval_count, key, entry_err);
+                        }
+                    }
+                    catch(const std::exception& e)
+                    {
+                        set_error(entry_err, e.what());
+                    }
                 }
-                if(!ctx->retvals_types.empty())
+
+                load.out_xcalls[i] = pxcall;
+                if(pxcall)
                 {
-                    throw std::runtime_error("Setter must not define return values");
+                    load.loaded.fetch_add(1, std::memory_order_relaxed);
                 }
-            }
-
-            jobject field = resolve_field(env, cls, field_name, ctx->instance_required);
-            ctx->member = env->NewGlobalRef(field);
-            env->DeleteLocalRef(field);
-            if(!ctx->member)
-            {
-                throw std::runtime_error("Failed to create global reference for field");
+                load.finished.fetch_add(1, std::memory_order_release);
+                load.finished.notify_all();
             }
         }
-        else
+        catch(const std::exception& e)
         {
-            throw std::runtime_error("Entity path must contain callable or field");
+            // the entries this thread did not claim are left to the others
+            std::lock_guard<std::mutex> lock(load.mutex);
+            load.thread_error = e.what();
         }
-
-        delete_local_ref_if_needed(env, cls);
-
-        void* xcall_func = ctx->params_types.empty() && ctx->retvals_types.empty() ? (void*)jvm_api_xcall_no_params_no_ret
-                             : ctx->params_types.empty() ? (void*)jvm_api_xcall_no_params_ret
-                             : ctx->retvals_types.empty() ? (void*)jvm_api_xcall_params_no_ret
-                             : (void*)jvm_api_xcall_params_ret;
-
-        xcall* pxcall = new xcall(xcall_func, ctx.release());
-        return pxcall;
     }
-    catch(const std::exception& e)
+
+    void run_bulk_load_helper(void* state)
     {
-        set_error(err, e.what());
-        return nullptr;
+        std::unique_ptr<std::shared_ptr<bulk_load>> load(static_cast<std::shared_ptr<bulk_load>*>(state));
+        run_bulk_load(**load);
     }
 }
 
-xcall* make_callable(void* make_callable_context, metaffi_type_info* params_types, int8_t params_count, metaffi_type_info* retvals_types, int8_t retval_count, char** err)
+uint64_t jvm_runtime_load_entities(const char* module_path, const jvm_entity_descriptor* entities, uint64_t count, xcall** out_xcalls, char** out_errors, char** err)
 {
     clear_error(err);
-
-    if(!make_callable_context)
+    if(count == 0)
     {
-        set_error(err, "make_callable context is null");
-        return nullptr;
+        return 0;
     }
-
-    if(params_count > 0 && !params_types)
+    if(!entities || !out_xcalls || !out_errors)
     {
-        set_error(err, "Parameter types are missing");
-        return nullptr;
+        set_error(err, "Entity descriptors and result arrays are required");
+        return 0;
     }
 
-    if(retval_count > 0 && !retvals_types)
+    std::fill(out_xcalls, out_xcalls + count, nullptr);
+    std::fill(out_errors, out_errors + count, nullptr);
+
+    // keeps free_runtime() from tearing the runtime down under the load and its helpers
+    std::optional<runtime_call_scope> runtime_scope;
+    if(!enter_loaded_runtime(runtime_scope, err))
     {
-        set_error(err, "Return types are missing");
-        return nullptr;
+        return 0;
     }
 
-    if(!g_runtime_manager || !g_runtime_manager->is_runtime_loaded())
+    auto load = std::make_shared<bulk_load>();
+    load->module_path = module_path ? module_path : "";
+    load->entities = entities;
+    load->count = count;
+    load->out_xcalls = out_xcalls;
+    load->out_errors = out_errors;
+
+    size_t threads = g_load_workers.load(std::memory_order_relaxed);
+    if(threads == 0)
     {
-        load_runtime(err);
-        if(err && *err)
-        {
-            return nullptr;
-        }
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
     }
+    threads = static_cast<size_t>(std::min<uint64_t>(threads, (count + min_entities_per_load_worker - 1) / min_entities_per_load_worker));
 
     try
     {
-        auto ctx = std::make_unique<entity_context>();
-        if(params_types && params_count > 0)
-        {
-            ctx->params_types.assign(params_types, params_types + params_count);
-        }
-        if(retvals_types && retval_count > 0)
-        {
-            ctx->retvals_types.assign(retvals_types, retvals_types + retval_count);
-        }
-
-        std::unique_ptr<jvm_context> pctxt(static_cast<jvm_context*>(make_callable_context));
-        if(!pctxt || !pctxt->method)
-        {
-            throw std::runtime_error("Method ID is null");
-        }
-
-        JNIEnv* env = nullptr;
-        auto release_env = g_runtime_manager->get_env(&env);
-        metaffi::utils::scope_guard env_guard([&](){ release_env(); });
-
-        ctx->use_direct_call = true;
-        ctx->direct_ctx = *pctxt;
-        if(!ctx->direct_ctx.cls)
-        {
-            throw std::runtime_error("Declaring class is null");
-        }
-        size_t param_offset = ctx->direct_ctx.instance_required ? 1 : 0;
-        if(ctx->params_types.size() < param_offset)
-        {
-            throw std::runtime_error("Instance parameter is missing");
-        }
-
-        jclass global_cls = (jclass)env->NewGlobalRef(ctx->direct_ctx.cls);
-        if(!global_cls)
+        // the helpers come from the load pool, already attached; the caller is one of the threads
+        if(threads > 1)
         {
-            throw std::runtime_error("Failed to create global reference for declaring class");
+            jvm_worker_pool* helpers = get_load_pool();
+            threads = std::min(threads, helpers->worker_count() + 1);
+            for(size_t i = 1; i < threads; i++)
+            {
+                auto state = std::make_unique<std::shared_ptr<bulk_load>>(load);
+                if(!helpers->submit(run_bulk_load_helper, state.get()))
+                {
+                    break; // the caller and the helpers already queued share the entries
+                }
+                state.release();
+            }
         }
-        ctx->direct_ctx.cls = global_cls;
-
-        void* xcall_func = ctx->params_types.empty() && ctx->retvals_types.empty() ? (void*)jvm_api_xcall_no_params_no_ret
-                             : ctx->params_types.empty() ? (void*)jvm_api_xcall_no_params_ret
-                             : ctx->retvals_types.empty() ? (void*)jvm_api_xcall_params_no_ret
-                             : (void*)jvm_api_xcall_params_ret;
-
-        xcall* pxcall = new xcall(xcall_func, ctx.release());
-        return pxcall;
+        run_bulk_load(*load);
     }
     catch(const std::exception& e)
     {
-        set_error(err, e.what());
-        return nullptr;
+        std::lock_guard<std::mutex> lock(load->mutex);
+        load->thread_error = e.what();
     }
-}
 
-void free_xcall(xcall* pxcall, char** err)
-{
-    clear_error(err);
-    if(!pxcall)
+    // closes the claims, then waits for the entries the helpers are still resolving
+    uint64_t claimed = std::min(load->next.exchange(count, std::memory_order_acq_rel), count);
+    for(uint64_t finished = load->finished.load(std::memory_order_acquire); finished < claimed; finished = load->finished.load(std::memory_order_acquire))
     {
-        return;
+        load->finished.wait(finished, std::memory_order_acquire);
     }
 
-    entity_context* ctx = static_cast<entity_context*>(pxcall->pxcall_and_context[1]);
-    if(ctx)
+    // entries no thread got to
+    if(claimed < count)
     {
-        if(g_runtime_manager && g_runtime_manager->is_runtime_loaded())
+        std::string thread_error;
         {
-            JNIEnv* env = nullptr;
-            auto release_env = g_runtime_manager->get_env(&env);
-            metaffi::utils::scope_guard env_guard([&](){ release_env(); });
-
-            if(ctx->member)
-            {
-                env->DeleteGlobalRef(ctx->member);
-                ctx->member = nullptr;
-            }
-            if(ctx->direct_ctx.cls)
-            {
-                env->DeleteGlobalRef(ctx->direct_ctx.cls);
-                ctx->direct_ctx.cls = nullptr;
-            }
+            std::lock_guard<std::mutex> lock(load->mutex);
+            thread_error = load->thread_error;
+        }
+        for(uint64_t i = claimed; i < count; i++)
+        {
+            set_error(&out_errors[i], "Entity was not loaded: " + thread_error);
         }
-
-        delete ctx;
     }
 
-    delete pxcall;
+    return load->loaded.load(std::memory_order_relaxed);
 }
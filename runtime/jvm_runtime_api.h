@@ -0,0 +1,137 @@
+#pragma once
+
+// Entry points exported by the JVM runtime plugin in addition to runtime_plugin_api.h.
+
+#include <cstdint>
+
+struct cdts;
+struct xcall;
+struct metaffi_type_info;
+
+#ifdef _WIN32
+#define JVM_RUNTIME_API extern "C" __declspec(dllexport)
+#else
+#define JVM_RUNTIME_API extern "C" __attribute__((visibility("default")))
+#endif
+
+// Reads a runtime counter by name into out_value. Returns false for an unknown name.
+//
+// Counters:
+//   thread_attaches            - host threads attached to the JVM by the persistent attachment
+//   thread_detaches            - of those, threads detached at thread exit
+//   array_class_cache_hits     - array returns whose dimensions came from the class cache
+//   array_class_cache_misses   - array classes resolved through reflection
+//   critical_array_copies      - arrays marshalled in bulk through GetPrimitiveArrayCritical
+//   bulk_string_arrays         - String[] values marshalled in one crossing by the StringArrays helper
+//   string_param_cache_hits    - string8 parameters served from the string cache
+//   string_param_cache_misses  - cacheable string8 parameters that created a new Java string
+//   string_result_cache_hits   - string8 results copied from the string cache
+//   string_result_cache_misses - cacheable string8 results read from the Java string
+//   async_calls                - calls queued by jvm_runtime_xcall_async
+//   async_calls_rejected       - asynchronous calls refused because the queue was full
+//   actor_calls                - calls handed to the dedicated thread of a module's "actor" entities
+//   calls_timed_out            - watched calls that missed their deadline
+//   calls_cancelled            - watched calls interrupted by jvm_runtime_cancel_calls
+//   futures_bridged            - Java futures given a continuation by jvm_runtime_xcall_future
+//   futures_completed          - of those, futures that have completed
+//   entity_cache_hits          - load_entity calls served by an already resolved entity
+//   entity_cache_misses        - load_entity calls that resolved the entity
+//   class_cache_hits           - class name candidates served by the class cache
+//   class_cache_negative_hits  - class name candidates skipped as known to be missing
+//   class_cache_misses         - class name candidates loaded through the JVM
+JVM_RUNTIME_API bool jvm_runtime_get_counter(const char* name, uint64_t* out_value);
+
+// Sets a runtime option by name. Returns false for an unknown name.
+//
+// Options:
+//   critical_array_threshold - minimum byte size of a 1-D primitive array marshalled through
+//                              GetPrimitiveArrayCritical; 0 disables the bulk path. Defaults
+//                              to METAFFI_JVM_CRITICAL_ARRAY_THRESHOLD, or 0 if unset.
+//   string_cache_capacity    - entries per direction of the string8 parameter/result cache;
+//                              0 disables it. Defaults to METAFFI_JVM_STRING_CACHE_CAPACITY,
+//                              or 0 if unset.
+//   async_workers            - worker threads of the asynchronous call pool; 0 means one per
+//                              hardware thread (at least 2). Takes effect when the pool starts
+//                              (first asynchronous call after load_runtime). Defaults to
+//                              METAFFI_JVM_ASYNC_WORKERS, or 0 if unset.
+//   load_workers             - threads resolving a jvm_runtime_load_entities call, the caller
+//                              included; 0 means one per hardware thread. The helper pool is
+//                              sized when it starts (first parallel load after load_runtime).
+//                              Defaults to METAFFI_JVM_LOAD_WORKERS, or 0 if unset.
+JVM_RUNTIME_API bool jvm_runtime_set_option(const char* name, uint64_t value);
+
+// Invokes the entity behind pxcall (as returned by load_entity) once per row of a columnar
+// batch, in one loop on the calling thread: the JNI environment, serializers and local
+// frames are set up once per batch instead of once per call.
+//
+// params holds one cdt per parameter, each a 1-D array of `rows` values of that parameter's
+// type; it may be null for entities without parameters. For an entity with a return value,
+// results must hold one cdt, which is filled with an array of `rows` return values.
+// Supports methods and constructors invoked directly, with at most one return value.
+// On error out_err is set (naming the failing row); rows before it have already run.
+JVM_RUNTIME_API void jvm_runtime_xcall_batch(xcall* pxcall, cdts* params, cdts* results, uint64_t rows, char** out_err);
+
+// Completion callback of jvm_runtime_xcall_async (called on a worker thread) and of
+// jvm_runtime_xcall_future. err is null on success; otherwise it is the error message, which the callback owns and releases with
+// xllr_free_string.
+typedef void (*jvm_xcall_completion)(void* user_data, char* err);
+
+// Queues a call of the entity behind pxcall on a pool of JVM-attached worker threads and
+// returns without waiting. params and ret follow the layout of the synchronous xcall (either
+// may be null when the entity has none) and, like pxcall, must stay alive until on_complete
+// runs. Futures or coroutine awaitables can be built on the callback by the host.
+// Returns false and sets out_err if the call was not queued (runtime not loaded, queue full).
+JVM_RUNTIME_API bool jvm_runtime_xcall_async(xcall* pxcall, cdts* params, cdts* ret, jvm_xcall_completion on_complete, void* user_data, char** out_err);
+
+// Calls a future-returning entity without waiting for its result. An entity is
+// future-returning when its single return value carries the type alias
+// java.util.concurrent.CompletableFuture or java.util.concurrent.CompletionStage; the
+// metaffi type of that return value is the type of the completed value.
+//
+// The Java method runs on the calling thread. A continuation is registered on the returned
+// stage and on_complete runs, on the Java thread that completes the stage, once ret holds
+// the completed value (err is null) or the stage failed (err describes the cause). If the
+// stage is already complete, on_complete runs before this function returns. No thread is
+// blocked on Future.get(). params is only read during the call; ret and pxcall must stay
+// alive until on_complete runs, and the runtime must not be freed while calls are pending.
+// Returns false and sets out_err, without calling on_complete, if the method failed or did
+// not return a stage. The synchronous xcall of such an entity fails unless its return value
+// is declared as a handle, in which case it returns the stage itself as before.
+JVM_RUNTIME_API bool jvm_runtime_xcall_future(xcall* pxcall, cdts* params, cdts* ret, jvm_xcall_completion on_complete, void* user_data, char** out_err);
+
+// Deadlines and cancellation. An entity loaded with "timeout_ms=N" in its entity path bounds
+// every call to N milliseconds; one loaded with "cancellable" can be cancelled without a
+// deadline. While such a call runs in Java it is watched: when its deadline passes, or it is
+// cancelled, the Java thread executing it is interrupted (Thread.interrupt) and the call
+// fails with a timeout or cancellation error once it returns. Java code blocked
+// interruptibly returns promptly; code that ignores interruption is not stopped, only
+// reported. For actor entities the deadline includes the time queued for the actor thread.
+// Calls queued with jvm_runtime_xcall_async are interrupted the same way on their worker
+// thread; they are not abandoned, since the host's params and ret are in use until they return.
+
+// Calls the entity once like its xcall, bounded by timeout_ms (0: the entity's timeout_ms,
+// if any). On expiry out_err is set.
+JVM_RUNTIME_API void jvm_runtime_xcall_timeout(xcall* pxcall, cdts* params, cdts* ret, uint64_t timeout_ms, char** out_err);
+
+// Interrupts the in-flight watched calls of the entity behind pxcall, made from any thread.
+// Returns how many calls were interrupted.
+JVM_RUNTIME_API uint64_t jvm_runtime_cancel_calls(xcall* pxcall);
+
+// One entity of jvm_runtime_load_entities, described by the arguments of load_entity.
+struct jvm_entity_descriptor
+{
+    const char* entity_path;
+    metaffi_type_info* params_types;
+    int8_t params_count;
+    metaffi_type_info* retvals_types;
+    int8_t retval_count;
+};
+
+// Loads count entities of module_path, as load_entity would one by one, resolving them in
+// parallel on the calling thread and a pool of JVM-attached helper threads, kept until
+// free_runtime, each using its own class loader for the module.
+// out_xcalls[i] receives the xcall of entities[i], or null with the reason in out_errors[i]
+// (released with xllr_free_string); out_errors[i] is null for loaded entities. Each xcall is
+// released with free_xcall. Entities already loaded are shared as with load_entity.
+// Returns the number of entities loaded; err is set only if none could be attempted.
+JVM_RUNTIME_API uint64_t jvm_runtime_load_entities(const char* module_path, const jvm_entity_descriptor* entities, uint64_t count, xcall** out_xcalls, char** out_errors, char** err);
@@ -0,0 +1,137 @@
+#include "jvm_runtime_epoch.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct alignas(64) runtime_call_slot
+{
+    std::atomic<uint32_t> depth{0}; // written only by the owning thread
+};
+
+namespace
+{
+    std::atomic<bool> g_live{false};
+    std::atomic<uint64_t> g_drain_waits{0};
+
+    std::mutex g_slots_mutex;
+    std::vector<std::shared_ptr<runtime_call_slot>> g_slots;
+
+    // registers the thread's slot on first use and unregisters it at thread exit;
+    // withdraw_runtime() keeps its own reference while it scans
+    struct slot_owner
+    {
+        std::shared_ptr<runtime_call_slot> slot = std::make_shared<runtime_call_slot>();
+
+        slot_owner()
+        {
+            std::lock_guard<std::mutex> lock(g_slots_mutex);
+            g_slots.push_back(slot);
+        }
+
+        ~slot_owner()
+        {
+            std::lock_guard<std::mutex> lock(g_slots_mutex);
+            for(auto& s : g_slots)
+            {
+                if(s == slot)
+                {
+                    s = std::move(g_slots.back());
+                    g_slots.pop_back();
+                    break;
+                }
+            }
+        }
+    };
+
+    runtime_call_slot& local_slot()
+    {
+        thread_local slot_owner owner;
+        return *owner.slot;
+    }
+}
+
+void publish_runtime()
+{
+    g_live.store(true, std::memory_order_release);
+}
+
+bool in_runtime_call()
+{
+    return local_slot().depth.load(std::memory_order_relaxed) > 0;
+}
+
+bool withdraw_runtime()
+{
+    if(in_runtime_call())
+    {
+        return false;
+    }
+
+    g_live.store(false, std::memory_order_relaxed);
+    // pairs with the fence of a thread's first entry: either that thread sees the runtime
+    // withdrawn, or the scan below sees its slot busy
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::vector<std::shared_ptr<runtime_call_slot>> slots;
+    {
+        std::lock_guard<std::mutex> lock(g_slots_mutex);
+        slots = g_slots;
+    }
+
+    bool waited = false;
+    for(const auto& slot : slots)
+    {
+        while(slot->depth.load(std::memory_order_acquire) != 0)
+        {
+            waited = true;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    if(waited)
+    {
+        g_drain_waits.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+runtime_call_scope::runtime_call_scope()
+{
+    runtime_call_slot& slot = local_slot();
+    uint32_t depth = slot.depth.load(std::memory_order_relaxed);
+    slot.depth.store(depth + 1, std::memory_order_relaxed);
+    if(depth == 0)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!g_live.load(std::memory_order_relaxed))
+        {
+            slot.depth.store(0, std::memory_order_release);
+            return;
+        }
+    }
+    _slot = &slot;
+}
+
+runtime_call_scope::runtime_call_scope(on_behalf_t)
+{
+    runtime_call_slot& slot = local_slot();
+    slot.depth.store(slot.depth.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _slot = &slot;
+}
+
+runtime_call_scope::~runtime_call_scope()
+{
+    if(_slot)
+    {
+        _slot->depth.store(_slot->depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+    }
+}
+
+uint64_t get_runtime_drain_wait_count()
+{
+    return g_drain_waits.load(std::memory_order_relaxed);
+}
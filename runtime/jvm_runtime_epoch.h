@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Lifetime of the loaded runtime as seen by the call path, without a lock per call.
+// Each thread owns a slot holding its call depth. Entering a call bumps the slot and checks
+// that the runtime is live; free_runtime() withdraws the runtime (no new calls enter) and
+// waits for every slot to drain before tearing it down. An outermost entry costs a store and
+// a fence; nested entries (Java calling back into the host, which calls the JVM again) are
+// a relaxed increment. Slots are registered once per thread, on its first call.
+
+struct runtime_call_slot;
+
+// Marks the runtime live once load_runtime() has finished.
+void publish_runtime();
+
+// true if the calling thread is inside a call (a runtime_call_scope is open on it).
+bool in_runtime_call();
+
+// Withdraws the runtime and waits for calls in flight on other threads to leave.
+// Returns false, leaving the runtime live, if the calling thread is itself inside a call.
+bool withdraw_runtime();
+
+// Enters a call on the calling thread; the runtime stays loaded until the scope is left.
+class runtime_call_scope
+{
+public:
+    runtime_call_scope();
+    ~runtime_call_scope();
+
+    runtime_call_scope(const runtime_call_scope&) = delete;
+    runtime_call_scope& operator=(const runtime_call_scope&) = delete;
+
+    // false if the runtime is not loaded; the call must not touch it
+    explicit operator bool() const { return _slot != nullptr; }
+
+    // Enters without the liveness check, for work done on another thread on behalf of a
+    // caller that has entered and waits for it (actor hand-off).
+    struct on_behalf_t {};
+    static constexpr on_behalf_t on_behalf{};
+    explicit runtime_call_scope(on_behalf_t);
+
+private:
+    runtime_call_slot* _slot = nullptr; // set once entered
+};
+
+// Number of withdraw_runtime() calls that had to wait for calls in flight.
+uint64_t get_runtime_drain_wait_count();
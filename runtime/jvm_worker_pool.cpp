@@ -0,0 +1,289 @@
+#include "jvm_worker_pool.h"
+#include "jni_thread_env.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    thread_local const jvm_worker_pool* t_current_pool = nullptr;
+
+    void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+}
+
+jvm_worker_pool::jvm_worker_pool(size_t workers, size_t capacity, unsigned spin_iterations)
+    // on one CPU a spinning thread only delays the thread it waits for
+    : _spin_iterations(std::thread::hardware_concurrency() > 1 ? spin_iterations : 0)
+{
+    size_t size = 2;
+    while(size < capacity)
+    {
+        size <<= 1;
+    }
+
+    _cells = std::make_unique<cell[]>(size);
+    _mask = size - 1;
+    for(size_t i = 0; i < size; i++)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    workers = std::max<size_t>(1, workers);
+    _workers.reserve(workers);
+    for(size_t i = 0; i < workers; i++)
+    {
+        _workers.emplace_back([this]() { worker_main(); });
+    }
+}
+
+jvm_worker_pool::~jvm_worker_pool()
+{
+    // one stop marker per worker, queued behind the remaining tasks
+    for(size_t i = 0; i < _workers.size(); i++)
+    {
+        while(!try_push(task{}))
+        {
+            std::this_thread::yield();
+        }
+        _pending.fetch_add(1, std::memory_order_release);
+    }
+    _pending.notify_all();
+
+    for(auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+bool jvm_worker_pool::on_worker_thread() const
+{
+    return t_current_pool == this;
+}
+
+bool jvm_worker_pool::submit(task_fn run, void* state)
+{
+    if(!run)
+    {
+        throw std::invalid_argument("Task function is null");
+    }
+
+    if(!try_push(task{run, state}))
+    {
+        return false;
+    }
+    _pending.fetch_add(1, std::memory_order_release);
+    _pending.notify_one();
+    return true;
+}
+
+bool jvm_worker_pool::run_sync(task_fn run, void* state, std::chrono::steady_clock::time_point deadline)
+{
+    if(on_worker_thread())
+    {
+        run(state);
+        return true;
+    }
+
+    // On the heap, owned by the caller and the worker: a caller that gives up at its deadline
+    // returns while the task may still sit in the queue.
+    struct sync_call
+    {
+        enum : int { queued, running, done, abandoned };
+
+        sync_call(task_fn r, void* s) : run(r), state(s) {}
+
+        task_fn run;
+        void* state;
+        std::atomic<int> stage{queued};
+        std::atomic<int> owners{2}; // the last one to let go deletes the call
+        std::mutex mutex; // orders the done notification with a parked caller
+        std::condition_variable finished;
+
+        void release()
+        {
+            if(owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                delete this;
+            }
+        }
+    };
+    auto* call = new sync_call(run, state);
+
+    auto run_call = [](void* p)
+    {
+        auto* c = static_cast<sync_call*>(p);
+        int expected = sync_call::queued;
+        if(c->stage.compare_exchange_strong(expected, sync_call::running, std::memory_order_acq_rel))
+        {
+            c->run(c->state);
+            {
+                std::lock_guard<std::mutex> lock(c->mutex);
+                c->stage.store(sync_call::done, std::memory_order_release);
+            }
+            c->finished.notify_one();
+        }
+        c->release();
+    };
+
+    while(!submit(run_call, call))
+    {
+        if(std::chrono::steady_clock::now() >= deadline)
+        {
+            delete call; // never queued
+            return false;
+        }
+        std::this_thread::yield();
+    }
+
+    bool ran = true;
+    bool finished = false;
+    for(unsigned i = 0; i < _spin_iterations && !finished; i++)
+    {
+        cpu_relax();
+        finished = call->stage.load(std::memory_order_acquire) == sync_call::done;
+    }
+    if(!finished)
+    {
+        auto is_done = [call]() { return call->stage.load(std::memory_order_acquire) == sync_call::done; };
+        std::unique_lock<std::mutex> lock(call->mutex);
+        if(deadline == std::chrono::steady_clock::time_point::max())
+        {
+            call->finished.wait(lock, is_done);
+        }
+        else if(!call->finished.wait_until(lock, deadline, is_done))
+        {
+            // a task the worker has not claimed is withdrawn; a started one runs to the end
+            int expected = sync_call::queued;
+            if(call->stage.compare_exchange_strong(expected, sync_call::abandoned, std::memory_order_acq_rel))
+            {
+                ran = false;
+            }
+            else
+            {
+                call->finished.wait(lock, is_done);
+            }
+        }
+    }
+
+    call->release();
+    return ran;
+}
+
+// Bounded MPMC queue (D. Vyukov): each cell's sequence number tells producers and consumers
+// whether it is free for the position they hold, so both sides only CAS their own index.
+bool jvm_worker_pool::try_push(const task& t)
+{
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        cell& c = _cells[pos & _mask];
+        size_t seq = c.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if(diff == 0)
+        {
+            if(_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                c.value = t;
+                c.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if(diff < 0)
+        {
+            return false; // full
+        }
+        else
+        {
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool jvm_worker_pool::try_pop(task& out)
+{
+    size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        cell& c = _cells[pos & _mask];
+        size_t seq = c.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if(diff == 0)
+        {
+            if(_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                out = c.value;
+                c.sequence.store(pos + _mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if(diff < 0)
+        {
+            return false; // empty
+        }
+        else
+        {
+            pos = _dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void jvm_worker_pool::worker_main()
+{
+    t_current_pool = this;
+    try
+    {
+        // attach up front so the first task does not pay for it
+        get_thread_env();
+    }
+    catch(const std::exception&)
+    {
+        // tasks report the attach failure through their own error path
+    }
+
+    for(;;)
+    {
+        task t;
+        if(try_pop(t))
+        {
+            _pending.fetch_sub(1, std::memory_order_relaxed);
+            if(!t.run)
+            {
+                return;
+            }
+            t.run(t.state);
+            continue;
+        }
+
+        // a call that follows closely is picked up without a park/unpark round trip
+        int64_t pending = _pending.load(std::memory_order_acquire);
+        for(unsigned i = 0; i < _spin_iterations && pending <= 0; i++)
+        {
+            cpu_relax();
+            pending = _pending.load(std::memory_order_acquire);
+        }
+
+        // a producer may have claimed a cell but not yet counted it; only sleep when idle
+        if(pending <= 0)
+        {
+            _pending.wait(pending, std::memory_order_acquire);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
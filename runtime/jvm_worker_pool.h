@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Fixed pool of JVM-attached worker threads for asynchronous xcalls.
+// Tasks go through one bounded lock-free multi-producer/multi-consumer queue shared by all
+// workers, so an idle worker always picks up the next task (no per-worker queues to steal
+// from). Workers attach to the JVM when they start and detach when they exit.
+// A pool with one worker serves as the dedicated thread of an actor entity; the worker
+// drains every queued task per wake-up and can spin briefly before parking.
+class jvm_worker_pool
+{
+public:
+    using task_fn = void (*)(void* state);
+
+    // capacity is rounded up to a power of two; an idle worker polls the queue
+    // spin_iterations times before it parks
+    jvm_worker_pool(size_t workers, size_t capacity, unsigned spin_iterations = 0);
+
+    // Runs the tasks already queued, then joins the workers.
+    ~jvm_worker_pool();
+
+    jvm_worker_pool(const jvm_worker_pool&) = delete;
+    jvm_worker_pool& operator=(const jvm_worker_pool&) = delete;
+
+    // Queues run(state). Returns false, without running it, if the queue is full.
+    bool submit(task_fn run, void* state);
+
+    // Runs run(state) on a worker and returns when it has finished, spinning before parking
+    // like the workers do. Waits for room when the queue is full; runs inline when called
+    // from one of the pool's own workers. Returns false, without running it, if no worker
+    // has started it by deadline; once started, it is waited for to the end.
+    bool run_sync(task_fn run, void* state, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    [[nodiscard]] size_t worker_count() const { return _workers.size(); }
+
+    // true when called from one of this pool's workers
+    [[nodiscard]] bool on_worker_thread() const;
+
+private:
+    struct task
+    {
+        task_fn run = nullptr; // nullptr stops the worker that dequeues it
+        void* state = nullptr;
+    };
+
+    struct cell
+    {
+        std::atomic<size_t> sequence{0};
+        task value;
+    };
+
+    bool try_push(const task& t);
+    bool try_pop(task& out);
+    void worker_main();
+
+    std::unique_ptr<cell[]> _cells;
+    size_t _mask = 0;
+    unsigned _spin_iterations = 0;
+    alignas(64) std::atomic<size_t> _enqueue_pos{0};
+    alignas(64) std::atomic<size_t> _dequeue_pos{0};
+    alignas(64) std::atomic<int64_t> _pending{0}; // queued tasks not yet claimed; idle workers wait on it
+
+    std::vector<std::thread> _workers;
+};
@@ -0,0 +1,444 @@
+#include "simd_convert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define METAFFI_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(METAFFI_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define METAFFI_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define METAFFI_TARGET_AVX2
+#endif
+
+namespace
+{
+    // scalar kernels: reference behaviour and loop tails of the vector variants
+
+    void widen_u8_to_i16_scalar(const uint8_t* src, int16_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = static_cast<int16_t>(src[i]);
+        }
+    }
+
+    void widen_u16_to_i32_scalar(const uint16_t* src, int32_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = static_cast<int32_t>(src[i]);
+        }
+    }
+
+    void widen_u32_to_i64_scalar(const uint32_t* src, int64_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = static_cast<int64_t>(src[i]);
+        }
+    }
+
+    void narrow_i16_to_u8_scalar(const int16_t* src, uint8_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = static_cast<uint8_t>(src[i]);
+        }
+    }
+
+    void narrow_i32_to_u16_scalar(const int32_t* src, uint16_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = static_cast<uint16_t>(src[i]);
+        }
+    }
+
+    void narrow_i64_to_u32_scalar(const int64_t* src, uint32_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = static_cast<uint32_t>(src[i]);
+        }
+    }
+
+    void normalize_bools_scalar(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[i] = src[i] != 0 ? 1 : 0;
+        }
+    }
+
+    size_t ascii_prefix_u8_scalar(const uint8_t* src, size_t count)
+    {
+        size_t i = 0;
+        while(i < count && src[i] < 0x80)
+        {
+            i++;
+        }
+        return i;
+    }
+
+    size_t ascii_prefix_u16_scalar(const uint16_t* src, size_t count)
+    {
+        size_t i = 0;
+        while(i < count && src[i] < 0x80)
+        {
+            i++;
+        }
+        return i;
+    }
+
+    constexpr conversion_kernels scalar_kernels = {
+        widen_u8_to_i16_scalar,
+        widen_u16_to_i32_scalar,
+        widen_u32_to_i64_scalar,
+        narrow_i16_to_u8_scalar,
+        narrow_i32_to_u16_scalar,
+        narrow_i64_to_u32_scalar,
+        normalize_bools_scalar,
+        ascii_prefix_u8_scalar,
+        ascii_prefix_u16_scalar
+    };
+
+#ifdef METAFFI_SIMD_X86
+
+    // SSE2 is part of the x86-64 baseline, no target attribute needed
+
+    void widen_u8_to_i16_sse2(const uint8_t* src, int16_t* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+        }
+        widen_u8_to_i16_scalar(src + i, dst + i, count - i);
+    }
+
+    void widen_u16_to_i32_sse2(const uint16_t* src, int32_t* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(v, zero));
+        }
+        widen_u16_to_i32_scalar(src + i, dst + i, count - i);
+    }
+
+    void widen_u32_to_i64_sse2(const uint32_t* src, int64_t* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi32(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 2), _mm_unpackhi_epi32(v, zero));
+        }
+        widen_u32_to_i64_scalar(src + i, dst + i, count - i);
+    }
+
+    void narrow_i16_to_u8_sse2(const int16_t* src, uint8_t* dst, size_t count)
+    {
+        // masking to the low byte keeps packus from saturating
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), mask);
+            __m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), mask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+        }
+        narrow_i16_to_u8_scalar(src + i, dst + i, count - i);
+    }
+
+    void narrow_i32_to_u16_sse2(const int32_t* src, uint16_t* dst, size_t count)
+    {
+        // SSE2 has no packus_epi32: sign-extend the low half so the signed pack is exact
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+            a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+            b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(a, b));
+        }
+        narrow_i32_to_u16_scalar(src + i, dst + i, count - i);
+    }
+
+    void narrow_i64_to_u32_sse2(const int64_t* src, uint32_t* dst, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 2));
+            // move the low dword of each qword into the low half, then join both halves
+            a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+            b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi64(a, b));
+        }
+        narrow_i64_to_u32_scalar(src + i, dst + i, count - i);
+    }
+
+    void normalize_bools_sse2(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi8(1);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i is_zero = _mm_cmpeq_epi8(v, zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_andnot_si128(is_zero, one));
+        }
+        normalize_bools_scalar(src + i, dst + i, count - i);
+    }
+
+    size_t ascii_prefix_u8_sse2(const uint8_t* src, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            // movemask collects the high bit of every byte
+            int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            if(mask != 0)
+            {
+                return i + ascii_prefix_u8_scalar(src + i, 16);
+            }
+        }
+        return i + ascii_prefix_u8_scalar(src + i, count - i);
+    }
+
+    size_t ascii_prefix_u16_sse2(const uint16_t* src, size_t count)
+    {
+        const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            if(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, non_ascii), zero)) != 0xFFFF)
+            {
+                return i + ascii_prefix_u16_scalar(src + i, 8);
+            }
+        }
+        return i + ascii_prefix_u16_scalar(src + i, count - i);
+    }
+
+    constexpr conversion_kernels sse2_kernels = {
+        widen_u8_to_i16_sse2,
+        widen_u16_to_i32_sse2,
+        widen_u32_to_i64_sse2,
+        narrow_i16_to_u8_sse2,
+        narrow_i32_to_u16_sse2,
+        narrow_i64_to_u32_sse2,
+        normalize_bools_sse2,
+        ascii_prefix_u8_sse2,
+        ascii_prefix_u16_sse2
+    };
+
+    METAFFI_TARGET_AVX2 void widen_u8_to_i16_avx2(const uint8_t* src, int16_t* dst, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepu8_epi16(v));
+        }
+        widen_u8_to_i16_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 void widen_u16_to_i32_avx2(const uint16_t* src, int32_t* dst, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepu16_epi32(v));
+        }
+        widen_u16_to_i32_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 void widen_u32_to_i64_avx2(const uint32_t* src, int64_t* dst, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepu32_epi64(v));
+        }
+        widen_u32_to_i64_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 void narrow_i16_to_u8_avx2(const int16_t* src, uint8_t* dst, size_t count)
+    {
+        const __m256i mask = _mm256_set1_epi16(0x00FF);
+        size_t i = 0;
+        for(; i + 32 <= count; i += 32)
+        {
+            __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), mask);
+            __m256i b = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), mask);
+            // packus works per 128-bit lane; restore element order across lanes
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        narrow_i16_to_u8_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 void narrow_i32_to_u16_avx2(const int32_t* src, uint16_t* dst, size_t count)
+    {
+        const __m256i mask = _mm256_set1_epi32(0xFFFF);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), mask);
+            __m256i b = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8)), mask);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        narrow_i32_to_u16_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 void narrow_i64_to_u32_avx2(const int64_t* src, uint32_t* dst, size_t count)
+    {
+        const __m256i low_dwords = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i packed = _mm256_permutevar8x32_epi32(v, low_dwords);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(packed));
+        }
+        narrow_i64_to_u32_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 void normalize_bools_avx2(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi8(1);
+        size_t i = 0;
+        for(; i + 32 <= count; i += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i is_zero = _mm256_cmpeq_epi8(v, zero);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_andnot_si256(is_zero, one));
+        }
+        normalize_bools_scalar(src + i, dst + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 size_t ascii_prefix_u8_avx2(const uint8_t* src, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 32 <= count; i += 32)
+        {
+            int mask = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+            if(mask != 0)
+            {
+                return i + ascii_prefix_u8_scalar(src + i, 32);
+            }
+        }
+        return i + ascii_prefix_u8_scalar(src + i, count - i);
+    }
+
+    METAFFI_TARGET_AVX2 size_t ascii_prefix_u16_avx2(const uint16_t* src, size_t count)
+    {
+        const __m256i non_ascii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            if(!_mm256_testz_si256(v, non_ascii))
+            {
+                return i + ascii_prefix_u16_scalar(src + i, 16);
+            }
+        }
+        return i + ascii_prefix_u16_scalar(src + i, count - i);
+    }
+
+    constexpr conversion_kernels avx2_kernels = {
+        widen_u8_to_i16_avx2,
+        widen_u16_to_i32_avx2,
+        widen_u32_to_i64_avx2,
+        narrow_i16_to_u8_avx2,
+        narrow_i32_to_u16_avx2,
+        narrow_i64_to_u32_avx2,
+        normalize_bools_avx2,
+        ascii_prefix_u8_avx2,
+        ascii_prefix_u16_avx2
+    };
+
+    bool cpu_supports_avx2()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        if(info[0] < 7)
+        {
+            return false;
+        }
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if(!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) // OS saves XMM and YMM state
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif
+}
+
+simd_level detect_simd_level()
+{
+#ifdef METAFFI_SIMD_X86
+    static const simd_level level = cpu_supports_avx2() ? simd_level::avx2 : simd_level::sse2;
+    return level;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+const conversion_kernels& conversion_kernels_for(simd_level level)
+{
+    if(level > detect_simd_level())
+    {
+        level = detect_simd_level();
+    }
+
+    switch(level)
+    {
+#ifdef METAFFI_SIMD_X86
+        case simd_level::avx2: return avx2_kernels;
+        case simd_level::sse2: return sse2_kernels;
+#endif
+        case simd_level::scalar:
+        default:
+            return scalar_kernels;
+    }
+}
+
+const conversion_kernels& get_conversion_kernels()
+{
+    static const conversion_kernels& kernels = conversion_kernels_for(detect_simd_level());
+    return kernels;
+}
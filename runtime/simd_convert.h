@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized element conversions between host array types and the wider or narrower Java
+// primitive they are marshalled as (uint8 <-> short, uint16 <-> int, uint32 <-> long,
+// metaffi_bool -> boolean) plus the ASCII scans of the string fast path. Kernels work on
+// contiguous buffers and handle any length; the best variant for the CPU is picked once
+// at runtime.
+// Narrowing truncates to the low bits, matching a static_cast of each element.
+
+enum class simd_level
+{
+    scalar,
+    sse2,
+    avx2
+};
+
+struct conversion_kernels
+{
+    void (*widen_u8_to_i16)(const uint8_t* src, int16_t* dst, size_t count);
+    void (*widen_u16_to_i32)(const uint16_t* src, int32_t* dst, size_t count);
+    void (*widen_u32_to_i64)(const uint32_t* src, int64_t* dst, size_t count);
+    void (*narrow_i16_to_u8)(const int16_t* src, uint8_t* dst, size_t count);
+    void (*narrow_i32_to_u16)(const int32_t* src, uint16_t* dst, size_t count);
+    void (*narrow_i64_to_u32)(const int64_t* src, uint32_t* dst, size_t count);
+    void (*normalize_bools)(const uint8_t* src, uint8_t* dst, size_t count); // non-zero -> 1
+    size_t (*ascii_prefix_u8)(const uint8_t* src, size_t count);   // leading bytes below 0x80
+    size_t (*ascii_prefix_u16)(const uint16_t* src, size_t count); // leading units below 0x80
+};
+
+// Highest level supported by both the build and the running CPU.
+simd_level detect_simd_level();
+
+// Kernels for a specific level; a level above detect_simd_level() yields the detected one.
+const conversion_kernels& conversion_kernels_for(simd_level level);
+
+// Kernels for detect_simd_level(), resolved once.
+const conversion_kernels& get_conversion_kernels();
@@ -1,7 +1,14 @@
 #include "jvm_test_env.h"
 
+#include <runtime/xllr_capi_loader.h>
 #include <utils/env_utils.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
 #include <filesystem>
 #include <initializer_list>
 #include <iostream>
@@ -169,3 +176,176 @@ void trace_step(const std::string& msg)
 {
 	trace(msg);
 }
+
+void* jvm_plugin_symbol(const char* name)
+{
+	auto plugin_dir = std::filesystem::path(require_env("METAFFI_HOME")) / "jvm";
+
+#ifdef _WIN32
+	HMODULE module = GetModuleHandleW((plugin_dir / "xllr.jvm.dll").wstring().c_str());
+	if(!module)
+	{
+		return nullptr;
+	}
+	return reinterpret_cast<void*>(GetProcAddress(module, name));
+#else
+#ifdef __APPLE__
+	const std::vector<const char*> candidates = {"xllr.jvm.dylib", "libxllr.jvm.dylib"};
+#else
+	const std::vector<const char*> candidates = {"xllr.jvm.so", "libxllr.jvm.so"};
+#endif
+	for(const auto* candidate : candidates)
+	{
+		// RTLD_NOLOAD: only reuse the copy xllr already loaded, never load a second one
+		void* handle = dlopen((plugin_dir / candidate).string().c_str(), RTLD_NOW | RTLD_NOLOAD);
+		if(handle)
+		{
+			void* sym = dlsym(handle, name);
+			dlclose(handle);
+			return sym;
+		}
+	}
+	return nullptr;
+#endif
+}
+
+uint64_t jvm_runtime_counter(const char* name)
+{
+	using get_counter_t = bool (*)(const char*, uint64_t*);
+	auto get_counter = reinterpret_cast<get_counter_t>(jvm_plugin_symbol("jvm_runtime_get_counter"));
+	if(!get_counter)
+	{
+		throw std::runtime_error("jvm_runtime_get_counter is not exported by the JVM runtime plugin");
+	}
+
+	uint64_t value = 0;
+	if(!get_counter(name, &value))
+	{
+		throw std::runtime_error(std::string("Unknown JVM runtime counter: ") + name);
+	}
+	return value;
+}
+
+void jvm_runtime_option(const char* name, uint64_t value)
+{
+	using set_option_t = bool (*)(const char*, uint64_t);
+	auto set_option = reinterpret_cast<set_option_t>(jvm_plugin_symbol("jvm_runtime_set_option"));
+	if(!set_option)
+	{
+		throw std::runtime_error("jvm_runtime_set_option is not exported by the JVM runtime plugin");
+	}
+
+	if(!set_option(name, value))
+	{
+		throw std::runtime_error(std::string("Unknown JVM runtime option: ") + name);
+	}
+}
+
+ScopedJvmRuntimeOption::ScopedJvmRuntimeOption(const char* name, uint64_t value, uint64_t restore_value)
+	: _name(name), _restore_value(restore_value)
+{
+	jvm_runtime_option(name, value);
+}
+
+ScopedJvmRuntimeOption::~ScopedJvmRuntimeOption()
+{
+	try
+	{
+		jvm_runtime_option(_name.c_str(), _restore_value);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << "ScopedJvmRuntimeOption: failed to restore " << _name << ": " << e.what() << std::endl;
+	}
+}
+
+void throw_plugin_error(char* err)
+{
+	if(err)
+	{
+		std::string msg(err);
+		xllr_free_string(err);
+		throw std::runtime_error(msg);
+	}
+}
+
+PluginEntity::PluginEntity(const std::string& entity_path, std::vector<metaffi_type_info> params, std::vector<metaffi_type_info> retvals)
+{
+	using load_entity_t = xcall* (*)(const char*, const char*, metaffi_type_info*, int8_t, metaffi_type_info*, int8_t, char**);
+	auto load = reinterpret_cast<load_entity_t>(jvm_plugin_symbol("load_entity"));
+	if(!load)
+	{
+		throw std::runtime_error("load_entity is not exported by the JVM runtime plugin");
+	}
+
+	char* err = nullptr;
+	_xcall = load(jvm_test_env().guest_classpath.c_str(), entity_path.c_str(),
+		params.empty() ? nullptr : params.data(), static_cast<int8_t>(params.size()),
+		retvals.empty() ? nullptr : retvals.data(), static_cast<int8_t>(retvals.size()), &err);
+	throw_plugin_error(err);
+}
+
+PluginEntity::~PluginEntity()
+{
+	using free_xcall_t = void (*)(xcall*, char**);
+	auto free_entity = reinterpret_cast<free_xcall_t>(jvm_plugin_symbol("free_xcall"));
+	if(!free_entity || !_xcall)
+	{
+		return;
+	}
+
+	char* err = nullptr;
+	free_entity(_xcall, &err);
+	if(err)
+	{
+		xllr_free_string(err);
+	}
+}
+
+PluginEntities::PluginEntities(const std::string& module_path, const std::vector<jvm_entity_descriptor>& entities)
+	: _xcalls(entities.size(), nullptr), _errors(entities.size())
+{
+	using load_entities_t = uint64_t (*)(const char*, const jvm_entity_descriptor*, uint64_t, xcall**, char**, char**);
+	auto load = reinterpret_cast<load_entities_t>(jvm_plugin_symbol("jvm_runtime_load_entities"));
+	if(!load)
+	{
+		throw std::runtime_error("jvm_runtime_load_entities is not exported by the JVM runtime plugin");
+	}
+
+	std::vector<char*> entry_errors(entities.size(), nullptr);
+	char* err = nullptr;
+	_loaded = load(module_path.c_str(), entities.data(), entities.size(), _xcalls.data(), entry_errors.data(), &err);
+	for(size_t i = 0; i < entry_errors.size(); i++)
+	{
+		if(entry_errors[i])
+		{
+			_errors[i] = entry_errors[i];
+			xllr_free_string(entry_errors[i]);
+		}
+	}
+	throw_plugin_error(err);
+}
+
+PluginEntities::~PluginEntities()
+{
+	using free_xcall_t = void (*)(xcall*, char**);
+	auto free_entity = reinterpret_cast<free_xcall_t>(jvm_plugin_symbol("free_xcall"));
+	if(!free_entity)
+	{
+		return;
+	}
+
+	for(xcall* pxcall : _xcalls)
+	{
+		if(!pxcall)
+		{
+			continue;
+		}
+		char* err = nullptr;
+		free_entity(pxcall, &err);
+		if(err)
+		{
+			xllr_free_string(err);
+		}
+	}
+}
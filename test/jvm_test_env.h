@@ -2,7 +2,11 @@
 
 #include <metaffi/api/metaffi_api.h>
 
+#include "jvm_runtime_api.h"
+
+#include <cstdint>
 #include <string>
+#include <vector>
 
 struct JvmTestEnv
 {
@@ -19,3 +23,77 @@ JvmTestEnv& jvm_test_env();
 std::string require_env(const char* name);
 char jvm_classpath_separator();
 void trace_step(const std::string& msg);
+
+// Resolves an export of the already-loaded JVM runtime plugin (see runtime/jvm_runtime_api.h).
+// Returns nullptr if the plugin or the symbol cannot be found.
+void* jvm_plugin_symbol(const char* name);
+
+// Reads a counter through jvm_runtime_get_counter. Throws if the export or the counter is missing.
+uint64_t jvm_runtime_counter(const char* name);
+
+// Sets an option through jvm_runtime_set_option. Throws if the export or the option is missing.
+void jvm_runtime_option(const char* name, uint64_t value);
+
+// Sets a runtime option for the lifetime of the object; the option is set to restore_value
+// (0, the default of every option when its environment variable is unset) when the scope
+// ends, including when a REQUIRE fails.
+class ScopedJvmRuntimeOption
+{
+public:
+	ScopedJvmRuntimeOption(const char* name, uint64_t value, uint64_t restore_value = 0);
+	~ScopedJvmRuntimeOption();
+
+	ScopedJvmRuntimeOption(const ScopedJvmRuntimeOption&) = delete;
+	ScopedJvmRuntimeOption& operator=(const ScopedJvmRuntimeOption&) = delete;
+
+private:
+	std::string _name;
+	uint64_t _restore_value = 0;
+};
+
+// Throws std::runtime_error carrying err if it is set; err is released with xllr_free_string.
+void throw_plugin_error(char* err);
+
+inline metaffi_type_info plugin_type(metaffi_type type)
+{
+	return metaffi_type_info{type, nullptr, false, 0};
+}
+
+// An entity loaded straight through the plugin's load_entity export, for the entry points of
+// jvm_runtime_api.h that take the plugin's xcall rather than the API wrapper.
+class PluginEntity
+{
+public:
+	PluginEntity(const std::string& entity_path, std::vector<metaffi_type_info> params, std::vector<metaffi_type_info> retvals);
+	~PluginEntity();
+
+	PluginEntity(const PluginEntity&) = delete;
+	PluginEntity& operator=(const PluginEntity&) = delete;
+
+	[[nodiscard]] xcall* get() const { return _xcall; }
+
+private:
+	xcall* _xcall = nullptr;
+};
+
+// Entities loaded together through the plugin's jvm_runtime_load_entities export. An entity
+// that failed to load has a null xcall and its error in errors(); the others are freed with
+// the object.
+class PluginEntities
+{
+public:
+	PluginEntities(const std::string& module_path, const std::vector<jvm_entity_descriptor>& entities);
+	~PluginEntities();
+
+	PluginEntities(const PluginEntities&) = delete;
+	PluginEntities& operator=(const PluginEntities&) = delete;
+
+	[[nodiscard]] const std::vector<xcall*>& xcalls() const { return _xcalls; }
+	[[nodiscard]] const std::vector<std::string>& errors() const { return _errors; } // empty if loaded
+	[[nodiscard]] uint64_t loaded() const { return _loaded; }
+
+private:
+	std::vector<xcall*> _xcalls;
+	std::vector<std::string> _errors;
+	uint64_t _loaded = 0;
+};
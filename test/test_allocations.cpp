@@ -0,0 +1,196 @@
+#include <doctest/doctest.h>
+
+#include "jvm_test_env.h"
+
+#include <runtime/cdt.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts global operator new calls made by the current thread while a counter is active.
+// Only the calling thread is counted so JVM and doctest background activity does not leak in.
+//
+// The replacement operator new below is only seen by the plugin where the dynamic linker binds
+// the plugin's operator new to the executable's (ELF symbol interposition, and the weak libc++
+// definitions on macOS). On Windows each DLL calls the allocator of the CRT it links, so plugin
+// allocations would not be counted and the tests are skipped there.
+namespace
+{
+#ifdef _WIN32
+constexpr bool plugin_allocations_counted = false;
+#else
+constexpr bool plugin_allocations_counted = true;
+#endif
+
+thread_local bool g_count_allocations = false;
+thread_local std::size_t g_allocations = 0;
+
+void* counted_alloc(std::size_t size)
+{
+	if(g_count_allocations)
+	{
+		g_allocations++;
+	}
+
+	void* p = std::malloc(size == 0 ? 1 : size);
+	if(!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+class allocation_counter
+{
+public:
+	allocation_counter()
+	{
+		g_allocations = 0;
+		g_count_allocations = true;
+	}
+
+	~allocation_counter()
+	{
+		g_count_allocations = false;
+	}
+
+	std::size_t stop()
+	{
+		g_count_allocations = false;
+		return g_allocations;
+	}
+};
+
+using xcall_timeout_t = void (*)(xcall*, cdts*, cdts*, uint64_t, char**);
+
+// Calls entity with prebuilt cdts through jvm_runtime_xcall_timeout (no deadline), so only the
+// plugin's allocations are counted and not those of the API wrapper building the arguments.
+std::size_t count_plugin_allocations(const PluginEntity& entity, cdts& params, cdts& ret, int iterations)
+{
+	auto xcall_timeout = reinterpret_cast<xcall_timeout_t>(jvm_plugin_symbol("jvm_runtime_xcall_timeout"));
+	REQUIRE(xcall_timeout != nullptr);
+
+	auto call = [&]()
+	{
+		char* err = nullptr;
+		xcall_timeout(entity.get(), &params, &ret, 0, &err);
+		throw_plugin_error(err);
+	};
+
+	// warm up: thread attachment, lazily created runtime state and the JIT
+	for(int i = 0; i < 100; i++)
+	{
+		call();
+	}
+
+	allocation_counter counter;
+	for(int i = 0; i < iterations; i++)
+	{
+		call();
+	}
+	return counter.stop();
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+	return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+TEST_CASE("xcall hot path does not allocate" * doctest::skip(!plugin_allocations_counted))
+{
+	auto& env = jvm_test_env();
+
+	auto div = env.guest_module.load_entity(
+		"class=guest.CoreFunctions,callable=divIntegers",
+		{metaffi_int64_type, metaffi_int64_type},
+		{metaffi_float64_type});
+
+	// warm up: thread attachment, lazily created runtime state and the JIT
+	for(int i = 0; i < 100; i++)
+	{
+		div.call<double>(6LL, 4LL);
+	}
+
+	constexpr int iterations = 1000;
+	double sum = 0;
+	std::size_t allocations = 0;
+	{
+		allocation_counter counter;
+		for(int i = 0; i < iterations; i++)
+		{
+			auto [ratio] = div.call<double>(6LL, 4LL);
+			sum += ratio;
+		}
+		allocations = counter.stop();
+	}
+
+	MESSAGE("operator new calls during " << iterations << " xcalls: " << allocations);
+	CHECK(sum == doctest::Approx(1.5 * iterations));
+	CHECK(allocations == 0);
+}
+
+TEST_CASE("string and array parameters do not allocate" * doctest::skip(!plugin_allocations_counted))
+{
+	constexpr int iterations = 1000;
+
+	PluginEntity parse_int("class=java.lang.Integer,callable=parseInt",
+		{plugin_type(metaffi_string8_type)},
+		{plugin_type(metaffi_int32_type)});
+	static char8_t digits[] = u8"12345";
+	cdts string_params(1);
+	string_params[0].type = metaffi_string8_type;
+	string_params[0].free_required = false;
+	string_params[0].cdt_val.string8_val = digits;
+	cdts int_ret(1);
+	std::size_t string_allocations = count_plugin_allocations(parse_int, string_params, int_ret, iterations);
+	CHECK(int_ret[0].cdt_val.int32_val == 12345);
+
+	metaffi_type_info bytes_type = plugin_type(metaffi_int8_array_type);
+	bytes_type.fixed_dimensions = 1;
+	PluginEntity hash_bytes("class=java.util.Arrays,callable=hashCode",
+		{bytes_type},
+		{plugin_type(metaffi_int32_type)});
+	cdts array_params(1);
+	array_params[0].set_new_array(256, 1, metaffi_int8_type);
+	cdts& bytes = static_cast<cdts&>(array_params[0]);
+	for(size_t i = 0; i < 256; i++)
+	{
+		bytes[i] = static_cast<metaffi_int8>(i);
+	}
+	cdts hash_ret(1);
+	std::size_t array_allocations = count_plugin_allocations(hash_bytes, array_params, hash_ret, iterations);
+	CHECK(hash_ret[0].cdt_val.int32_val != 0);
+
+	MESSAGE("operator new calls during " << iterations << " string xcalls: " << string_allocations);
+	MESSAGE("operator new calls during " << iterations << " array xcalls: " << array_allocations);
+	CHECK(string_allocations == 0);
+	CHECK(array_allocations == 0);
+}
@@ -248,3 +248,206 @@ TEST_CASE("core returns arrays")
 	JavaArray diff_obj{JvmHandle(diff_obj_ptr)};
 	CHECK(diff_obj.length() == 6);
 }
+
+TEST_CASE("core unpacks Object[] into multiple return values")
+{
+	auto& env = jvm_test_env();
+
+	auto ret_multiple = env.guest_module.load_entity_with_info(
+		"class=guest.CoreFunctions,callable=returnMultipleReturnValues",
+		{},
+		{make_type(metaffi_int32_type), make_type(metaffi_string8_type), make_type(metaffi_float64_type)});
+
+	// second call is served from the cached wrapper layout
+	for(int i = 0; i < 2; i++)
+	{
+		auto [num, str, dbl] = ret_multiple.call<int32_t, std::string, double>();
+		CHECK(num == 1);
+		CHECK(str == "string");
+		CHECK(dbl == doctest::Approx(3.0));
+	}
+}
+
+TEST_CASE("core unpacks wrapper fields into multiple return values")
+{
+	auto& env = jvm_test_env();
+
+	auto int_stream_type = make_alias_type(metaffi_handle_type, "java.util.stream.IntStream");
+	auto int_stream_of = env.guest_module.load_entity_with_info(
+		"class=java.util.stream.IntStream,callable=of",
+		{make_array_type(metaffi_int32_array_type, 1)},
+		{int_stream_type});
+
+	// IntSummaryStatistics declares long count, long sum, int min, int max
+	auto typed_stats = env.guest_module.load_entity_with_info(
+		"class=java.util.stream.IntStream,callable=summaryStatistics,instance_required",
+		{int_stream_type},
+		{make_type(metaffi_int64_type), make_type(metaffi_int64_type), make_type(metaffi_int32_type), make_type(metaffi_int32_type)});
+	// int fields read into int64 returns take the boxing fallback
+	auto boxed_stats = env.guest_module.load_entity_with_info(
+		"class=java.util.stream.IntStream,callable=summaryStatistics,instance_required",
+		{int_stream_type},
+		{make_type(metaffi_int64_type), make_type(metaffi_int64_type), make_type(metaffi_int64_type), make_type(metaffi_int64_type)});
+
+	const std::vector<int32_t> values = {4, -2, 9, 1};
+
+	// second call is served from the cached wrapper layout
+	for(int i = 0; i < 2; i++)
+	{
+		auto [stream_ptr] = int_stream_of.call<cdt_metaffi_handle*>(values);
+		JvmHandle stream(stream_ptr);
+		auto [count, sum, min, max] = typed_stats.call<int64_t, int64_t, int32_t, int32_t>(*stream.get());
+		CHECK(count == 4);
+		CHECK(sum == 12);
+		CHECK(min == -2);
+		CHECK(max == 9);
+	}
+
+	for(int i = 0; i < 2; i++)
+	{
+		auto [stream_ptr] = int_stream_of.call<cdt_metaffi_handle*>(values);
+		JvmHandle stream(stream_ptr);
+		auto [count, sum, min, max] = boxed_stats.call<int64_t, int64_t, int64_t, int64_t>(*stream.get());
+		CHECK(count == 4);
+		CHECK(sum == 12);
+		CHECK(min == -2);
+		CHECK(max == 9);
+	}
+}
+
+TEST_CASE("array returns without fixed dimensions reuse the array class cache")
+{
+	auto& env = jvm_test_env();
+
+	auto make2d = env.guest_module.load_entity_with_info(
+		"class=guest.ArrayFunctions,callable=make2dArray",
+		{},
+		{make_array_type(metaffi_int32_array_type, MIXED_OR_UNKNOWN_DIMENSIONS)});
+
+	auto [first] = make2d.call<std::vector<std::vector<int32_t>>>();
+	REQUIRE(first.size() == 2);
+	CHECK(first[1] == std::vector<int32_t>({3, 4}));
+
+	uint64_t hits_before = jvm_runtime_counter("array_class_cache_hits");
+	uint64_t misses_before = jvm_runtime_counter("array_class_cache_misses");
+
+	for(int i = 0; i < 3; i++)
+	{
+		auto [arr2d] = make2d.call<std::vector<std::vector<int32_t>>>();
+		CHECK(arr2d[0] == std::vector<int32_t>({1, 2}));
+	}
+
+	CHECK(jvm_runtime_counter("array_class_cache_hits") - hits_before == 3);
+	CHECK(jvm_runtime_counter("array_class_cache_misses") == misses_before);
+}
+
+TEST_CASE("primitive arrays above the critical threshold are copied in bulk")
+{
+	auto& env = jvm_test_env();
+
+	auto echo_bytes = env.guest_module.load_entity_with_info(
+		"class=guest.PrimitiveFunctions,callable=echoBytes",
+		{make_array_type(metaffi_int8_array_type, 1)},
+		{make_array_type(metaffi_int8_array_type, 1)});
+	auto sum = env.guest_module.load_entity_with_info(
+		"class=guest.VarargsExamples,callable=sum",
+		{make_array_type(metaffi_int32_array_type, 1)},
+		{make_type(metaffi_int32_type)});
+
+	std::vector<int8_t> payload(4096);
+	for(size_t i = 0; i < payload.size(); ++i)
+	{
+		payload[i] = static_cast<int8_t>(i * 7);
+	}
+	std::vector<int32_t> small = {1, 2, 3, 4};
+
+	ScopedJvmRuntimeOption threshold("critical_array_threshold", 1024);
+	uint64_t copies_before = jvm_runtime_counter("critical_array_copies");
+
+	auto [echoed] = echo_bytes.call<std::vector<int8_t>>(payload);
+	CHECK(echoed == payload);
+	// parameter and return value
+	CHECK(jvm_runtime_counter("critical_array_copies") - copies_before == 2);
+
+	// below the threshold the serializer path is used
+	auto [sum_val] = sum.call<int32_t>(small);
+	CHECK(sum_val == 10);
+	CHECK(jvm_runtime_counter("critical_array_copies") - copies_before == 2);
+
+	// an array that does not match the declared element type is left to the serializer
+	std::vector<int64_t> wide(1024, 1);
+	try
+	{
+		(void)sum.call<int32_t>(wide);
+	}
+	catch(const std::exception&)
+	{
+	}
+	CHECK(jvm_runtime_counter("critical_array_copies") - copies_before == 2);
+
+	jvm_runtime_option("critical_array_threshold", 0);
+	auto [echoed_again] = echo_bytes.call<std::vector<int8_t>>(payload);
+	CHECK(echoed_again == payload);
+	CHECK(jvm_runtime_counter("critical_array_copies") - copies_before == 2);
+}
+
+TEST_CASE("buffer=direct passes byte arrays as ByteBuffers")
+{
+	auto& env = jvm_test_env();
+
+	auto crc_type = make_alias_type(metaffi_handle_type, "java.util.zip.CRC32");
+	auto new_crc = env.guest_module.load_entity_with_info(
+		"class=java.util.zip.CRC32,callable=<init>",
+		{},
+		{crc_type});
+	auto update_buffer = env.guest_module.load_entity_with_info(
+		"class=java.util.zip.CRC32,callable=update,instance_required,buffer=direct",
+		{crc_type, make_array_type(metaffi_uint8_array_type, 1)},
+		{});
+	auto update_bytes = env.guest_module.load_entity_with_info(
+		"class=java.util.zip.CRC32,callable=update,instance_required",
+		{crc_type, make_array_type(metaffi_int8_array_type, 1)},
+		{});
+	auto get_value = env.guest_module.load_entity_with_info(
+		"class=java.util.zip.CRC32,callable=getValue,instance_required",
+		{crc_type},
+		{make_type(metaffi_int64_type)});
+
+	std::vector<uint8_t> payload(1000);
+	std::vector<int8_t> signed_payload(payload.size());
+	for(size_t i = 0; i < payload.size(); ++i)
+	{
+		payload[i] = static_cast<uint8_t>(i * 31);
+		signed_payload[i] = static_cast<int8_t>(payload[i]);
+	}
+
+	auto [direct_ptr] = new_crc.call<cdt_metaffi_handle*>();
+	JvmHandle direct_crc(direct_ptr);
+	CHECK_NOTHROW(update_buffer.call<>(*direct_crc.get(), payload));
+	auto [direct_value] = get_value.call<int64_t>(*direct_crc.get());
+
+	auto [array_ptr] = new_crc.call<cdt_metaffi_handle*>();
+	JvmHandle array_crc(array_ptr);
+	CHECK_NOTHROW(update_bytes.call<>(*array_crc.get(), signed_payload));
+	auto [array_value] = get_value.call<int64_t>(*array_crc.get());
+
+	CHECK(direct_value != 0);
+	CHECK(direct_value == array_value);
+
+	// only 1-D byte arrays can back a ByteBuffer parameter
+	std::vector<int32_t> ints = {1, 2, 3};
+	CHECK_THROWS(update_buffer.call<>(*direct_crc.get(), ints));
+	auto [value_after_error] = get_value.call<int64_t>(*direct_crc.get());
+	CHECK(value_after_error == direct_value);
+
+	// direct and heap ByteBuffer returns come back as host byte arrays
+	for(const char* factory : {"allocateDirect", "allocate"})
+	{
+		auto allocate = env.guest_module.load_entity_with_info(
+			std::string("class=java.nio.ByteBuffer,callable=") + factory + ",buffer=direct",
+			{make_type(metaffi_int32_type)},
+			{make_array_type(metaffi_uint8_array_type, 1)});
+		auto [bytes] = allocate.call<std::vector<uint8_t>>(int32_t(16));
+		CHECK(bytes == std::vector<uint8_t>(16, 0));
+	}
+}
@@ -0,0 +1,159 @@
+#include <doctest/doctest.h>
+
+#include "jvm_test_env.h"
+#include "jvm_wrappers.h"
+
+#include <runtime/cdt.h>
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class BatchEntity
+{
+public:
+	BatchEntity(const std::string& entity_path, std::vector<metaffi_type_info> params, std::vector<metaffi_type_info> retvals)
+		: _entity(entity_path, std::move(params), std::move(retvals)),
+		  _batch(reinterpret_cast<batch_t>(jvm_plugin_symbol("jvm_runtime_xcall_batch")))
+	{
+		if(!_batch)
+		{
+			throw std::runtime_error("jvm_runtime_xcall_batch is not exported by the JVM runtime plugin");
+		}
+	}
+
+	void call(cdts* params, cdts* results, uint64_t rows)
+	{
+		char* err = nullptr;
+		_batch(_entity.get(), params, results, rows, &err);
+		throw_plugin_error(err);
+	}
+
+private:
+	using batch_t = void (*)(xcall*, cdts*, cdts*, uint64_t, char**);
+
+	PluginEntity _entity;
+	batch_t _batch = nullptr;
+};
+
+// divIntegers(a, b) over two int64 columns
+void fill_div_columns(cdts& params, size_t rows)
+{
+	params[0].set_new_array(rows, 1, metaffi_int64_type);
+	params[1].set_new_array(rows, 1, metaffi_int64_type);
+	cdts& lhs = static_cast<cdts&>(params[0]);
+	cdts& rhs = static_cast<cdts&>(params[1]);
+	for(size_t i = 0; i < rows; i++)
+	{
+		lhs[i] = static_cast<metaffi_int64>(i);
+		rhs[i] = static_cast<metaffi_int64>(4);
+	}
+}
+}
+
+TEST_CASE("batched calls run one entity over columnar rows")
+{
+	BatchEntity div("class=guest.CoreFunctions,callable=divIntegers",
+		{plugin_type(metaffi_int64_type), plugin_type(metaffi_int64_type)},
+		{plugin_type(metaffi_float64_type)});
+
+	constexpr size_t rows = 1000;
+	cdts params(2);
+	fill_div_columns(params, rows);
+	cdts results(1);
+	div.call(&params, &results, rows);
+
+	cdts& column = static_cast<cdts&>(results[0]);
+	REQUIRE(column.length == rows);
+	for(size_t i = 0; i < rows; i++)
+	{
+		CHECK(column[i].cdt_val.float64_val == doctest::Approx(static_cast<double>(i) / 4.0));
+	}
+
+	// an empty batch is a no-op with an empty result column
+	cdts empty_params(2);
+	fill_div_columns(empty_params, 0);
+	cdts empty_results(1);
+	div.call(&empty_params, &empty_results, 0);
+	CHECK(static_cast<cdts&>(empty_results[0]).length == 0);
+
+	// columns must match the row count
+	cdts short_params(2);
+	fill_div_columns(short_params, 10);
+	cdts short_results(1);
+	CHECK_THROWS(div.call(&short_params, &short_results, 11));
+}
+
+TEST_CASE("batched calls report the failing row")
+{
+	// Math.toIntExact throws ArithmeticException on the row that overflows an int
+	BatchEntity to_int("class=java.lang.Math,callable=toIntExact",
+		{plugin_type(metaffi_int64_type)},
+		{plugin_type(metaffi_int32_type)});
+
+	std::vector<int64_t> inputs = {1, 2, INT64_C(1) << 40, 4};
+	cdts params(1);
+	params[0].set_new_array(inputs.size(), 1, metaffi_int64_type);
+	cdts& column = static_cast<cdts&>(params[0]);
+	for(size_t i = 0; i < inputs.size(); i++)
+	{
+		column[i] = static_cast<metaffi_int64>(inputs[i]);
+	}
+
+	cdts results(1);
+	try
+	{
+		to_int.call(&params, &results, inputs.size());
+		FAIL("expected the batch to fail");
+	}
+	catch(const std::exception& e)
+	{
+		CHECK(std::string(e.what()).find("row 2") != std::string::npos);
+	}
+}
+
+TEST_CASE("benchmark: batched vs individual calls" * doctest::skip())
+{
+	auto& env = jvm_test_env();
+	constexpr size_t rows = 100000;
+
+	auto div = env.guest_module.load_entity(
+		"class=guest.CoreFunctions,callable=divIntegers",
+		{metaffi_int64_type, metaffi_int64_type},
+		{metaffi_float64_type});
+	BatchEntity div_batch("class=guest.CoreFunctions,callable=divIntegers",
+		{plugin_type(metaffi_int64_type), plugin_type(metaffi_int64_type)},
+		{plugin_type(metaffi_float64_type)});
+
+	auto start = std::chrono::steady_clock::now();
+	double sum = 0;
+	for(size_t i = 0; i < rows; i++)
+	{
+		auto [ratio] = div.call<double>(static_cast<int64_t>(i), static_cast<int64_t>(4));
+		sum += ratio;
+	}
+	auto individual = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	cdts params(2);
+	fill_div_columns(params, rows);
+	cdts results(1);
+	div_batch.call(&params, &results, rows);
+	auto batched = std::chrono::steady_clock::now() - start;
+
+	double batch_sum = 0;
+	cdts& column = static_cast<cdts&>(results[0]);
+	for(size_t i = 0; i < rows; i++)
+	{
+		batch_sum += column[i].cdt_val.float64_val;
+	}
+	CHECK(batch_sum == doctest::Approx(sum));
+
+	using ms = std::chrono::duration<double, std::milli>;
+	MESSAGE("divIntegers x " << rows << ": individual " << ms(individual).count() << " ms, batched " << ms(batched).count() << " ms");
+}
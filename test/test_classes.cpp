@@ -249,3 +249,41 @@ TEST_CASE("static state and submodule")
 	auto [echo] = sub_echo.call<std::string>(std::string("ok"));
 	CHECK(echo == "ok");
 }
+
+TEST_CASE("class names resolve once and remember missing candidates")
+{
+	auto& env = jvm_test_env();
+
+	auto make_inner = env.guest_module.load_entity_with_info(
+		"class=guest.NestedTypes,callable=makeInner",
+		{make_type(metaffi_int32_type)},
+		{make_alias_type(metaffi_handle_type, "guest.NestedTypes$Inner")});
+	auto [inner_ptr] = make_inner.call<cdt_metaffi_handle*>(5);
+	JvmHandle inner_handle(inner_ptr);
+
+	// the dotted spelling of guest.NestedTypes$Inner resolves to the nested class
+	auto dotted = env.guest_module.load_entity_with_info(
+		"class=guest.NestedTypes.Inner,callable=getValue,instance_required",
+		{make_alias_type(metaffi_handle_type, "guest.NestedTypes.Inner")},
+		{make_type(metaffi_int32_type)});
+	auto [dotted_val] = dotted.call<int32_t>(*inner_handle.get());
+	CHECK(dotted_val == 5);
+
+	// the classes are known now: a new entity over them loads nothing
+	uint64_t misses = jvm_runtime_counter("class_cache_misses");
+	uint64_t hits = jvm_runtime_counter("class_cache_hits");
+	auto nested = env.guest_module.load_entity_with_info(
+		"class=guest.NestedTypes$Inner,callable=getValue,instance_required",
+		{make_alias_type(metaffi_handle_type, "guest.NestedTypes.Inner")},
+		{make_type(metaffi_int32_type)});
+	CHECK(jvm_runtime_counter("class_cache_misses") == misses);
+	CHECK(jvm_runtime_counter("class_cache_hits") - hits >= 2);
+
+	// a missing class is looked up once; its candidates are skipped after that
+	CHECK_THROWS(env.guest_module.load_entity("class=guest.NoSuchOuter.Missing,callable=run", {}, {}));
+	misses = jvm_runtime_counter("class_cache_misses");
+	uint64_t negative_hits = jvm_runtime_counter("class_cache_negative_hits");
+	CHECK_THROWS(env.guest_module.load_entity("class=guest.NoSuchOuter.Missing,callable=call", {}, {}));
+	CHECK(jvm_runtime_counter("class_cache_misses") == misses);
+	CHECK(jvm_runtime_counter("class_cache_negative_hits") - negative_hits == 3);
+}
@@ -3,6 +3,7 @@
 #include "jvm_test_env.h"
 #include "jvm_wrappers.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <variant>
@@ -286,3 +287,203 @@ TEST_CASE("enum and optional")
 	auto [present_empty] = is_present.call<bool>(*opt_empty.get());
 	CHECK(!present_empty);
 }
+
+TEST_CASE("string8 round-trips non-ASCII text")
+{
+	auto& env = jvm_test_env();
+
+	// Pattern.quote(s) returns "\Q" + s + "\E" for strings without "\E"
+	auto quote = env.guest_module.load_entity(
+		"class=java.util.regex.Pattern,callable=quote",
+		{metaffi_string8_type},
+		{metaffi_string8_type});
+
+	std::string long_ascii(1000, 'x');
+	std::vector<std::string> inputs = {
+		"",
+		"plain ascii",
+		"h\xC3\xA9llo w\xC3\xB6rld",                 // 2-byte sequences
+		"\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E",      // 3-byte sequences
+		"smile \xF0\x9F\x98\x80 and \xF0\x9D\x84\x9E", // supplementary characters (surrogate pairs)
+		long_ascii + "\xC3\xA9" + long_ascii          // non-ASCII past the vectorized prefix
+	};
+
+	for(const auto& input : inputs)
+	{
+		CAPTURE(input);
+		auto [quoted] = quote.call<std::string>(input);
+		CHECK(quoted == "\\Q" + input + "\\E");
+	}
+
+	// invalid UTF-8 is replaced with U+FFFD
+	auto [replaced] = quote.call<std::string>(std::string("a\xFF" "b"));
+	CHECK(replaced == "\\Qa\xEF\xBF\xBD" "b\\E");
+}
+
+TEST_CASE("String[] values cross JNI in one call")
+{
+	auto& env = jvm_test_env();
+
+	auto join = env.guest_module.load_entity_with_info(
+		"class=guest.CoreFunctions,callable=joinStrings",
+		{make_array_type(metaffi_string8_array_type, 1)},
+		{make_type(metaffi_string8_type)});
+
+	std::vector<std::string> parts;
+	std::string expected;
+	for(int i = 0; i < 10000; i++)
+	{
+		parts.push_back(i % 100 == 0 ? "\xC3\xA9" "\xF0\x9F\x98\x80" + std::to_string(i) : std::to_string(i));
+		expected += (i == 0 ? "" : ",") + parts.back();
+	}
+
+	uint64_t before = jvm_runtime_counter("bulk_string_arrays");
+	auto [joined] = join.call<std::string>(parts);
+	CHECK(joined == expected);
+	CHECK(jvm_runtime_counter("bulk_string_arrays") == before + 1);
+
+	// small arrays keep the per-element path
+	std::vector<std::string> few = {"a", "b", "c"};
+	auto [joined_few] = join.call<std::string>(few);
+	CHECK(joined_few == "a,b,c");
+	CHECK(jvm_runtime_counter("bulk_string_arrays") == before + 1);
+
+	auto zone_ids = env.guest_module.load_entity_with_info(
+		"class=java.util.TimeZone,callable=getAvailableIDs",
+		{},
+		{make_array_type(metaffi_string8_array_type, 1)});
+	auto [ids] = zone_ids.call<std::vector<std::string>>();
+	CHECK(ids.size() > 100);
+	CHECK(std::find(ids.begin(), ids.end(), "UTC") != ids.end());
+	CHECK(jvm_runtime_counter("bulk_string_arrays") == before + 2);
+}
+
+TEST_CASE("string cache reuses repeated parameters and results")
+{
+	auto& env = jvm_test_env();
+
+	auto quote = env.guest_module.load_entity(
+		"class=java.util.regex.Pattern,callable=quote",
+		{metaffi_string8_type},
+		{metaffi_string8_type});
+	// System.getProperty returns the same String instance on every call
+	auto get_property = env.guest_module.load_entity(
+		"class=java.lang.System,callable=getProperty",
+		{metaffi_string8_type},
+		{metaffi_string8_type});
+
+	jvm_runtime_option("string_cache_capacity", 64);
+	uint64_t param_hits = jvm_runtime_counter("string_param_cache_hits");
+	uint64_t param_misses = jvm_runtime_counter("string_param_cache_misses");
+	uint64_t result_hits = jvm_runtime_counter("string_result_cache_hits");
+
+	for(int i = 0; i < 5; i++)
+	{
+		auto [quoted] = quote.call<std::string>(std::string("metric.name"));
+		CHECK(quoted == "\\Qmetric.name\\E");
+	}
+	CHECK(jvm_runtime_counter("string_param_cache_misses") - param_misses == 1);
+	CHECK(jvm_runtime_counter("string_param_cache_hits") - param_hits == 4);
+
+	auto [first] = get_property.call<std::string>(std::string("java.version"));
+	for(int i = 0; i < 3; i++)
+	{
+		auto [again] = get_property.call<std::string>(std::string("java.version"));
+		CHECK(again == first);
+	}
+	CHECK(jvm_runtime_counter("string_result_cache_hits") - result_hits == 3);
+
+	// disabled: nothing is looked up
+	jvm_runtime_option("string_cache_capacity", 0);
+	uint64_t hits_off = jvm_runtime_counter("string_param_cache_hits");
+	auto [quoted_off] = quote.call<std::string>(std::string("metric.name"));
+	CHECK(quoted_off == "\\Qmetric.name\\E");
+	CHECK(jvm_runtime_counter("string_param_cache_hits") == hits_off);
+}
+
+TEST_CASE("repeated load_entity calls share one resolved entity")
+{
+	auto& env = jvm_test_env();
+	const std::string path = "class=java.lang.Math,callable=floorMod";
+
+	uint64_t hits = jvm_runtime_counter("entity_cache_hits");
+	uint64_t misses = jvm_runtime_counter("entity_cache_misses");
+
+	auto kept = env.guest_module.load_entity(path,
+		{metaffi_int64_type, metaffi_int64_type},
+		{metaffi_int64_type});
+	CHECK(jvm_runtime_counter("entity_cache_misses") - misses == 1);
+
+	{
+		auto shared = env.guest_module.load_entity(path,
+			{metaffi_int64_type, metaffi_int64_type},
+			{metaffi_int64_type});
+		CHECK(jvm_runtime_counter("entity_cache_hits") - hits == 1);
+
+		// different types are a different entity
+		auto narrow = env.guest_module.load_entity(path,
+			{metaffi_int32_type, metaffi_int32_type},
+			{metaffi_int32_type});
+		CHECK(jvm_runtime_counter("entity_cache_misses") - misses == 2);
+
+		auto [a] = shared.call<int64_t>(int64_t(-7), int64_t(3));
+		auto [b] = narrow.call<int32_t>(int32_t(-7), int32_t(3));
+		CHECK(a == 2);
+		CHECK(b == 2);
+	}
+
+	// releasing one holder leaves the shared entity usable by the other
+	auto [c] = kept.call<int64_t>(int64_t(10), int64_t(4));
+	CHECK(c == 2);
+}
+
+TEST_CASE("load_entities resolves a set of entities in one call")
+{
+	auto& env = jvm_test_env();
+	jvm_runtime_option("load_workers", 2);
+
+	metaffi_type_info int64_type = plugin_type(metaffi_int64_type);
+	metaffi_type_info int64_pair[] = {int64_type, int64_type};
+	metaffi_type_info int32_type = plugin_type(metaffi_int32_type);
+	metaffi_type_info int32_pair[] = {int32_type, int32_type};
+	metaffi_type_info string_type = plugin_type(metaffi_string8_type);
+
+	// enough entries for both threads to take part
+	std::vector<jvm_entity_descriptor> entities;
+	for(int i = 0; i < 20; i++)
+	{
+		entities.push_back({"class=java.lang.Math,callable=addExact", int64_pair, 2, &int64_type, 1});
+		entities.push_back({"class=java.lang.Math,callable=multiplyExact", int32_pair, 2, &int32_type, 1});
+	}
+	entities.push_back({"class=java.lang.System,callable=lineSeparator", nullptr, 0, &string_type, 1});
+	entities.push_back({"class=java.lang.NoSuchClass,callable=run", nullptr, 0, nullptr, 0});
+	entities.push_back({"", nullptr, 0, nullptr, 0});
+
+	uint64_t hits = jvm_runtime_counter("entity_cache_hits");
+	uint64_t misses = jvm_runtime_counter("entity_cache_misses");
+	PluginEntities loaded(env.guest_classpath, entities);
+
+	CHECK(loaded.loaded() == entities.size() - 2);
+	for(size_t i = 0; i < entities.size() - 2; i++)
+	{
+		CHECK(loaded.xcalls()[i] != nullptr);
+		CHECK(loaded.errors()[i].empty());
+	}
+	CHECK(loaded.xcalls()[entities.size() - 2] == nullptr);
+	CHECK(loaded.errors()[entities.size() - 2].find("NoSuchClass") != std::string::npos);
+	CHECK(loaded.xcalls()[entities.size() - 1] == nullptr);
+	CHECK(loaded.errors()[entities.size() - 1] == "Entity path is empty");
+
+	// repeated entries share one resolved entity, whichever thread got to them first
+	uint64_t new_misses = jvm_runtime_counter("entity_cache_misses") - misses;
+	CHECK(new_misses >= 4);
+	CHECK(new_misses <= 7);
+	CHECK(jvm_runtime_counter("entity_cache_hits") - hits + new_misses == entities.size() - 1);
+
+	// and are shared with load_entity afterwards
+	uint64_t hits_before = jvm_runtime_counter("entity_cache_hits");
+	PluginEntity add("class=java.lang.Math,callable=addExact", {int64_type, int64_type}, {int64_type});
+	CHECK(jvm_runtime_counter("entity_cache_hits") - hits_before == 1);
+
+	jvm_runtime_option("load_workers", 0);
+}
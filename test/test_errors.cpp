@@ -1,6 +1,39 @@
 #include <doctest/doctest.h>
 
 #include "jvm_test_env.h"
+#include "jvm_wrappers.h"
+
+#include <runtime/cdt.h>
+#include <runtime/xllr_capi_loader.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+using xcall_timeout_t = void (*)(xcall*, cdts*, cdts*, uint64_t, char**);
+using cancel_calls_t = uint64_t (*)(xcall*);
+
+// runs Thread.sleep(sleep_ms) through jvm_runtime_xcall_timeout; returns the error ("" on success)
+std::string timed_sleep(xcall_timeout_t xcall_timeout, xcall* sleep, int64_t sleep_ms, uint64_t timeout_ms)
+{
+	cdts params(1);
+	params[0] = static_cast<metaffi_int64>(sleep_ms);
+	char* err = nullptr;
+	xcall_timeout(sleep, &params, nullptr, timeout_ms, &err);
+	try
+	{
+		throw_plugin_error(err);
+	}
+	catch(const std::runtime_error& e)
+	{
+		return e.what();
+	}
+	return {};
+}
+}
 
 TEST_CASE("error handling")
 {
@@ -34,3 +67,96 @@ TEST_CASE("error handling")
 		{});
 	CHECK_THROWS(returns_error.call<>());
 }
+
+TEST_CASE("deadlines and cancellation interrupt hung Java calls")
+{
+	auto& env = jvm_test_env();
+	auto xcall_timeout = reinterpret_cast<xcall_timeout_t>(jvm_plugin_symbol("jvm_runtime_xcall_timeout"));
+	auto cancel_calls = reinterpret_cast<cancel_calls_t>(jvm_plugin_symbol("jvm_runtime_cancel_calls"));
+	REQUIRE(xcall_timeout != nullptr);
+	REQUIRE(cancel_calls != nullptr);
+
+	uint64_t timed_out_before = jvm_runtime_counter("calls_timed_out");
+	uint64_t cancelled_before = jvm_runtime_counter("calls_cancelled");
+
+	// entity deadline: Thread.sleep is interrupted instead of blocking for 30s
+	auto sleep_bounded = env.guest_module.load_entity(
+		"class=java.lang.Thread,callable=sleep,timeout_ms=100",
+		{metaffi_int64_type},
+		{});
+	auto start = std::chrono::steady_clock::now();
+	CHECK_THROWS(sleep_bounded.call<>(static_cast<int64_t>(30000)));
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+	CHECK_NOTHROW(sleep_bounded.call<>(static_cast<int64_t>(1)));
+
+	// per-call deadline, on an entity without one
+	PluginEntity sleep("class=java.lang.Thread,callable=sleep",
+		{plugin_type(metaffi_int64_type)},
+		{});
+	CHECK(timed_sleep(xcall_timeout, sleep.get(), 30000, 100).find("deadline") != std::string::npos);
+	CHECK(timed_sleep(xcall_timeout, sleep.get(), 1, 5000).empty());
+	CHECK(jvm_runtime_counter("calls_timed_out") - timed_out_before == 2);
+
+	// cancellation from another thread
+	PluginEntity sleep_cancellable("class=java.lang.Thread,callable=sleep,cancellable",
+		{plugin_type(metaffi_int64_type)},
+		{});
+	std::string cancelled_error;
+	std::string next_error;
+	std::thread sleeper([&]()
+	{
+		cancelled_error = timed_sleep(xcall_timeout, sleep_cancellable.get(), 30000, 0);
+		// the interrupt does not leak into the thread's next call
+		next_error = timed_sleep(xcall_timeout, sleep_cancellable.get(), 1, 0);
+	});
+	uint64_t cancelled = 0;
+	for(int i = 0; i < 500 && cancelled == 0; i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		cancelled = cancel_calls(sleep_cancellable.get());
+	}
+	sleeper.join();
+	CHECK(cancelled == 1);
+	CHECK(cancelled_error.find("cancelled") != std::string::npos);
+	CHECK(next_error.empty());
+	CHECK(jvm_runtime_counter("calls_cancelled") - cancelled_before == 1);
+}
+
+TEST_CASE("direct calls reject arguments of the wrong class")
+{
+	auto& env = jvm_test_env();
+
+	auto list_type = make_alias_type(metaffi_handle_type, "java.util.List");
+	auto new_list = env.guest_module.load_entity_with_info(
+		"class=java.util.ArrayList,callable=<init>",
+		{},
+		{make_alias_type(metaffi_handle_type, "java.util.ArrayList")});
+	auto new_crc = env.guest_module.load_entity_with_info(
+		"class=java.util.zip.CRC32,callable=<init>",
+		{},
+		{make_alias_type(metaffi_handle_type, "java.util.zip.CRC32")});
+	auto unmodifiable = env.guest_module.load_entity_with_info(
+		"class=java.util.Collections,callable=unmodifiableList",
+		{list_type},
+		{list_type});
+	auto list_size = env.guest_module.load_entity_with_info(
+		"class=java.util.List,callable=size,instance_required",
+		{list_type},
+		{make_type(metaffi_int32_type)});
+
+	auto [list_ptr] = new_list.call<cdt_metaffi_handle*>();
+	JvmHandle list(list_ptr);
+	auto [crc_ptr] = new_crc.call<cdt_metaffi_handle*>();
+	JvmHandle crc(crc_ptr);
+
+	auto [view_ptr] = unmodifiable.call<cdt_metaffi_handle*>(*list.get());
+	JvmHandle view(view_ptr);
+	CHECK(java_class_name(view).find("Unmodifiable") != std::string::npos);
+
+	// a CRC32 is not a List; JNI would take it without complaint
+	CHECK_THROWS(unmodifiable.call<cdt_metaffi_handle*>(*crc.get()));
+	CHECK_THROWS(list_size.call<int32_t>(*crc.get()));
+
+	auto [size] = list_size.call<int32_t>(*view.get());
+	CHECK(size == 0);
+}
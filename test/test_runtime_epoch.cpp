@@ -0,0 +1,78 @@
+#include <doctest/doctest.h>
+
+#include <jvm_runtime_epoch.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// The epoch is compiled into the test binary, so these tests drive their own copy of its
+// state rather than the plugin's.
+TEST_CASE("runtime epoch: calls enter only while the runtime is live")
+{
+	{
+		runtime_call_scope before_publish;
+		CHECK_FALSE(before_publish);
+	}
+
+	publish_runtime();
+	{
+		CHECK_FALSE(in_runtime_call());
+		runtime_call_scope outer;
+		REQUIRE(outer);
+		runtime_call_scope nested;
+		CHECK(nested);
+		CHECK(in_runtime_call());
+
+		// a call cannot wait for itself to drain
+		CHECK_FALSE(withdraw_runtime());
+	}
+
+	CHECK_FALSE(in_runtime_call());
+	CHECK(withdraw_runtime());
+	{
+		runtime_call_scope after_withdraw;
+		CHECK_FALSE(after_withdraw);
+
+		// work handed off by a caller that already entered is not refused
+		runtime_call_scope on_behalf(runtime_call_scope::on_behalf);
+		CHECK(on_behalf);
+	}
+	publish_runtime();
+}
+
+TEST_CASE("runtime epoch: withdraw waits for calls in flight")
+{
+	publish_runtime();
+	uint64_t waits_before = get_runtime_drain_wait_count();
+
+	std::atomic<bool> entered{false};
+	std::atomic<bool> left{false};
+	std::thread caller([&]()
+	{
+		runtime_call_scope scope;
+		entered = static_cast<bool>(scope);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		left = true;
+	});
+	while(!entered)
+	{
+		std::this_thread::yield();
+	}
+
+	CHECK(withdraw_runtime());
+	CHECK(left.load());
+	caller.join();
+	CHECK(get_runtime_drain_wait_count() - waits_before == 1);
+
+	// threads that never called are not waited for, and calls after withdraw fail fast
+	bool late_entered = true;
+	std::thread late([&]()
+	{
+		runtime_call_scope scope;
+		late_entered = static_cast<bool>(scope);
+	});
+	late.join();
+	CHECK_FALSE(late_entered);
+	publish_runtime();
+}
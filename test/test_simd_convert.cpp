@@ -0,0 +1,127 @@
+#include <doctest/doctest.h>
+
+#include <simd_convert.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+// covers empty input, every tail length of the widest kernel and a long run
+const std::vector<size_t> lengths = []()
+{
+	std::vector<size_t> result;
+	for(size_t n = 0; n <= 70; ++n)
+	{
+		result.push_back(n);
+	}
+	result.push_back(1000);
+	result.push_back(4099);
+	return result;
+}();
+
+template<typename T>
+std::vector<T> random_values(size_t count, std::mt19937_64& rng)
+{
+	std::vector<T> values(count);
+	for(auto& v : values)
+	{
+		v = static_cast<T>(rng());
+	}
+	return values;
+}
+
+template<typename Src, typename Dst>
+void check_kernel(void (*kernel)(const Src*, Dst*, size_t), void (*reference)(const Src*, Dst*, size_t), std::mt19937_64& rng)
+{
+	for(size_t n : lengths)
+	{
+		CAPTURE(n);
+		auto src = random_values<Src>(n, rng);
+		// sentinel past the end catches kernels that write beyond count
+		std::vector<Dst> expected(n + 1, Dst(0x5A));
+		std::vector<Dst> actual(n + 1, Dst(0x5A));
+		reference(src.data(), expected.data(), n);
+		kernel(src.data(), actual.data(), n);
+		CHECK(actual == expected);
+	}
+}
+}
+
+TEST_CASE("SIMD conversion kernels match the scalar path")
+{
+	const conversion_kernels& scalar = conversion_kernels_for(simd_level::scalar);
+	std::mt19937_64 rng(20240611);
+
+	for(simd_level level : {simd_level::sse2, simd_level::avx2})
+	{
+		if(level > detect_simd_level())
+		{
+			continue;
+		}
+		CAPTURE(static_cast<int>(level));
+
+		const conversion_kernels& kernels = conversion_kernels_for(level);
+		check_kernel(kernels.widen_u8_to_i16, scalar.widen_u8_to_i16, rng);
+		check_kernel(kernels.widen_u16_to_i32, scalar.widen_u16_to_i32, rng);
+		check_kernel(kernels.widen_u32_to_i64, scalar.widen_u32_to_i64, rng);
+		check_kernel(kernels.narrow_i16_to_u8, scalar.narrow_i16_to_u8, rng);
+		check_kernel(kernels.narrow_i32_to_u16, scalar.narrow_i32_to_u16, rng);
+		check_kernel(kernels.narrow_i64_to_u32, scalar.narrow_i64_to_u32, rng);
+		check_kernel(kernels.normalize_bools, scalar.normalize_bools, rng);
+
+		for(size_t n : lengths)
+		{
+			CAPTURE(n);
+			// ASCII text with at most one non-ASCII element, at every position
+			std::vector<uint8_t> bytes(n, 'a');
+			std::vector<uint16_t> units(n, 'a');
+			CHECK(kernels.ascii_prefix_u8(bytes.data(), n) == n);
+			CHECK(kernels.ascii_prefix_u16(units.data(), n) == n);
+			for(size_t pos = 0; pos < n; pos += (n > 100 ? 97 : 1))
+			{
+				bytes[pos] = 0x80;
+				units[pos] = 0x100;
+				CHECK(kernels.ascii_prefix_u8(bytes.data(), n) == pos);
+				CHECK(kernels.ascii_prefix_u16(units.data(), n) == pos);
+				units[pos] = 0x80;
+				CHECK(kernels.ascii_prefix_u16(units.data(), n) == pos);
+				bytes[pos] = 'a';
+				units[pos] = 'a';
+			}
+		}
+	}
+}
+
+TEST_CASE("scalar conversion kernels widen unsigned and truncate when narrowing")
+{
+	const conversion_kernels& scalar = conversion_kernels_for(simd_level::scalar);
+
+	const uint8_t u8[] = {0, 1, 127, 128, 255};
+	int16_t i16[5] = {};
+	scalar.widen_u8_to_i16(u8, i16, 5);
+	CHECK(i16[3] == 128);
+	CHECK(i16[4] == 255);
+
+	const uint32_t u32[] = {0xFFFFFFFFu};
+	int64_t i64[1] = {};
+	scalar.widen_u32_to_i64(u32, i64, 1);
+	CHECK(i64[0] == 4294967295LL);
+
+	const int32_t wide[] = {0x1FFFF, -1};
+	uint16_t narrow[2] = {};
+	scalar.narrow_i32_to_u16(wide, narrow, 2);
+	CHECK(narrow[0] == 0xFFFF);
+	CHECK(narrow[1] == 0xFFFF);
+
+	const uint8_t bools[] = {0, 1, 2, 255};
+	uint8_t normalized[4] = {};
+	scalar.normalize_bools(bools, normalized, 4);
+	CHECK(normalized[0] == 0);
+	CHECK(normalized[1] == 1);
+	CHECK(normalized[2] == 1);
+	CHECK(normalized[3] == 1);
+
+	CHECK(&get_conversion_kernels() == &conversion_kernels_for(detect_simd_level()));
+}
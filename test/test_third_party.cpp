@@ -3,6 +3,9 @@
 #include "jvm_test_env.h"
 #include "jvm_wrappers.h"
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -23,6 +26,248 @@ std::string build_classpath(const std::string& left, const std::string& right)
 	result += right;
 	return result;
 }
+
+std::vector<std::string> split(const std::string& text, const std::string& separator)
+{
+	std::vector<std::string> parts;
+	size_t begin = 0;
+	for(size_t end = text.find(separator); end != std::string::npos; end = text.find(separator, begin))
+	{
+		parts.push_back(text.substr(begin, end - begin));
+		begin = end + separator.size();
+	}
+	parts.push_back(text.substr(begin));
+	return parts;
+}
+
+// "[a, b, c]" (AbstractCollection/Arrays.toString) -> {"a", "b", "c"}
+std::vector<std::string> split_list_string(const std::string& text)
+{
+	if(text.size() <= 2)
+	{
+		return {};
+	}
+	return split(text.substr(1, text.size() - 2), ", ");
+}
+
+std::string find_classpath_entry(const std::string& classpath, const std::string& part)
+{
+	for(const auto& entry : split(classpath, std::string(1, jvm_classpath_separator())))
+	{
+		if(entry.find(part) != std::string::npos)
+		{
+			return entry;
+		}
+	}
+	return {};
+}
+
+// Entity descriptors for the public methods of a jar, with the storage they point into.
+struct jar_entities
+{
+	std::deque<std::string> strings; // entity paths and aliases
+	std::deque<std::vector<metaffi_type_info>> types;
+	std::vector<jvm_entity_descriptor> descriptors;
+
+	char* keep(const std::string& text)
+	{
+		return strings.emplace_back(text).data();
+	}
+
+	// a Java type name as Method.toString prints it: int, java.lang.String[], a.b.C$D
+	metaffi_type_info type_of(const std::string& name)
+	{
+		std::string base = name;
+		int64_t dims = 0;
+		while(base.size() > 2 && base.compare(base.size() - 2, 2, "[]") == 0)
+		{
+			base.resize(base.size() - 2);
+			dims++;
+		}
+
+		metaffi_type type = metaffi_handle_type;
+		if(base == "boolean") type = metaffi_bool_type;
+		else if(base == "byte") type = metaffi_int8_type;
+		else if(base == "short") type = metaffi_int16_type;
+		else if(base == "int") type = metaffi_int32_type;
+		else if(base == "long") type = metaffi_int64_type;
+		else if(base == "float") type = metaffi_float32_type;
+		else if(base == "double") type = metaffi_float64_type;
+		else if(base == "char") type = metaffi_char16_type;
+		else if(base == "java.lang.String") type = metaffi_string8_type;
+
+		if(type == metaffi_handle_type)
+		{
+			// object arrays stay handles; the alias carries the dimensions
+			return metaffi_type_info{metaffi_handle_type, keep(name), false, 0};
+		}
+		if(dims > 0)
+		{
+			return metaffi_type_info{type | metaffi_array_type, nullptr, false, dims};
+		}
+		return plugin_type(type);
+	}
+
+	// one line of Method.toString: "public static int a.b.C.m(int,java.lang.String) throws E"
+	void add_method(const std::string& class_name, const std::string& method)
+	{
+		size_t open = method.find('(');
+		size_t close = method.find(')', open);
+		if(open == std::string::npos || close == std::string::npos)
+		{
+			return;
+		}
+
+		std::vector<std::string> head = split(method.substr(0, open), " ");
+		if(head.size() < 2)
+		{
+			return;
+		}
+		const std::string& qualified = head.back();
+		size_t dot = qualified.rfind('.');
+		if(dot == std::string::npos || qualified.substr(0, dot) != class_name)
+		{
+			return; // inherited
+		}
+		std::string name = qualified.substr(dot + 1);
+		const std::string& ret = head[head.size() - 2];
+		bool is_static = false;
+		for(const auto& word : head)
+		{
+			is_static = is_static || word == "static";
+		}
+
+		auto& params = types.emplace_back();
+		if(!is_static)
+		{
+			params.push_back(metaffi_type_info{metaffi_handle_type, keep(class_name), false, 0});
+		}
+		std::string param_list = method.substr(open + 1, close - open - 1);
+		if(!param_list.empty())
+		{
+			for(const auto& param : split(param_list, ","))
+			{
+				params.push_back(type_of(param));
+			}
+		}
+		if(params.size() > 127)
+		{
+			return;
+		}
+
+		auto& retvals = types.emplace_back();
+		if(ret != "void")
+		{
+			retvals.push_back(type_of(ret));
+		}
+
+		std::string path = "class=" + class_name + ",callable=" + name + (is_static ? "" : ",instance_required");
+		descriptors.push_back({keep(path),
+			params.empty() ? nullptr : params.data(), static_cast<int8_t>(params.size()),
+			retvals.empty() ? nullptr : retvals.data(), static_cast<int8_t>(retvals.size())});
+	}
+};
+
+// Lists the public methods declared by the classes of jar through reflection in the JVM.
+void collect_jar_entities(metaffi::api::MetaFFIModule& module, const std::string& jar, jar_entities& out)
+{
+	auto open_jar = module.load_entity_with_info(
+		"class=java.util.jar.JarFile,callable=<init>",
+		{make_type(metaffi_string8_type)},
+		{make_alias_type(metaffi_handle_type, "java.util.jar.JarFile")});
+	auto entries = module.load_entity_with_info(
+		"class=java.util.jar.JarFile,callable=entries,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.util.jar.JarFile")},
+		{make_alias_type(metaffi_handle_type, "java.util.Enumeration")});
+	auto to_list = module.load_entity_with_info(
+		"class=java.util.Collections,callable=list",
+		{make_alias_type(metaffi_handle_type, "java.util.Enumeration")},
+		{make_alias_type(metaffi_handle_type, "java.util.ArrayList")});
+	auto list_string = module.load_entity_with_info(
+		"class=java.util.AbstractCollection,callable=toString,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.util.AbstractCollection")},
+		{make_type(metaffi_string8_type)});
+	auto close_jar = module.load_entity_with_info(
+		"class=java.util.zip.ZipFile,callable=close,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.util.zip.ZipFile")},
+		{});
+	auto get_logger = module.load_entity_with_info(
+		"class=org.apache.logging.log4j.LogManager,callable=getLogger",
+		{make_type(metaffi_string8_type)},
+		{make_alias_type(metaffi_handle_type, "org.apache.logging.log4j.Logger")});
+	auto get_class = module.load_entity_with_info(
+		"class=java.lang.Object,callable=getClass,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.lang.Object")},
+		{make_alias_type(metaffi_handle_type, "java.lang.Class")});
+	auto get_loader = module.load_entity_with_info(
+		"class=java.lang.Class,callable=getClassLoader,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.lang.Class")},
+		{make_alias_type(metaffi_handle_type, "java.lang.ClassLoader")});
+	auto for_name = module.load_entity_with_info(
+		"class=java.lang.Class,callable=forName",
+		{make_type(metaffi_string8_type), make_type(metaffi_bool_type), make_alias_type(metaffi_handle_type, "java.lang.ClassLoader")},
+		{make_alias_type(metaffi_handle_type, "java.lang.Class")});
+	auto get_methods = module.load_entity_with_info(
+		"class=java.lang.Class,callable=getMethods,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.lang.Class")},
+		{make_alias_type(metaffi_handle_type, "java.lang.Object[]")});
+	auto array_string = module.load_entity_with_info(
+		"class=java.util.Arrays,callable=toString",
+		{make_alias_type(metaffi_handle_type, "java.lang.Object[]")},
+		{make_type(metaffi_string8_type)});
+
+	auto [jar_ptr] = open_jar.call<cdt_metaffi_handle*>(jar);
+	JvmHandle jar_handle(jar_ptr);
+	auto [entries_ptr] = entries.call<cdt_metaffi_handle*>(*jar_handle.get());
+	JvmHandle entries_handle(entries_ptr);
+	auto [list_ptr] = to_list.call<cdt_metaffi_handle*>(*entries_handle.get());
+	JvmHandle list_handle(list_ptr);
+	auto [names] = list_string.call<std::string>(*list_handle.get());
+	close_jar.call<>(*jar_handle.get());
+
+	// the loader of the module's classes: the one that loaded log4j-core's Logger implementation
+	auto [logger_ptr] = get_logger.call<cdt_metaffi_handle*>(std::string("MetaFFI"));
+	JvmHandle logger_handle(logger_ptr);
+	auto [logger_cls_ptr] = get_class.call<cdt_metaffi_handle*>(*logger_handle.get());
+	JvmHandle logger_cls_handle(logger_cls_ptr);
+	auto [loader_ptr] = get_loader.call<cdt_metaffi_handle*>(*logger_cls_handle.get());
+	JvmHandle loader_handle(loader_ptr);
+
+	for(const auto& entry : split_list_string(names))
+	{
+		const std::string suffix = ".class";
+		if(entry.size() <= suffix.size() || entry.compare(entry.size() - suffix.size(), suffix.size(), suffix) != 0 ||
+			entry.find('-') != std::string::npos || entry.rfind("META-INF/", 0) == 0)
+		{
+			continue; // module-info, package-info, multi-release copies
+		}
+		std::string class_name = entry.substr(0, entry.size() - suffix.size());
+		for(char& c : class_name)
+		{
+			if(c == '/')
+			{
+				c = '.';
+			}
+		}
+
+		try
+		{
+			auto [cls_ptr] = for_name.call<cdt_metaffi_handle*>(class_name, false, *loader_handle.get());
+			JvmHandle cls_handle(cls_ptr);
+			auto [methods_ptr] = get_methods.call<cdt_metaffi_handle*>(*cls_handle.get());
+			JvmHandle methods_handle(methods_ptr);
+			auto [methods] = array_string.call<std::string>(*methods_handle.get());
+			for(const auto& method : split_list_string(methods))
+			{
+				out.add_method(class_name, method);
+			}
+		}
+		catch(const std::exception&)
+		{
+			// classes whose optional dependencies are absent do not link; they have no entities
+		}
+	}
+}
 }
 
 TEST_CASE("third party jars")
@@ -75,3 +320,164 @@ TEST_CASE("third party jars")
 	auto [blank] = is_blank.call<bool>(*string_handle.get());
 	CHECK(blank);
 }
+
+TEST_CASE("benchmark: bulk vs serial loading of a jar's public methods" * doctest::skip())
+{
+	auto& env = jvm_test_env();
+
+	std::string third_party = require_env("METAFFI_JVM_THIRD_PARTY_CLASSPATH");
+	std::string jar = find_classpath_entry(third_party, "log4j-core");
+	REQUIRE_MESSAGE(!jar.empty(), "log4j-core is not on METAFFI_JVM_THIRD_PARTY_CLASSPATH");
+	std::string classpath = build_classpath(env.guest_classpath, third_party);
+	metaffi::api::MetaFFIModule third_party_module(env.runtime.runtime_plugin(), classpath);
+
+	jar_entities entities;
+	collect_jar_entities(third_party_module, jar, entities);
+	REQUIRE(!entities.descriptors.empty());
+
+	// Both runs resolve every entity: they load under different module paths, so the entity
+	// cache does not carry over. The class cache does, in favour of the serial run after it.
+	auto start = std::chrono::steady_clock::now();
+	uint64_t bulk_loaded = 0;
+	{
+		PluginEntities bulk(classpath, entities.descriptors);
+		bulk_loaded = bulk.loaded();
+	}
+	auto bulk_time = std::chrono::steady_clock::now() - start;
+
+	using load_entity_t = xcall* (*)(const char*, const char*, metaffi_type_info*, int8_t, metaffi_type_info*, int8_t, char**);
+	using free_xcall_t = void (*)(xcall*, char**);
+	auto load = reinterpret_cast<load_entity_t>(jvm_plugin_symbol("load_entity"));
+	auto free_entity = reinterpret_cast<free_xcall_t>(jvm_plugin_symbol("free_xcall"));
+	REQUIRE(load);
+	REQUIRE(free_entity);
+
+	// the same classes under another module path string
+	std::string serial_classpath = build_classpath(classpath, jar);
+	std::vector<xcall*> serial;
+	serial.reserve(entities.descriptors.size());
+	start = std::chrono::steady_clock::now();
+	for(const auto& entity : entities.descriptors)
+	{
+		char* err = nullptr;
+		xcall* pxcall = load(serial_classpath.c_str(), entity.entity_path, entity.params_types, entity.params_count, entity.retvals_types, entity.retval_count, &err);
+		if(err)
+		{
+			xllr_free_string(err);
+		}
+		if(pxcall)
+		{
+			serial.push_back(pxcall);
+		}
+	}
+	auto serial_time = std::chrono::steady_clock::now() - start;
+
+	CHECK(serial.size() == bulk_loaded);
+	for(xcall* pxcall : serial)
+	{
+		char* err = nullptr;
+		free_entity(pxcall, &err);
+		if(err)
+		{
+			xllr_free_string(err);
+		}
+	}
+
+	using ms = std::chrono::duration<double, std::milli>;
+	MESSAGE(jar << ": " << entities.descriptors.size() << " public methods, " << bulk_loaded << " loadable; bulk "
+		<< ms(bulk_time).count() << " ms, serial " << ms(serial_time).count() << " ms");
+}
+
+TEST_CASE("typed field access")
+{
+	auto& env = jvm_test_env();
+
+	std::string classpath = build_classpath(env.guest_classpath, require_env("METAFFI_JVM_THIRD_PARTY_CLASSPATH"));
+	metaffi::api::MetaFFIModule third_party_module(env.runtime.runtime_plugin(), classpath);
+
+	// primitive instance field
+	auto mutable_int_type = make_alias_type(metaffi_handle_type, "org.apache.commons.lang3.mutable.MutableInt");
+	auto new_mutable_int = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableInt,callable=<init>",
+		{make_type(metaffi_int32_type)},
+		{mutable_int_type});
+	auto get_int = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableInt,field=value,getter,instance_required",
+		{mutable_int_type},
+		{make_type(metaffi_int32_type)});
+	auto set_int = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableInt,field=value,setter,instance_required",
+		{mutable_int_type, make_type(metaffi_int32_type)},
+		{});
+	auto int_value = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableInt,callable=intValue,instance_required",
+		{mutable_int_type},
+		{make_type(metaffi_int32_type)});
+
+	auto [mutable_int_ptr] = new_mutable_int.call<cdt_metaffi_handle*>(41);
+	JvmHandle mutable_int(mutable_int_ptr);
+	auto [initial] = get_int.call<int32_t>(*mutable_int.get());
+	CHECK(initial == 41);
+	CHECK_NOTHROW(set_int.call<>(*mutable_int.get(), 42));
+	auto [updated] = int_value.call<int32_t>(*mutable_int.get());
+	CHECK(updated == 42);
+
+	// static object fields
+	auto style_type = make_alias_type(metaffi_handle_type, "org.apache.commons.lang3.builder.ToStringStyle");
+	auto json_style = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.builder.ToStringStyle,field=JSON_STYLE,getter",
+		{},
+		{style_type});
+	auto get_default_style = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.builder.ToStringBuilder,field=defaultStyle,getter",
+		{},
+		{style_type});
+	auto set_default_style = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.builder.ToStringBuilder,field=defaultStyle,setter",
+		{style_type},
+		{});
+	auto set_default_style_string = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.builder.ToStringBuilder,field=defaultStyle,setter",
+		{make_type(metaffi_string8_type)},
+		{});
+
+	auto [original_ptr] = get_default_style.call<cdt_metaffi_handle*>();
+	JvmHandle original(original_ptr);
+	auto [json_ptr] = json_style.call<cdt_metaffi_handle*>();
+	JvmHandle json(json_ptr);
+
+	CHECK_NOTHROW(set_default_style.call<>(*json.get()));
+	auto [current_ptr] = get_default_style.call<cdt_metaffi_handle*>();
+	JvmHandle current(current_ptr);
+	CHECK(java_class_name(current) == java_class_name(json));
+
+	// values of the wrong class are refused instead of being stored in the field
+	CHECK_THROWS(set_default_style.call<>(*mutable_int.get()));
+	CHECK_THROWS(set_default_style_string.call<>(std::string("not a style")));
+	auto [unchanged_ptr] = get_default_style.call<cdt_metaffi_handle*>();
+	JvmHandle unchanged(unchanged_ptr);
+	CHECK(java_class_name(unchanged) == java_class_name(json));
+
+	CHECK_NOTHROW(set_default_style.call<>(*original.get()));
+
+	// an Object field takes any value
+	auto mutable_object_type = make_alias_type(metaffi_handle_type, "org.apache.commons.lang3.mutable.MutableObject");
+	auto new_mutable_object = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableObject,callable=<init>",
+		{},
+		{mutable_object_type});
+	auto set_object = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableObject,field=value,setter,instance_required",
+		{mutable_object_type, make_type(metaffi_string8_type)},
+		{});
+	auto get_object = third_party_module.load_entity_with_info(
+		"class=org.apache.commons.lang3.mutable.MutableObject,field=value,getter,instance_required",
+		{mutable_object_type},
+		{make_type(metaffi_string8_type)});
+
+	auto [mutable_object_ptr] = new_mutable_object.call<cdt_metaffi_handle*>();
+	JvmHandle mutable_object(mutable_object_ptr);
+	CHECK_NOTHROW(set_object.call<>(*mutable_object.get(), std::string("value")));
+	auto [object_value] = get_object.call<std::string>(*mutable_object.get());
+	CHECK(object_value == "value");
+}
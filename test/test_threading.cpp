@@ -0,0 +1,349 @@
+#include <doctest/doctest.h>
+
+#include "jvm_test_env.h"
+#include "jvm_wrappers.h"
+
+#include <runtime/cdt.h>
+#include <runtime/xllr_capi_loader.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using xcall_async_t = bool (*)(xcall*, cdts*, cdts*, void (*)(void*, char*), void*, char**);
+
+// completes a std::promise with the call's error message ("" on success)
+void complete_promise(void* user_data, char* err)
+{
+	std::string msg;
+	if(err)
+	{
+		msg = err;
+		xllr_free_string(err);
+	}
+	static_cast<std::promise<std::string>*>(user_data)->set_value(msg);
+}
+}
+
+TEST_CASE("host threads attach to the JVM once")
+{
+	auto& env = jvm_test_env();
+
+	auto div = env.guest_module.load_entity(
+		"class=guest.CoreFunctions,callable=divIntegers",
+		{metaffi_int64_type, metaffi_int64_type},
+		{metaffi_float64_type});
+
+	uint64_t attaches_before = jvm_runtime_counter("thread_attaches");
+	uint64_t detaches_before = jvm_runtime_counter("thread_detaches");
+
+	constexpr int thread_count = 4;
+	constexpr int calls_per_thread = 200;
+	std::atomic<int> failures{0};
+
+	std::vector<std::thread> workers;
+	workers.reserve(thread_count);
+	for(int t = 0; t < thread_count; t++)
+	{
+		workers.emplace_back([&]()
+		{
+			try
+			{
+				for(int i = 0; i < calls_per_thread; i++)
+				{
+					auto [ratio] = div.call<double>(6LL, 4LL);
+					if(ratio != 1.5)
+					{
+						failures++;
+					}
+				}
+			}
+			catch(...)
+			{
+				failures++;
+			}
+		});
+	}
+
+	for(auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	CHECK(failures.load() == 0);
+	CHECK(jvm_runtime_counter("thread_attaches") - attaches_before == thread_count);
+	CHECK(jvm_runtime_counter("thread_detaches") - detaches_before == thread_count);
+}
+
+TEST_CASE("actor entities of a module share one dedicated thread")
+{
+	auto& env = jvm_test_env();
+
+	auto current_thread_on_actor = env.guest_module.load_entity_with_info(
+		"class=java.lang.Thread,callable=currentThread,actor",
+		{},
+		{make_alias_type(metaffi_handle_type, "java.lang.Thread")});
+	auto current_thread = env.guest_module.load_entity_with_info(
+		"class=java.lang.Thread,callable=currentThread",
+		{},
+		{make_alias_type(metaffi_handle_type, "java.lang.Thread")});
+	auto thread_id = env.guest_module.load_entity_with_info(
+		"class=java.lang.Thread,callable=getId,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.lang.Thread")},
+		{make_type(metaffi_int64_type)});
+
+	auto id_of = [&](auto& entity)
+	{
+		auto [thread_ptr] = entity.template call<cdt_metaffi_handle*>();
+		JvmHandle thread(thread_ptr);
+		auto [id] = thread_id.call<int64_t>(*thread.get());
+		return id;
+	};
+
+	uint64_t actor_calls_before = jvm_runtime_counter("actor_calls");
+	int64_t caller_id = id_of(current_thread);
+	int64_t actor_id = id_of(current_thread_on_actor);
+	CHECK(actor_id != caller_id);
+
+	constexpr int thread_count = 4;
+	constexpr int calls_per_thread = 50;
+	std::atomic<int> off_actor{0};
+	std::vector<std::thread> callers;
+	for(int t = 0; t < thread_count; t++)
+	{
+		callers.emplace_back([&]()
+		{
+			try
+			{
+				for(int i = 0; i < calls_per_thread; i++)
+				{
+					if(id_of(current_thread_on_actor) != actor_id)
+					{
+						off_actor++;
+					}
+				}
+			}
+			catch(...)
+			{
+				off_actor++;
+			}
+		});
+	}
+	for(auto& caller : callers)
+	{
+		caller.join();
+	}
+
+	CHECK(off_actor.load() == 0);
+	CHECK(jvm_runtime_counter("actor_calls") - actor_calls_before == 1 + thread_count * calls_per_thread);
+}
+
+TEST_CASE("actor calls give up at their deadline while the actor thread is busy")
+{
+	auto& env = jvm_test_env();
+
+	auto sleep_on_actor = env.guest_module.load_entity(
+		"class=java.lang.Thread,callable=sleep,actor",
+		{metaffi_int64_type},
+		{});
+	auto bounded_on_actor = env.guest_module.load_entity_with_info(
+		"class=java.lang.Thread,callable=currentThread,actor,timeout_ms=100",
+		{},
+		{make_alias_type(metaffi_handle_type, "java.lang.Thread")});
+
+	uint64_t timed_out_before = jvm_runtime_counter("calls_timed_out");
+	std::thread busy([&]() { sleep_on_actor.call<>(static_cast<int64_t>(1500)); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	auto start = std::chrono::steady_clock::now();
+	CHECK_THROWS(bounded_on_actor.call<cdt_metaffi_handle*>());
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+	CHECK(jvm_runtime_counter("calls_timed_out") - timed_out_before == 1);
+	busy.join();
+
+	// once the actor is free the call goes through
+	auto [thread_ptr] = bounded_on_actor.call<cdt_metaffi_handle*>();
+	JvmHandle thread(thread_ptr);
+	CHECK(thread.get() != nullptr);
+}
+
+TEST_CASE("asynchronous calls complete on the worker pool")
+{
+	auto xcall_async = reinterpret_cast<xcall_async_t>(jvm_plugin_symbol("jvm_runtime_xcall_async"));
+	REQUIRE(xcall_async != nullptr);
+
+	PluginEntity div("class=guest.CoreFunctions,callable=divIntegers",
+		{plugin_type(metaffi_int64_type), plugin_type(metaffi_int64_type)},
+		{plugin_type(metaffi_float64_type)});
+
+	constexpr int calls = 64;
+	uint64_t submitted_before = jvm_runtime_counter("async_calls");
+
+	std::vector<std::unique_ptr<cdts>> params;
+	std::vector<std::unique_ptr<cdts>> rets;
+	std::vector<std::promise<std::string>> done(calls);
+	std::vector<std::future<std::string>> results;
+	for(int i = 0; i < calls; i++)
+	{
+		params.push_back(std::make_unique<cdts>(2));
+		(*params.back())[0] = static_cast<metaffi_int64>(i);
+		(*params.back())[1] = static_cast<metaffi_int64>(4);
+		rets.push_back(std::make_unique<cdts>(1));
+		results.push_back(done[i].get_future());
+
+		char* err = nullptr;
+		bool queued = xcall_async(div.get(), params.back().get(), rets.back().get(), complete_promise, &done[i], &err);
+		throw_plugin_error(err);
+		REQUIRE(queued);
+	}
+
+	for(int i = 0; i < calls; i++)
+	{
+		CHECK(results[i].get().empty());
+		CHECK((*rets[i])[0].cdt_val.float64_val == doctest::Approx(i / 4.0));
+	}
+	CHECK(jvm_runtime_counter("async_calls") - submitted_before == calls);
+
+	// a queued call keeps its entity alive when the host frees the xcall before the call ends
+	cdts freed_params(1);
+	freed_params[0] = static_cast<metaffi_int64>(200);
+	std::promise<std::string> freed_done;
+	auto freed_result = freed_done.get_future();
+	{
+		PluginEntity freed("class=guest.CoreFunctions,callable=waitABit",
+			{plugin_type(metaffi_int64_type)},
+			{});
+		char* err = nullptr;
+		REQUIRE(xcall_async(freed.get(), &freed_params, nullptr, complete_promise, &freed_done, &err));
+		throw_plugin_error(err);
+	}
+	CHECK(freed_result.get().empty());
+
+	// a slow Java call does not block the submitting thread
+	PluginEntity wait("class=guest.CoreFunctions,callable=waitABit",
+		{plugin_type(metaffi_int64_type)},
+		{});
+	cdts wait_params(1);
+	wait_params[0] = static_cast<metaffi_int64>(500);
+	std::promise<std::string> wait_done;
+	auto wait_result = wait_done.get_future();
+
+	auto start = std::chrono::steady_clock::now();
+	char* err = nullptr;
+	REQUIRE(xcall_async(wait.get(), &wait_params, nullptr, complete_promise, &wait_done, &err));
+	throw_plugin_error(err);
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250));
+	CHECK(wait_result.get().empty());
+}
+
+TEST_CASE("Java futures complete host callbacks without a waiting thread")
+{
+	auto& env = jvm_test_env();
+	auto xcall_future = reinterpret_cast<xcall_async_t>(jvm_plugin_symbol("jvm_runtime_xcall_future"));
+	REQUIRE(xcall_future != nullptr);
+
+	// the alias marks the Java return type; the metaffi type is the completed value's
+	auto future_of = [](metaffi_type type)
+	{
+		return metaffi_type_info{type, const_cast<char*>("java.util.concurrent.CompletableFuture"), false, 0};
+	};
+	uint64_t bridged_before = jvm_runtime_counter("futures_bridged");
+	uint64_t completed_before = jvm_runtime_counter("futures_completed");
+
+	// an already completed stage completes the callback before xcall_future returns
+	PluginEntity completed("class=java.util.concurrent.CompletableFuture,callable=completedFuture",
+		{plugin_type(metaffi_any_type)},
+		{future_of(metaffi_int64_type)});
+	cdts completed_params(1);
+	completed_params[0] = static_cast<metaffi_int64>(42);
+	cdts completed_ret(1);
+	std::promise<std::string> completed_done;
+	auto completed_result = completed_done.get_future();
+	char* err = nullptr;
+	REQUIRE(xcall_future(completed.get(), &completed_params, &completed_ret, complete_promise, &completed_done, &err));
+	throw_plugin_error(err);
+	REQUIRE(completed_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+	CHECK(completed_result.get().empty());
+	CHECK(completed_ret[0].cdt_val.int64_val == 42);
+
+	// a pending stage completes the callback on the thread that completes it
+	auto create = env.guest_module.load_entity_with_info(
+		"class=java.util.concurrent.CompletableFuture,callable=<init>",
+		{},
+		{make_alias_type(metaffi_handle_type, "java.util.concurrent.CompletableFuture")});
+	auto complete = env.guest_module.load_entity_with_info(
+		"class=java.util.concurrent.CompletableFuture,callable=complete,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.util.concurrent.CompletableFuture"), make_type(metaffi_any_type)},
+		{make_type(metaffi_bool_type)});
+	PluginEntity stage("class=java.util.concurrent.CompletableFuture,callable=toCompletableFuture,instance_required",
+		{metaffi_type_info{metaffi_handle_type, const_cast<char*>("java.util.concurrent.CompletableFuture"), false, 0}},
+		{future_of(metaffi_string8_type)});
+
+	auto [pending_ptr] = create.call<cdt_metaffi_handle*>();
+	JvmHandle pending(pending_ptr);
+	cdts stage_params(1);
+	stage_params[0].set_handle(pending.get());
+	cdts stage_ret(1);
+	std::promise<std::string> stage_done;
+	auto stage_result = stage_done.get_future();
+	REQUIRE(xcall_future(stage.get(), &stage_params, &stage_ret, complete_promise, &stage_done, &err));
+	throw_plugin_error(err);
+	CHECK(stage_result.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+
+	bool accepted = false;
+	std::thread completer([&]()
+	{
+		auto [ok] = complete.call<bool>(*pending.get(), std::string("done"));
+		accepted = ok;
+	});
+	completer.join();
+	CHECK(accepted);
+	REQUIRE(stage_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+	CHECK(stage_result.get().empty());
+	CHECK(take_string8(stage_ret[0].cdt_val.string8_val) == "done");
+	stage_ret[0].free_required = false;
+
+	// a failed stage reports its cause
+	auto [failing_ptr] = create.call<cdt_metaffi_handle*>();
+	JvmHandle failing(failing_ptr);
+	auto make_error = env.guest_module.load_entity_with_info(
+		"class=java.lang.IllegalStateException,callable=<init>",
+		{make_type(metaffi_string8_type)},
+		{make_alias_type(metaffi_handle_type, "java.lang.IllegalStateException")});
+	auto fail = env.guest_module.load_entity_with_info(
+		"class=java.util.concurrent.CompletableFuture,callable=completeExceptionally,instance_required",
+		{make_alias_type(metaffi_handle_type, "java.util.concurrent.CompletableFuture"), make_alias_type(metaffi_handle_type, "java.lang.Throwable")},
+		{make_type(metaffi_bool_type)});
+	cdts failing_params(1);
+	failing_params[0].set_handle(failing.get());
+	cdts failing_ret(1);
+	std::promise<std::string> failing_done;
+	auto failing_result = failing_done.get_future();
+	REQUIRE(xcall_future(stage.get(), &failing_params, &failing_ret, complete_promise, &failing_done, &err));
+	throw_plugin_error(err);
+
+	auto [error_ptr] = make_error.call<cdt_metaffi_handle*>(std::string("connection reset"));
+	JvmHandle error(error_ptr);
+	auto [failed] = fail.call<bool>(*failing.get(), *error.get());
+	CHECK(failed);
+	std::string failure = failing_result.get();
+	CHECK(failure.find("IllegalStateException") != std::string::npos);
+	CHECK(failure.find("connection reset") != std::string::npos);
+
+	CHECK(jvm_runtime_counter("futures_bridged") - bridged_before == 3);
+	CHECK(jvm_runtime_counter("futures_completed") - completed_before == 3);
+
+	// the synchronous xcall refuses to hand back a future as its completed value
+	auto sync_stage = env.guest_module.load_entity_with_info(
+		"class=java.util.concurrent.CompletableFuture,callable=completedFuture",
+		{make_type(metaffi_any_type)},
+		{make_alias_type(metaffi_string8_type, "java.util.concurrent.CompletableFuture")});
+	CHECK_THROWS(sync_stage.call<std::string>(std::string("x")));
+}